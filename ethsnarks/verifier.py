@@ -196,17 +196,127 @@ class VerifyingKey(BaseVerifier, _VerifyingKeyStruct):
             (neg(self.alpha), self.beta))
 
 
+class _NativeVerifyingKey(object):
+    """The verifying key loaded into the native library, processed once"""
+    def __init__(self, vk_json, native_library_path):
+        lib = ctypes.cdll.LoadLibrary(native_library_path)
+
+        lib.ethsnarks_vk_load.argtypes = [ctypes.c_char_p]
+        lib.ethsnarks_vk_load.restype = ctypes.c_void_p
+        lib.ethsnarks_vk_free.argtypes = [ctypes.c_void_p]
+        lib.ethsnarks_vk_free.restype = None
+        lib.ethsnarks_verify_with.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        lib.ethsnarks_verify_with.restype = ctypes.c_bool
+        lib.ethsnarks_verify_batch_with.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t]
+        lib.ethsnarks_verify_batch_with.restype = ctypes.c_bool
+
+        self._lib = lib
+        self._handle = lib.ethsnarks_vk_load(vk_json.encode('ascii'))
+        if not self._handle:
+            raise ValueError("Native library rejected the verifying key")
+
+    def __del__(self):
+        if getattr(self, '_handle', None):
+            self._lib.ethsnarks_vk_free(self._handle)
+            self._handle = None
+
+    def verify(self, proof_json):
+        return self._lib.ethsnarks_verify_with(self._handle, proof_json.encode('ascii'))
+
+    def verify_batch(self, proofs_json):
+        proofs_cstr = (ctypes.c_char_p * len(proofs_json))(*[_.encode('ascii') for _ in proofs_json])
+        return self._lib.ethsnarks_verify_batch_with(self._handle, proofs_cstr, len(proofs_json))
+
+
 class NativeVerifier(VerifyingKey):
+    def _native_key(self, native_library_path):
+        """The key loaded into the library at `native_library_path`, kept for later calls"""
+        native_keys = self.__dict__.setdefault('_native_keys', dict())
+        if native_library_path not in native_keys:
+            native_keys[native_library_path] = _NativeVerifyingKey(self.to_json(), native_library_path)
+        return native_keys[native_library_path]
+
     def verify(self, proof, native_library_path):
         if not isinstance(proof, Proof):
             raise TypeError("Invalid proof type")
 
-        vk_cstr = ctypes.c_char_p(self.to_json().encode('ascii'))
-        proof_cstr = ctypes.c_char_p(proof.to_json().encode('ascii'))
+        return self._native_key(native_library_path).verify(proof.to_json())
+
+    def verify_batch(self, proofs, native_library_path):
+        """Verify many proofs for this key at once, True only if all of them are valid"""
+        for proof in proofs:
+            if not isinstance(proof, Proof):
+                raise TypeError("Invalid proof type")
+
+        return self._native_key(native_library_path).verify_batch([proof.to_json() for proof in proofs])
+
 
+class NativeVerifyPool(object):
+    """
+    Verifies batches of proofs on native worker threads, outside of the GIL.
+
+    Jobs are submitted with submit(), and their results, one bool per proof,
+    collected with poll() or wait().
+
+    Creating a pool disables libff's profiling output for the whole process,
+    as it isn't thread safe.
+    """
+    def __init__(self, native_library_path, num_workers=1, max_queue=1024):
         lib = ctypes.cdll.LoadLibrary(native_library_path)
-        lib_verify = lib.ethsnarks_verify
-        lib_verify.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
-        lib_verify.restype = ctypes.c_bool
 
-        return lib_verify(vk_cstr, proof_cstr)
+        lib.ethsnarks_verify_pool_create.argtypes = [ctypes.c_size_t, ctypes.c_size_t]
+        lib.ethsnarks_verify_pool_create.restype = ctypes.c_void_p
+        lib.ethsnarks_verify_pool_free.argtypes = [ctypes.c_void_p]
+        lib.ethsnarks_verify_pool_free.restype = None
+        lib.ethsnarks_verify_pool_add_key.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p]
+        lib.ethsnarks_verify_pool_add_key.restype = ctypes.c_bool
+        lib.ethsnarks_verify_pool_submit.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t, ctypes.c_void_p, ctypes.c_void_p]
+        lib.ethsnarks_verify_pool_submit.restype = ctypes.c_uint64
+        for name in ['ethsnarks_verify_pool_poll', 'ethsnarks_verify_pool_wait']:
+            getattr(lib, name).argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.POINTER(ctypes.c_uint8)]
+            getattr(lib, name).restype = ctypes.c_int
+
+        self._lib = lib
+        self._pool = lib.ethsnarks_verify_pool_create(num_workers, max_queue)
+        if not self._pool:
+            raise RuntimeError("Cannot create native verification pool")
+        # Number of proofs of each job not yet collected
+        self._jobs = dict()
+
+    def __del__(self):
+        if getattr(self, '_pool', None):
+            self._lib.ethsnarks_verify_pool_free(self._pool)
+            self._pool = None
+
+    def add_key(self, name, vk):
+        if not isinstance(vk, VerifyingKey):
+            raise TypeError("Invalid verifying key type")
+        if not self._lib.ethsnarks_verify_pool_add_key(self._pool, name.encode('ascii'), vk.to_json().encode('ascii')):
+            raise ValueError("Native library rejected the verifying key")
+
+    def submit(self, key_name, proofs):
+        """Queue the proofs for the key added as `key_name`, returns the job id"""
+        for proof in proofs:
+            if not isinstance(proof, Proof):
+                raise TypeError("Invalid proof type")
+
+        proofs_cstr = (ctypes.c_char_p * len(proofs))(*[proof.to_json().encode('ascii') for proof in proofs])
+        job_id = self._lib.ethsnarks_verify_pool_submit(self._pool, key_name.encode('ascii'), proofs_cstr, len(proofs), None, None)
+        if job_id == 0:
+            raise RuntimeError("Cannot submit verification job")
+        self._jobs[job_id] = len(proofs)
+        return job_id
+
+    def _collect(self, func, job_id):
+        results = (ctypes.c_uint8 * max(1, self._jobs[job_id]))()
+        if not func(self._pool, job_id, results):
+            return None
+        return [bool(_) for _ in results[:self._jobs.pop(job_id)]]
+
+    def poll(self, job_id):
+        """The results of the job, or None if it hasn't finished"""
+        return self._collect(self._lib.ethsnarks_verify_pool_poll, job_id)
+
+    def wait(self, job_id):
+        """The results of the job, waiting for it to finish"""
+        return self._collect(self._lib.ethsnarks_verify_pool_wait, job_id)
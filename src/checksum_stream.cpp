@@ -0,0 +1,182 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <algorithm>
+#include <cstring>
+
+#include "checksum_stream.hpp"
+
+namespace ethsnarks {
+
+
+sha256_ostreambuf::sha256_ostreambuf( std::streambuf *sink, size_t buffer_size ) :
+    m_sink(sink),
+    m_buffer(std::max<size_t>(1, buffer_size)),
+    m_size(0)
+{
+    SHA256_Init(&m_ctx);
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+}
+
+
+sha256_ostreambuf::~sha256_ostreambuf()
+{
+    flush_buffer();
+}
+
+
+bool sha256_ostreambuf::flush_buffer()
+{
+    const std::streamsize n = pptr() - pbase();
+    if( n == 0 ) {
+        return true;
+    }
+
+    SHA256_Update(&m_ctx, pbase(), n);
+    m_size += n;
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+
+    return m_sink->sputn(m_buffer.data(), n) == n;
+}
+
+
+sha256_ostreambuf::int_type sha256_ostreambuf::overflow( int_type ch )
+{
+    if( ! flush_buffer() ) {
+        return traits_type::eof();
+    }
+
+    if( ! traits_type::eq_int_type(ch, traits_type::eof()) )
+    {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+
+int sha256_ostreambuf::sync()
+{
+    if( ! flush_buffer() ) {
+        return -1;
+    }
+
+    return m_sink->pubsync();
+}
+
+
+bool sha256_ostreambuf::digest( uint8_t out_digest[SHA256_DIGEST_LENGTH] )
+{
+    const bool ok = (sync() == 0);
+
+    // Finalise a copy, so writing may continue
+    SHA256_CTX ctx = m_ctx;
+    SHA256_Final(out_digest, &ctx);
+
+    return ok;
+}
+
+
+uint64_t sha256_ostreambuf::size() const
+{
+    return m_size + (pptr() - pbase());
+}
+
+
+sha256_istreambuf::sha256_istreambuf( std::streambuf *source, uint64_t limit, size_t buffer_size ) :
+    m_source(source),
+    m_buffer(std::max<size_t>(1, buffer_size)),
+    m_remaining(limit)
+{
+    SHA256_Init(&m_ctx);
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+}
+
+
+sha256_istreambuf::int_type sha256_istreambuf::underflow()
+{
+    if( gptr() < egptr() ) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    const std::streamsize wanted = std::min<uint64_t>(m_remaining, m_buffer.size());
+    if( wanted == 0 ) {
+        return traits_type::eof();
+    }
+
+    const std::streamsize n = m_source->sgetn(m_buffer.data(), wanted);
+    if( n <= 0 ) {
+        return traits_type::eof();
+    }
+
+    SHA256_Update(&m_ctx, m_buffer.data(), n);
+    m_remaining -= n;
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + n);
+
+    return traits_type::to_int_type(*gptr());
+}
+
+
+bool sha256_istreambuf::digest( uint8_t out_digest[SHA256_DIGEST_LENGTH] )
+{
+    // Hash the rest of the payload, e.g. trailing whitespace not consumed by the parser
+    while( ! traits_type::eq_int_type(underflow(), traits_type::eof()) ) {
+        setg(m_buffer.data(), egptr(), egptr());
+    }
+
+    SHA256_CTX ctx = m_ctx;
+    SHA256_Final(out_digest, &ctx);
+
+    return m_remaining == 0;
+}
+
+
+void write_checksum_footer( std::ostream &out, uint64_t payload_size, const uint8_t digest[SHA256_DIGEST_LENGTH] )
+{
+    uint8_t size_bytes[8];
+    for( size_t i = 0; i < 8; i++ ) {
+        size_bytes[i] = (payload_size >> (8 * i)) & 0xFF;
+    }
+
+    out.write(CHECKSUM_FOOTER_MAGIC, sizeof(CHECKSUM_FOOTER_MAGIC));
+    out.write(reinterpret_cast<const char*>(size_bytes), sizeof(size_bytes));
+    out.write(reinterpret_cast<const char*>(digest), SHA256_DIGEST_LENGTH);
+}
+
+
+bool read_checksum_footer( std::istream &in, uint64_t &out_payload_size, uint8_t out_digest[SHA256_DIGEST_LENGTH] )
+{
+    in.seekg(0, std::ios::end);
+    const std::streamoff file_size = in.tellg();
+
+    bool found = false;
+    if( file_size >= std::streamoff(CHECKSUM_FOOTER_SIZE) )
+    {
+        char footer[CHECKSUM_FOOTER_SIZE];
+        in.seekg(file_size - std::streamoff(CHECKSUM_FOOTER_SIZE));
+        if( in.read(footer, sizeof(footer)) && 0 == ::memcmp(footer, CHECKSUM_FOOTER_MAGIC, sizeof(CHECKSUM_FOOTER_MAGIC)) )
+        {
+            uint64_t payload_size = 0;
+            for( size_t i = 0; i < 8; i++ ) {
+                payload_size |= uint64_t(uint8_t(footer[sizeof(CHECKSUM_FOOTER_MAGIC) + i])) << (8 * i);
+            }
+
+            if( payload_size == uint64_t(file_size) - CHECKSUM_FOOTER_SIZE )
+            {
+                out_payload_size = payload_size;
+                ::memcpy(out_digest, footer + sizeof(CHECKSUM_FOOTER_MAGIC) + 8, SHA256_DIGEST_LENGTH);
+                found = true;
+            }
+        }
+    }
+
+    in.clear();
+    in.seekg(0);
+
+    return found;
+}
+
+
+// namespace ethsnarks
+}
@@ -0,0 +1,91 @@
+#ifndef ETHSNARKS_CHECKSUM_STREAM_HPP_
+#define ETHSNARKS_CHECKSUM_STREAM_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include "crypto/sha256.h"
+
+namespace ethsnarks {
+
+
+/** Default size of the buffers between the serializers and the file */
+const size_t CHECKSUM_STREAM_BUFFER_SIZE = 1 << 20;
+
+/** Footer appended by writeToFile: magic, little-endian payload size, SHA256 of the payload */
+const char CHECKSUM_FOOTER_MAGIC[8] = {'e', 't', 'h', 's', 'n', 's', 'u', 'm'};
+const size_t CHECKSUM_FOOTER_SIZE = sizeof(CHECKSUM_FOOTER_MAGIC) + 8 + SHA256_DIGEST_LENGTH;
+
+
+/**
+* Output stream buffer which passes everything on to `sink` through a
+* fixed-size buffer, hashing it with SHA256 on the way.
+*/
+class sha256_ostreambuf : public std::streambuf
+{
+public:
+    sha256_ostreambuf( std::streambuf *sink, size_t buffer_size = CHECKSUM_STREAM_BUFFER_SIZE );
+
+    ~sha256_ostreambuf();
+
+    /** Flush, then return the digest of everything written */
+    bool digest( uint8_t out_digest[SHA256_DIGEST_LENGTH] );
+
+    /** Number of bytes written so far */
+    uint64_t size() const;
+
+protected:
+    int_type overflow( int_type ch ) override;
+
+    int sync() override;
+
+private:
+    bool flush_buffer();
+
+    std::streambuf *m_sink;
+    std::vector<char> m_buffer;
+    SHA256_CTX m_ctx;
+    uint64_t m_size;
+};
+
+
+/**
+* Input stream buffer which reads at most `limit` bytes from `source` through
+* a fixed-size buffer, hashing them with SHA256 on the way.
+*/
+class sha256_istreambuf : public std::streambuf
+{
+public:
+    sha256_istreambuf( std::streambuf *source, uint64_t limit, size_t buffer_size = CHECKSUM_STREAM_BUFFER_SIZE );
+
+    /** Read and hash whatever the parser left unread, then return the digest */
+    bool digest( uint8_t out_digest[SHA256_DIGEST_LENGTH] );
+
+protected:
+    int_type underflow() override;
+
+private:
+    std::streambuf *m_source;
+    std::vector<char> m_buffer;
+    SHA256_CTX m_ctx;
+    uint64_t m_remaining;
+};
+
+
+/** Append the footer for a payload of `payload_size` bytes */
+void write_checksum_footer( std::ostream &out, uint64_t payload_size, const uint8_t digest[SHA256_DIGEST_LENGTH] );
+
+/**
+* Look for a footer at the end of `in`, then rewind it.
+* Returns false if there is none, e.g. for files written before footers were added.
+*/
+bool read_checksum_footer( std::istream &in, uint64_t &out_payload_size, uint8_t out_digest[SHA256_DIGEST_LENGTH] );
+
+
+// namespace ethsnarks
+}
+
+#endif
@@ -26,7 +26,9 @@ typedef libsnark::gadget<ethsnarks::FieldT> GadgetT;
 
 typedef libsnark::r1cs_gg_ppzksnark_zok_proof<ppT> ProofT;
 typedef libsnark::r1cs_gg_ppzksnark_zok_proving_key<ppT> ProvingKeyT;
+typedef libsnark::r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> ExpandedProvingKeyT;
 typedef libsnark::r1cs_gg_ppzksnark_zok_verification_key<ppT> VerificationKeyT;
+typedef libsnark::r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> ProcessedVerificationKeyT;
 typedef libsnark::r1cs_gg_ppzksnark_zok_primary_input<ppT> PrimaryInputT;
 typedef libsnark::r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> AuxiliaryInputT;
 
@@ -12,17 +12,28 @@
 namespace ethsnarks {
 
 
+/**
+* Lowercase hex without leading zeros, as mpz_get_str gives, but read
+* directly from the limbs
+*/
 std::string HexStringFromBigint(libff::bigint<libff::alt_bn128_r_limbs> _x){
-    mpz_t value;
-    ::mpz_init(value);
+    static const char hex_digits[] = "0123456789abcdef";
 
-    _x.to_mpz(value);
-    char *value_out_hex = mpz_get_str(nullptr, 16, value);
+    std::string str;
+    str.reserve(libff::alt_bn128_r_limbs * GMP_NUMB_BITS / 4);
 
-    std::string str(value_out_hex);
+    for( size_t nibble = libff::alt_bn128_r_limbs * GMP_NUMB_BITS / 4; nibble-- > 0; )
+    {
+        const size_t bit = nibble * 4;
+        const unsigned digit = (_x.data[bit / GMP_NUMB_BITS] >> (bit % GMP_NUMB_BITS)) & 0xF;
+        if( digit != 0 || ! str.empty() ) {
+            str.push_back(hex_digits[digit]);
+        }
+    }
 
-    ::mpz_clear(value);
-    ::free(value_out_hex);
+    if( str.empty() ) {
+        str.push_back('0');
+    }
 
     return str;
 }
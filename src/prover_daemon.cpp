@@ -0,0 +1,269 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+/**
+* Long-running prover, keeps the proving keys resident and accepts requests
+* on a Unix domain socket.
+*
+* Each request is one line of JSON, as handled by prover_service::handle_request,
+* and is answered with one line of JSON holding the proof or an error.
+*/
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <nlohmann/json.hpp>
+
+#include "prover_service.hpp"
+
+using std::cerr;
+using std::endl;
+using std::string;
+using ethsnarks::prover_service;
+
+
+static volatile sig_atomic_t g_stopping = 0;
+
+/* Longest request line accepted, the witness of a large circuit is tens of MB */
+static const size_t max_request_size = 1ul << 28;
+
+
+/**
+* A client connection served on its own thread. The fd is closed once the
+* thread is joined, so shutting it down never hits a reused descriptor.
+*/
+struct connection {
+    int fd;
+    std::thread thread;
+    std::atomic<bool> done;
+
+    explicit connection( int in_fd ) : fd(in_fd), done(false) {}
+};
+
+
+static void handle_signal( int )
+{
+    g_stopping = 1;
+}
+
+
+static bool send_all( int fd, const string &data )
+{
+    size_t sent = 0;
+    while( sent < data.size() )
+    {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+        if( n <= 0 ) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+
+static string error_response( const string &error )
+{
+    return nlohmann::json({{"error", error}}).dump() + "\n";
+}
+
+
+static void serve_requests( prover_service &service, int fd )
+{
+    string pending;
+    char buf[1 << 16];
+
+    while( true )
+    {
+        const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if( n <= 0 ) {
+            return;
+        }
+        pending.append(buf, n);
+
+        size_t eol;
+        while( (eol = pending.find('\n')) != string::npos )
+        {
+            const string request = pending.substr(0, eol);
+            pending.erase(0, eol + 1);
+            if( request.empty() ) {
+                continue;
+            }
+
+            // Proof JSON spans several lines, responses must be one
+            string response;
+            try {
+                response = nlohmann::json::parse(service.handle_request(request)).dump() + "\n";
+            }
+            catch( const std::exception &ex ) {
+                response = error_response(ex.what());
+            }
+            if( ! send_all(fd, response) ) {
+                return;
+            }
+        }
+
+        if( pending.size() > max_request_size ) {
+            send_all(fd, error_response("request too long"));
+            return;
+        }
+    }
+}
+
+
+static void serve_connection( prover_service &service, connection &conn )
+{
+    try {
+        serve_requests(service, conn.fd);
+    }
+    catch( const std::exception &ex ) {
+        cerr << "Error: connection failed: " << ex.what() << endl;
+    }
+    conn.done = true;
+}
+
+
+static void join_connection( connection &conn )
+{
+    conn.thread.join();
+    ::close(conn.fd);
+}
+
+
+int main( int argc, char **argv )
+{
+    if( argc < 3 )
+    {
+        cerr << "Usage: " << argv[0] << " <socket-path> [--workers N] [--queue N] [--threads N] [--numa-node N] [--chunks N] [--batch-affine] <name>=<proving-key> ..." << endl;
+        return 1;
+    }
+
+    const string socket_path(argv[1]);
+    size_t num_workers = 1;
+    size_t max_queue = 64;
+    libsnark::r1cs_gg_ppzksnark_zok_prover_options options;
+    std::vector<std::pair<string, string> > keys;
+
+    for( int i = 2; i < argc; i++ )
+    {
+        const string arg(argv[i]);
+        if( (arg == "--workers" || arg == "--queue") && i + 1 < argc ) {
+            (arg == "--workers" ? num_workers : max_queue) = std::stoul(argv[++i]);
+        }
+        else if( (arg == "--threads" || arg == "--chunks") && i + 1 < argc ) {
+            (arg == "--threads" ? options.num_threads : options.chunks) = std::stoul(argv[++i]);
+        }
+        else if( arg == "--numa-node" && i + 1 < argc ) {
+            options.numa_node = std::stoi(argv[++i]);
+        }
+        else if( arg == "--batch-affine" ) {
+            options.A_query_method = options.B_query_method = options.H_query_method = options.L_query_method =
+                libsnark::r1cs_gg_ppzksnark_zok_multi_exp_pippenger_batch_affine;
+        }
+        else if( arg.find('=') != string::npos ) {
+            keys.emplace_back(arg.substr(0, arg.find('=')), arg.substr(arg.find('=') + 1));
+        }
+        else {
+            cerr << "Error: unknown option " << arg << endl;
+            return 1;
+        }
+    }
+
+    prover_service service(num_workers, max_queue, options);
+    for( const auto &key : keys )
+    {
+        if( ! service.add_key(key.first, key.second.c_str()) ) {
+            cerr << "Error: cannot load " << key.second << endl;
+            return 2;
+        }
+        cerr << "Loaded " << key.first << " from " << key.second << endl;
+    }
+
+    struct sockaddr_un addr;
+    ::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if( socket_path.size() >= sizeof(addr.sun_path) ) {
+        cerr << "Error: socket path too long" << endl;
+        return 3;
+    }
+    ::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socket_path.c_str());
+    if( listen_fd < 0
+     || ::bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0
+     || ::listen(listen_fd, 16) != 0 )
+    {
+        cerr << "Error: cannot listen on " << socket_path << ": " << ::strerror(errno) << endl;
+        return 3;
+    }
+
+    ::signal(SIGPIPE, SIG_IGN);
+    ::signal(SIGINT, handle_signal);
+    ::signal(SIGTERM, handle_signal);
+
+    cerr << "Listening on " << socket_path << " with " << num_workers << " workers" << endl;
+
+    std::list<std::unique_ptr<connection> > connections;
+    while( ! g_stopping )
+    {
+        // reap the connections which have finished
+        for( auto it = connections.begin(); it != connections.end(); )
+        {
+            if( (*it)->done ) {
+                join_connection(**it);
+                it = connections.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        struct pollfd pfd = {listen_fd, POLLIN, 0};
+        if( ::poll(&pfd, 1, 500) <= 0 ) {
+            continue;
+        }
+
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if( fd < 0 ) {
+            continue;
+        }
+
+        std::unique_ptr<connection> conn(new connection(fd));
+        conn->thread = std::thread(serve_connection, std::ref(service), std::ref(*conn));
+        connections.emplace_back(std::move(conn));
+    }
+
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+
+    // wake the connections blocked in recv, those waiting for a proof get it
+    // first, the service must outlive them all
+    for( const auto &conn : connections )
+    {
+        ::shutdown(conn->fd, SHUT_RDWR);
+    }
+    for( const auto &conn : connections )
+    {
+        join_connection(*conn);
+    }
+
+    service.stop();
+
+    return 0;
+}
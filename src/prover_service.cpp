@@ -0,0 +1,254 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include <nlohmann/json.hpp>
+
+#include "prover_service.hpp"
+#include "export.hpp"
+#include "import.hpp"
+#include "stubs.hpp"
+#include "utils.hpp"
+
+#include "r1cs_gg_ppzksnark_zok/flat_proving_key.hpp"
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+#include "r1cs_gg_ppzksnark_zok/prover_metrics.hpp"
+
+using json = nlohmann::json;
+
+namespace ethsnarks {
+
+
+struct prover_service::key_entry {
+    std::string name;
+    std::unique_ptr<ProvingKeyT> pk;
+    std::unique_ptr<libsnark::r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> > mapped_pk;
+    std::unique_ptr<ExpandedProvingKeyT> expanded_pk;
+
+    size_t primary_input_size() const
+    {
+        return pk ? pk->constraint_system.primary_input_size : mapped_pk->constraint_matrices().num_inputs;
+    }
+
+    size_t auxiliary_input_size() const
+    {
+        if( pk ) {
+            return pk->constraint_system.auxiliary_input_size;
+        }
+        const auto &matrices = mapped_pk->constraint_matrices();
+        return matrices.num_variables - matrices.num_inputs;
+    }
+
+    ProofT prove( const PrimaryInputT &primary_input, const AuxiliaryInputT &auxiliary_input, const libsnark::r1cs_gg_ppzksnark_zok_prover_options &options ) const
+    {
+
+        if( pk ) {
+            if( expanded_pk ) {
+                return libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(*pk, *expanded_pk, primary_input, auxiliary_input, options);
+            }
+            return libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(*pk, primary_input, auxiliary_input, options);
+        }
+
+        if( expanded_pk ) {
+            return libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(*mapped_pk, *expanded_pk, primary_input, auxiliary_input, options);
+        }
+        return libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(*mapped_pk, primary_input, auxiliary_input, options);
+    }
+};
+
+
+prover_service::prover_service( size_t num_workers, size_t max_queue, const libsnark::r1cs_gg_ppzksnark_zok_prover_options &options ) :
+    m_max_queue(max_queue),
+    m_options(options),
+    m_stopping(false)
+{
+    stub_init_public_params();
+
+    num_workers = std::max<size_t>(1, num_workers);
+    if( num_workers > 1 )
+    {
+        libff::inhibit_profiling_info = true;
+        libff::inhibit_profiling_counters = true;
+    }
+
+    for( size_t i = 0; i < num_workers; i++ )
+    {
+        m_workers.emplace_back(&prover_service::worker, this);
+    }
+}
+
+
+prover_service::~prover_service()
+{
+    stop();
+}
+
+
+bool prover_service::add_key( const std::string &name, const char *pk_file )
+{
+    std::shared_ptr<key_entry> entry = std::make_shared<key_entry>();
+    entry->name = name;
+
+    // first touch of the key's memory from the proving threads' node
+    const libsnark::parallel_thread_scope thread_scope(m_options.num_threads, m_options.numa_node);
+
+    try {
+        if( libsnark::r1cs_gg_ppzksnark_zok_is_flat_proving_key(pk_file) )
+        {
+            entry->mapped_pk.reset(new libsnark::r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT>());
+            if( ! entry->mapped_pk->open(pk_file) ) {
+                return false;
+            }
+            if( m_options.numa_node >= 0 ) {
+                entry->mapped_pk->prefault(m_options);
+            }
+        }
+        else {
+            entry->pk.reset(new ProvingKeyT(loadFromFile<ProvingKeyT>(pk_file)));
+        }
+
+        const auto expanded_pk_file = stub_expanded_pk_path(pk_file);
+        if( std::ifstream(expanded_pk_file).good() )
+        {
+            entry->expanded_pk.reset(new ExpandedProvingKeyT(loadFromFile<ExpandedProvingKeyT>(expanded_pk_file)));
+
+            const bool matches = entry->pk ? entry->expanded_pk->is_expansion_of(*entry->pk)
+                                           : entry->expanded_pk->is_expansion_of(*entry->mapped_pk);
+            if( ! matches ) {
+                std::cerr << "Error: " << expanded_pk_file << " was not built from proving key " << pk_file << std::endl;
+                return false;
+            }
+        }
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot load proving key " << pk_file << ": " << ex.what() << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_keys[name] = entry;
+
+    return true;
+}
+
+
+bool prover_service::submit( const std::string &key_name, const PrimaryInputT &primary_input, const AuxiliaryInputT &auxiliary_input, std::future<std::string> &out_result, std::string &out_error )
+{
+    std::unique_ptr<job> new_job(new job);
+    new_job->primary_input = primary_input;
+    new_job->auxiliary_input = auxiliary_input;
+    out_result = new_job->result.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto it = m_keys.find(key_name);
+        if( it == m_keys.end() ) {
+            out_error = "unknown key";
+            return false;
+        }
+        new_job->key = it->second;
+
+        if( primary_input.size() != new_job->key->primary_input_size() || auxiliary_input.size() != new_job->key->auxiliary_input_size() ) {
+            out_error = "assignment doesn't match the key";
+            return false;
+        }
+
+        if( m_stopping ) {
+            out_error = "stopping";
+            return false;
+        }
+
+        if( m_queue.size() >= m_max_queue ) {
+            out_error = "queue full";
+            return false;
+        }
+
+        m_queue.emplace_back(std::move(new_job));
+    }
+
+    m_cv.notify_one();
+
+    return true;
+}
+
+
+std::string prover_service::handle_request( const std::string &request_json )
+{
+    std::future<std::string> result;
+    std::string error;
+
+    try {
+        const auto request = json::parse(request_json);
+        const auto key_name = request.at("key").get<std::string>();
+        const auto primary_input = create_F_list(request.at("primary"));
+        const auto auxiliary_input = create_F_list(request.at("auxiliary"));
+
+        if( submit(key_name, primary_input, auxiliary_input, result, error) ) {
+            return result.get();
+        }
+    }
+    catch( const std::exception &ex ) {
+        error = ex.what();
+    }
+
+    return json({{"error", error}}).dump();
+}
+
+
+void prover_service::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+
+    for( auto &thread : m_workers )
+    {
+        if( thread.joinable() ) {
+            thread.join();
+        }
+    }
+}
+
+
+void prover_service::worker()
+{
+    while( true )
+    {
+        std::unique_ptr<job> current;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stopping || ! m_queue.empty(); });
+            if( m_queue.empty() ) {
+                return;
+            }
+            current = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        // when metrics are exported, label them with the key
+        libsnark::r1cs_gg_ppzksnark_zok_prover_options options = m_options;
+        libsnark::prover_metrics metrics;
+        if( ! libsnark::prover_metrics_path().empty() ) {
+            metrics.label = current->key->name;
+            options.metrics = &metrics;
+        }
+
+        try {
+            auto proof = current->key->prove(current->primary_input, current->auxiliary_input, options);
+            current->result.set_value(proof_to_json(proof, current->primary_input));
+        }
+        catch( ... ) {
+            current->result.set_exception(std::current_exception());
+        }
+    }
+}
+
+
+// namespace ethsnarks
+}
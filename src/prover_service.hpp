@@ -0,0 +1,98 @@
+#ifndef ETHSNARKS_PROVER_SERVICE_HPP_
+#define ETHSNARKS_PROVER_SERVICE_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ethsnarks.hpp"
+
+namespace ethsnarks {
+
+
+/**
+* Keeps proving keys resident and proves with them on a pool of worker
+* threads, so requests don't pay for loading the key from disk.
+*
+* Each proof already uses every core through OpenMP, more than one worker
+* only helps when proofs are small or memory bound. With several workers
+* libff's profiling, which isn't thread safe, is disabled.
+*
+* The prover `options` apply to every proof. With a NUMA node set, keys are
+* also loaded from threads pinned to that node, so a service per node keeps
+* both the proving threads and the key in local memory.
+*
+* With ETHSNARKS_PROVER_METRICS set, the metrics of every proof are exported
+* there labelled with the name of its key, see prover_metrics.hpp.
+*/
+class prover_service
+{
+public:
+    prover_service( size_t num_workers = 1, size_t max_queue = 64,
+                    const libsnark::r1cs_gg_ppzksnark_zok_prover_options &options = libsnark::r1cs_gg_ppzksnark_zok_prover_options() );
+
+    ~prover_service();
+
+    prover_service( const prover_service& ) = delete;
+    prover_service& operator=( const prover_service& ) = delete;
+
+    /**
+    * Load the proving key in `pk_file`, in either format, as `name`.
+    * The expanded tables next to it are used when they exist, and the key
+    * is rejected if they were built from another one.
+    */
+    bool add_key( const std::string &name, const char *pk_file );
+
+    /**
+    * Queue a proof with the full assignment of the circuit.
+    * Returns false if the key is unknown, the assignment has the wrong size
+    * or the queue is full. The result is the proof JSON.
+    */
+    bool submit( const std::string &key_name, const PrimaryInputT &primary_input, const AuxiliaryInputT &auxiliary_input, std::future<std::string> &out_result, std::string &out_error );
+
+    /**
+    * Handle a JSON request, waiting for the proof:
+    *
+    *   {"key": "name", "primary": ["0x...", ...], "auxiliary": ["0x...", ...]}
+    *
+    * Returns the proof JSON, or {"error": "..."}
+    */
+    std::string handle_request( const std::string &request_json );
+
+    /** Finish the queued proofs, then stop the workers */
+    void stop();
+
+private:
+    struct key_entry;
+
+    struct job {
+        std::shared_ptr<const key_entry> key;
+        PrimaryInputT primary_input;
+        AuxiliaryInputT auxiliary_input;
+        std::promise<std::string> result;
+    };
+
+    void worker();
+
+    std::map<std::string, std::shared_ptr<const key_entry> > m_keys;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::unique_ptr<job> > m_queue;
+    const size_t m_max_queue;
+    const libsnark::r1cs_gg_ppzksnark_zok_prover_options m_options;
+    bool m_stopping;
+    std::vector<std::thread> m_workers;
+};
+
+
+// namespace ethsnarks
+}
+
+#endif
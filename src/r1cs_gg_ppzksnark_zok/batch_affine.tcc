@@ -0,0 +1,145 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of interfaces for summing many points with affine additions
+ that share one field inversion.
+
+ See batch_affine.hpp .
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef BATCH_AFFINE_TCC_
+#define BATCH_AFFINE_TCC_
+
+#include <type_traits>
+#include <utility>
+
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+
+namespace libsnark {
+
+/* Pairs added per task, each task pays for one inversion */
+const size_t batch_affine_grain = 1ul << 10;
+
+/* Below this many points the tree isn't worth its inversions */
+const size_t batch_affine_min_points = 1ul << 6;
+
+template<typename T>
+T batch_affine_sum(std::vector<T> &&points)
+{
+    typedef typename std::decay<decltype(points[0].X)>::type CoordT;
+    const CoordT coord_one = CoordT::one();
+
+    T acc = T::zero();
+
+    /* Points without affine coordinates are added directly */
+    size_t num_affine = 0;
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        if (points[i].Z == coord_one)
+        {
+            points[num_affine++] = points[i];
+        }
+        else
+        {
+            acc = acc + points[i];
+        }
+    }
+    points.resize(num_affine);
+
+    while (points.size() >= batch_affine_min_points)
+    {
+        const size_t num_pairs = points.size() / 2;
+        const size_t num_tasks = (num_pairs + batch_affine_grain - 1) / batch_affine_grain;
+
+        std::vector<std::vector<T> > task_sums(num_tasks);
+        std::vector<T> task_acc(num_tasks, T::zero());
+
+        parallel_for_ranges(num_pairs, batch_affine_grain, [&](const size_t begin, const size_t end) {
+            const size_t task = begin / batch_affine_grain;
+            std::vector<T> &sums = task_sums[task];
+
+            /* prefix[i] = product of the denominators before pair i */
+            std::vector<CoordT> denominators(end - begin);
+            std::vector<CoordT> prefix(end - begin);
+            CoordT running = coord_one;
+            for (size_t i = begin; i < end; ++i)
+            {
+                const T &p = points[2 * i];
+                const T &q = points[2 * i + 1];
+
+                CoordT d = q.X - p.X;
+                if (d.is_zero())
+                {
+                    /* P == Q or P == -Q, leave it to the generic formulas */
+                    d = coord_one;
+                }
+
+                prefix[i - begin] = running;
+                denominators[i - begin] = d;
+                running = running * d;
+            }
+
+            CoordT inverse = running.inverse();
+            /* slots of colliding pairs are left unset and dropped below */
+            sums.resize(end - begin);
+            for (size_t i = end; i-- > begin; )
+            {
+                const T &p = points[2 * i];
+                const T &q = points[2 * i + 1];
+
+                const CoordT d_inverse = inverse * prefix[i - begin];
+                inverse = inverse * denominators[i - begin];
+
+                if (q.X == p.X)
+                {
+                    task_acc[task] = task_acc[task] + p + q;
+                    continue;
+                }
+
+                const CoordT lambda = (q.Y - p.Y) * d_inverse;
+                T &r = sums[i - begin];
+                r.X = lambda.squared() - p.X - q.X;
+                r.Y = lambda * (p.X - r.X) - p.Y;
+                r.Z = coord_one;
+            }
+        });
+
+        std::vector<T> next;
+        next.reserve(num_pairs + 1);
+        for (size_t task = 0; task < num_tasks; ++task)
+        {
+            const size_t begin = task * batch_affine_grain;
+            for (size_t j = 0; j < task_sums[task].size(); ++j)
+            {
+                const size_t i = begin + j;
+                if (points[2 * i].X != points[2 * i + 1].X)
+                {
+                    next.emplace_back(task_sums[task][j]);
+                }
+            }
+            acc = acc + task_acc[task];
+        }
+
+        if (points.size() % 2 == 1)
+        {
+            next.emplace_back(points.back());
+        }
+
+        points.swap(next);
+    }
+
+    for (const T &p : points)
+    {
+        acc = acc.mixed_add(p);
+    }
+
+    return acc;
+}
+
+} // libsnark
+
+#endif // BATCH_AFFINE_TCC_
@@ -0,0 +1,97 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of interfaces for multi-exponentiation over precomputed
+ fixed-base tables.
+
+ For a window of c bits and W = ceil(bits(Fr) / c) windows, the table holds
+ 2^(w*c) * base_i for every base and every window w. A multi-exponentiation
+ then needs a single set of 2^c - 1 buckets: digit w of scalar_i adds entry
+ (i, w) to the bucket of that digit, and the buckets are reduced once at the
+ end. Compared to multi_exp_pippenger this removes the W - 1 additional
+ bucket reductions and all of the doublings, for W times the memory.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef FIXED_BASE_MULTIEXP_HPP_
+#define FIXED_BASE_MULTIEXP_HPP_
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include <libsnark/knowledge_commitment/knowledge_commitment.hpp>
+
+namespace libsnark {
+
+template<typename T>
+class fixed_base_table;
+
+template<typename T>
+std::ostream& operator<<(std::ostream &out, const fixed_base_table<T> &table);
+
+template<typename T>
+std::istream& operator>>(std::istream &in, fixed_base_table<T> &table);
+
+/**
+ * Multiples 2^(w * window) * base_i of a vector of bases, for w < num_windows.
+ */
+template<typename T>
+class fixed_base_table {
+public:
+    size_t window;
+    size_t num_windows;
+
+    /* multiples[i * num_windows + w] = 2^(w * window) * base_i */
+    std::vector<T> multiples;
+
+    fixed_base_table() : window(0), num_windows(0) {};
+
+    size_t num_bases() const
+    {
+        return num_windows == 0 ? 0 : multiples.size() / num_windows;
+    }
+
+    size_t size_in_bits() const
+    {
+        return multiples.size() * T::size_in_bits();
+    }
+
+    bool operator==(const fixed_base_table<T> &other) const;
+    friend std::ostream& operator<< <T>(std::ostream &out, const fixed_base_table<T> &table);
+    friend std::istream& operator>> <T>(std::istream &in, fixed_base_table<T> &table);
+};
+
+/**
+ * Window size used for a table of `num_bases` bases when none is given:
+ * the Pippenger window size, capped to keep the buckets in cache.
+ */
+inline size_t fixed_base_table_window_size(const size_t num_bases);
+
+/**
+ * Build the table for the bases in [vec_start, vec_end), with scalars of
+ * FieldT. A `window` of 0 selects fixed_base_table_window_size.
+ */
+template<typename T, typename FieldT, typename BaseIterT>
+fixed_base_table<T> fixed_base_table_build(BaseIterT vec_start,
+                                           BaseIterT vec_end,
+                                           const size_t window);
+
+/**
+ * Computes sum_i scalar_i * base_i for the bases of `table`. The scalar range
+ * must hold table.num_bases() elements.
+ */
+template<typename T, typename FieldT, typename ScalarIterT>
+T fixed_base_multi_exp(const fixed_base_table<T> &table,
+                       ScalarIterT scalar_start,
+                       ScalarIterT scalar_end,
+                       const size_t chunks);
+
+} // libsnark
+
+#include "r1cs_gg_ppzksnark_zok/fixed_base_multiexp.tcc"
+
+#endif // FIXED_BASE_MULTIEXP_HPP_
@@ -0,0 +1,220 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of interfaces for multi-exponentiation over precomputed
+ fixed-base tables.
+
+ See fixed_base_multiexp.hpp .
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef FIXED_BASE_MULTIEXP_TCC_
+#define FIXED_BASE_MULTIEXP_TCC_
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+#include <libff/algebra/scalar_multiplication/multiexp.hpp>
+#include <libff/common/serialization.hpp>
+#include <libff/common/utils.hpp>
+
+#include "r1cs_gg_ppzksnark_zok/multiexp_pippenger.hpp"
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+
+namespace libsnark {
+
+/* Bases per task when building a table */
+const size_t fixed_base_build_grain = 1ul << 12;
+
+/* Largest default window, 2^16 buckets per task */
+const size_t fixed_base_max_window = 16;
+
+template<typename T>
+bool fixed_base_table<T>::operator==(const fixed_base_table<T> &other) const
+{
+    return (this->window == other.window &&
+            this->num_windows == other.num_windows &&
+            this->multiples == other.multiples);
+}
+
+template<typename T>
+std::ostream& operator<<(std::ostream &out, const fixed_base_table<T> &table)
+{
+    out << table.window << "\n";
+    out << table.num_windows << "\n";
+    out << table.multiples;
+
+    return out;
+}
+
+template<typename T>
+std::istream& operator>>(std::istream &in, fixed_base_table<T> &table)
+{
+    in >> table.window;
+    libff::consume_newline(in);
+    in >> table.num_windows;
+    libff::consume_newline(in);
+    in >> table.multiples;
+
+    return in;
+}
+
+inline size_t fixed_base_table_window_size(const size_t num_bases)
+{
+    return std::min(pippenger_window_size(num_bases), fixed_base_max_window);
+}
+
+/**
+ * Convert the multiples to special form so that they can be added with
+ * mixed additions.
+ */
+template<typename T>
+void fixed_base_batch_to_special(std::vector<T> &vec)
+{
+    libff::batch_to_special<T>(vec);
+}
+
+template<typename T1, typename T2>
+void fixed_base_batch_to_special(std::vector<knowledge_commitment<T1, T2> > &vec)
+{
+    std::vector<T1> g;
+    std::vector<T2> h;
+    g.reserve(vec.size());
+    h.reserve(vec.size());
+    for (const auto &kc : vec)
+    {
+        g.emplace_back(kc.g);
+        h.emplace_back(kc.h);
+    }
+
+    libff::batch_to_special<T1>(g);
+    libff::batch_to_special<T2>(h);
+
+    for (size_t i = 0; i < vec.size(); ++i)
+    {
+        vec[i] = knowledge_commitment<T1, T2>(g[i], h[i]);
+    }
+}
+
+template<typename T, typename FieldT, typename BaseIterT>
+fixed_base_table<T> fixed_base_table_build(BaseIterT vec_start,
+                                           BaseIterT vec_end,
+                                           const size_t window)
+{
+    const size_t length = std::distance(vec_start, vec_end);
+
+    fixed_base_table<T> table;
+    table.window = (window == 0 ? fixed_base_table_window_size(length) : window);
+    table.num_windows = (FieldT::size_in_bits() + table.window - 1) / table.window;
+    table.multiples.resize(length * table.num_windows);
+
+    parallel_for_ranges(length, fixed_base_build_grain, [&](const size_t begin, const size_t end) {
+        std::vector<T> block;
+        block.reserve((end - begin) * table.num_windows);
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            T multiple = *(vec_start + i);
+            for (size_t w = 0; w < table.num_windows; ++w)
+            {
+                block.emplace_back(multiple);
+                for (size_t j = 0; j < table.window; ++j)
+                {
+                    multiple = multiple.dbl();
+                }
+            }
+        }
+
+#ifdef USE_MIXED_ADDITION
+        /* one inversion per block */
+        fixed_base_batch_to_special(block);
+#endif
+
+        std::copy(block.begin(), block.end(), table.multiples.begin() + begin * table.num_windows);
+    });
+
+    return table;
+}
+
+template<typename T, typename FieldT, typename ScalarIterT>
+T fixed_base_multi_exp(const fixed_base_table<T> &table,
+                       ScalarIterT scalar_start,
+                       ScalarIterT scalar_end,
+                       const size_t chunks)
+{
+    const size_t length = table.num_bases();
+    if (static_cast<size_t>(std::distance(scalar_start, scalar_end)) < length)
+    {
+        throw std::invalid_argument("fewer scalars than bases in the fixed-base table");
+    }
+
+    if (length == 0)
+    {
+        return T::zero();
+    }
+
+    const mp_size_t n = FieldT::num_limbs;
+    const size_t c = table.window;
+    const size_t num_windows = table.num_windows;
+
+    /* every range pays for one bucket reduction, so keep them much larger than the bucket count */
+    const size_t num_ranges = std::max<size_t>(1, std::min(chunks, length >> c));
+    const size_t range_size = (length + num_ranges - 1) / num_ranges;
+
+    std::vector<T> partial(num_ranges, T::zero());
+
+    parallel_for_ranges(num_ranges, 1, [&](const size_t range, const size_t) {
+        const size_t range_start = range * range_size;
+        const size_t range_end = std::min(length, range_start + range_size);
+        if (range_start >= range_end)
+        {
+            return;
+        }
+
+        std::vector<T> buckets((1ul << c) - 1, T::zero());
+
+        for (size_t i = range_start; i < range_end; ++i)
+        {
+            const libff::bigint<n> scalar = (*(scalar_start + i)).as_bigint();
+            if (scalar.is_zero())
+            {
+                continue;
+            }
+
+            const T *multiples = &table.multiples[i * num_windows];
+            for (size_t w = 0; w < num_windows; ++w)
+            {
+                const size_t digit = pippenger_get_digit<n>(scalar, w * c, c);
+                if (digit == 0)
+                {
+                    continue;
+                }
+
+#ifdef USE_MIXED_ADDITION
+                buckets[digit - 1] = buckets[digit - 1].mixed_add(multiples[w]);
+#else
+                buckets[digit - 1] = buckets[digit - 1] + multiples[w];
+#endif
+            }
+        }
+
+        partial[range] = pippenger_bucket_sum<T>(buckets.data(), buckets.size());
+    });
+
+    T result = T::zero();
+    for (const T &p : partial)
+    {
+        result = result + p;
+    }
+
+    return result;
+}
+
+} // libsnark
+
+#endif // FIXED_BASE_MULTIEXP_TCC_
@@ -0,0 +1,276 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of interfaces for a flat binary proving key that can be used
+ in place, straight from a memory mapping.
+
+ Layout (all integers in host byte order):
+
+     header                  flat_proving_key_header
+     section table           num_sections x flat_proving_key_section
+     sections                each aligned to flat_proving_key_alignment
+
+ Point arrays are stored exactly as they are in memory, in Montgomery form,
+ so the prover reads them through pointers into the mapping and pages are
+ faulted in as the multi-exponentiations reach them. The header records the
+ limb size, byte order and point sizes, and a section with the generators
+ of G1 and G2 guards against a different curve or field representation.
+
+ Readers skip sections with ids they don't know, new sections can be added
+ without changing the version.
+
+ The constraint system is stored as three sparse matrices in compressed row
+ form, the row offsets of A, B and C in one section and their (variable
+ index, coefficient) terms in another, so it is loaded without parsing text
+ and independently of the queries. A metadata section records the sizes of
+ the circuit, tools which only inspect a key read the header, section table
+ and metadata without mapping the rest. Keys with a text serialized
+ constraint system, from before the matrices were added, are still read.
+
+ Keys written with `compressed` set store the queries as affine x coordinates
+ only, with the sign of y and the point at infinity flagged in the unused top
+ bits of the last limb. Those sections are decompressed into memory when the
+ key is opened, in parallel, instead of being used from the mapping.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef FLAT_PROVING_KEY_HPP_
+#define FLAT_PROVING_KEY_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "r1cs_gg_ppzksnark_zok/mapped_file.hpp"
+#include "r1cs_gg_ppzksnark_zok/r1cs_gg_ppzksnark_zok.hpp"
+
+namespace libsnark {
+
+/* "ethsnpk" followed by a NUL */
+const char flat_proving_key_magic[8] = {'e', 't', 'h', 's', 'n', 'p', 'k', '\0'};
+
+const uint32_t flat_proving_key_version = 1;
+
+/* Written as-is, reads back differently on a host of the other byte order */
+const uint32_t flat_proving_key_byte_order = 0x01020304;
+
+/* Sections start on page boundaries so point arrays are mapped aligned */
+const uint64_t flat_proving_key_alignment = 4096;
+
+enum flat_proving_key_section_id : uint32_t {
+    /* G1::one() then G2::one() */
+    flat_section_generators = 1,
+    /* alpha_g1, beta_g1, delta_g1 then beta_g2, delta_g2 */
+    flat_section_key_points = 2,
+    /* B_query.domain_size() */
+    flat_section_parameters = 3,
+    flat_section_A_query = 4,
+    flat_section_B_query_indices = 5,
+    flat_section_B_query_values = 6,
+    flat_section_H_query = 7,
+    flat_section_L_query = 8,
+    /* the constraint system, in libsnark's stream serialization, superseded by the matrices */
+    flat_section_constraint_system = 9,
+    /* compressed counterparts of the query sections */
+    flat_section_A_query_compressed = 10,
+    flat_section_B_query_values_compressed = 11,
+    flat_section_H_query_compressed = 12,
+    flat_section_L_query_compressed = 13,
+    /* flat_proving_key_metadata */
+    flat_section_metadata = 14,
+    /* 3 x (num_constraints + 1) offsets into the terms, for A, B then C */
+    flat_section_constraint_rows = 15,
+    /* uint64_t variable index followed by the coefficient, in Montgomery form */
+    flat_section_constraint_terms = 16
+};
+
+struct flat_proving_key_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    uint32_t limb_bits;
+    uint32_t byte_order;
+    uint32_t G1_size;
+    uint32_t G2_size;
+    uint64_t section_table_offset;
+};
+
+struct flat_proving_key_section {
+    uint32_t id;
+    uint32_t element_size;
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct flat_proving_key_metadata {
+    uint64_t primary_input_size;
+    uint64_t auxiliary_input_size;
+    uint64_t num_constraints;
+    uint64_t A_query_size;
+    uint64_t B_query_size;
+    uint64_t H_query_size;
+    uint64_t L_query_size;
+    uint64_t compressed;
+};
+
+/**
+ * What can be learned about a key from its header, without mapping it.
+ */
+struct flat_proving_key_info {
+    flat_proving_key_header header;
+    std::vector<flat_proving_key_section> sections;
+    flat_proving_key_metadata metadata;
+};
+
+/**
+ * Read-only view of an array inside a mapping.
+ */
+template<typename T>
+class mapped_array {
+public:
+    typedef const T *const_iterator;
+
+    mapped_array() : data_(nullptr), size_(0) {};
+    mapped_array(const T *data, const size_t size) : data_(data), size_(size) {};
+
+    const T *begin() const { return data_; }
+    const T *end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    const T &operator[](const size_t i) const { return data_[i]; }
+
+private:
+    const T *data_;
+    size_t size_;
+};
+
+/**
+ * Mapped counterpart of knowledge_commitment_vector.
+ */
+template<typename T1, typename T2>
+class mapped_knowledge_commitment_vector {
+public:
+    mapped_array<uint64_t> indices;
+    mapped_array<knowledge_commitment<T1, T2> > values;
+    size_t domain_size_;
+
+    mapped_knowledge_commitment_vector() : domain_size_(0) {};
+
+    size_t size() const { return values.size(); }
+    size_t domain_size() const { return domain_size_; }
+};
+
+/**
+ * A proving key used in place from a file written by
+ * r1cs_gg_ppzksnark_zok_write_flat_proving_key. Has the same points and
+ * queries as r1cs_gg_ppzksnark_zok_proving_key, the queries point into the
+ * mapping. The constraint system is only kept as the matrices the witness
+ * map evaluates, decoded from the key when it is opened.
+ */
+template<typename ppT>
+class r1cs_gg_ppzksnark_zok_mapped_proving_key {
+public:
+    libff::G1<ppT> alpha_g1;
+    libff::G1<ppT> beta_g1;
+    libff::G2<ppT> beta_g2;
+    libff::G1<ppT> delta_g1;
+    libff::G2<ppT> delta_g2;
+
+    mapped_array<libff::G1<ppT> > A_query;
+    mapped_knowledge_commitment_vector<libff::G2<ppT>, libff::G1<ppT> > B_query;
+    mapped_array<libff::G1<ppT> > H_query;
+    mapped_array<libff::G1<ppT> > L_query;
+
+    r1cs_gg_ppzksnark_zok_mapped_proving_key() {};
+    r1cs_gg_ppzksnark_zok_mapped_proving_key(const r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> &other) = delete;
+    r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT>& operator=(const r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> &other) = delete;
+
+    /**
+     * Map the key at `path`. Returns false, with the reason on stderr, if it
+     * is not a flat proving key usable on this host.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * Read every page of the mapping from the threads selected by `options`,
+     * so that with a NUMA node the key is placed in that node's memory
+     * rather than faulted in by whichever thread reaches it first. Pages
+     * already in the page cache stay where they are.
+     */
+    void prefault(const r1cs_gg_ppzksnark_zok_prover_options &options) const;
+
+    /**
+     * Copy into an owned proving key.
+     */
+    r1cs_gg_ppzksnark_zok_proving_key<ppT> to_proving_key() const;
+
+    /**
+     * The constraint system, as A, B and C in compressed sparse row form.
+     */
+    const qap_constraint_matrices<libff::Fr<ppT> > &constraint_matrices() const { return matrices; }
+
+private:
+    mapped_file file;
+    qap_constraint_matrices<libff::Fr<ppT> > matrices;
+
+    /* Queries decompressed from a compressed key, the mapped arrays point here */
+    std::vector<libff::G1<ppT> > A_query_storage;
+    std::vector<knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> > > B_query_storage;
+    std::vector<libff::G1<ppT> > H_query_storage;
+    std::vector<libff::G1<ppT> > L_query_storage;
+};
+
+/**
+ * Returns true if `path` starts with the flat proving key magic.
+ */
+inline bool r1cs_gg_ppzksnark_zok_is_flat_proving_key(const std::string &path);
+
+/**
+ * Read the header, section table and metadata of the flat proving key at
+ * `path`. Returns false, with the reason on stderr, if it is not one.
+ */
+inline bool r1cs_gg_ppzksnark_zok_read_flat_proving_key_info(const std::string &path, flat_proving_key_info &info);
+
+/**
+ * Load only the constraint system of the flat proving key at `path`.
+ */
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_read_flat_constraint_system(const std::string &path,
+                                                       r1cs_gg_ppzksnark_zok_constraint_system<ppT> &constraint_system);
+
+/**
+ * Write `pk` to `path` in the flat format, returns false on I/O errors.
+ * With `compressed` the queries take roughly a third of the space, but must
+ * be decompressed when the key is opened.
+ */
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_write_flat_proving_key(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                  const std::string &path,
+                                                  const bool compressed = false);
+
+/**
+ * The prover, with a mapped proving key.
+ */
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options);
+
+/**
+ * As above, with the fixed-base tables of the same key.
+ */
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &expanded_pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options);
+
+} // libsnark
+
+#include "r1cs_gg_ppzksnark_zok/flat_proving_key.tcc"
+
+#endif // FLAT_PROVING_KEY_HPP_
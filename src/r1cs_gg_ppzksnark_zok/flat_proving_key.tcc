@@ -0,0 +1,1043 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of interfaces for a flat binary proving key that can be used
+ in place, straight from a memory mapping.
+
+ See flat_proving_key.hpp .
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef FLAT_PROVING_KEY_TCC_
+#define FLAT_PROVING_KEY_TCC_
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <streambuf>
+#include <type_traits>
+#include <vector>
+
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+
+namespace libsnark {
+
+/**
+ * Input stream buffer over bytes that are already in memory, to parse the
+ * serialized sections without copying them.
+ */
+class flat_memory_streambuf : public std::streambuf {
+public:
+    flat_memory_streambuf(const uint8_t *data, const size_t size)
+    {
+        char *begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+        this->setg(begin, begin, begin + size);
+    }
+};
+
+/**
+ * A section to be written, `data` holds count * element_size bytes.
+ */
+struct flat_proving_key_output_section {
+    uint32_t id;
+    uint32_t element_size;
+    uint64_t count;
+    const void *data;
+};
+
+/* Flags of a compressed point, in the top bits of the last limb of x */
+const mp_limb_t flat_compressed_odd_y = mp_limb_t(1) << (GMP_NUMB_BITS - 1);
+const mp_limb_t flat_compressed_infinity = mp_limb_t(1) << (GMP_NUMB_BITS - 2);
+
+/* Points or constraints per task when (de)compressing and (de)coding */
+const size_t flat_proving_key_grain = 1ul << 12;
+
+/**
+ * The flags only fit if the top two bits of the base field are always clear.
+ */
+template<typename ppT>
+bool flat_proving_key_can_compress()
+{
+    return libff::Fq<ppT>::size_in_bits() + 2 <= size_t(libff::Fq<ppT>::num_limbs) * GMP_NUMB_BITS;
+}
+
+template<mp_size_t n, const libff::bigint<n>& modulus>
+bool flat_coordinate_is_odd(const libff::Fp_model<n, modulus> &y)
+{
+    return y.as_bigint().data[0] & 1;
+}
+
+template<mp_size_t n, const libff::bigint<n>& modulus>
+bool flat_coordinate_is_odd(const libff::Fp2_model<n, modulus> &y)
+{
+    return y.c0.is_zero() ? flat_coordinate_is_odd(y.c1) : flat_coordinate_is_odd(y.c0);
+}
+
+/**
+ * Euler's criterion, libff's sqrt doesn't terminate for non-residues.
+ */
+template<mp_size_t n, const libff::bigint<n>& modulus>
+bool flat_coordinate_is_square(const libff::Fp_model<n, modulus> &x)
+{
+    return x.is_zero() || (x ^ libff::Fp_model<n, modulus>::euler) == libff::Fp_model<n, modulus>::one();
+}
+
+/* An Fp2 element is a square when its norm c0^2 - non_residue * c1^2 is */
+template<mp_size_t n, const libff::bigint<n>& modulus>
+bool flat_coordinate_is_square(const libff::Fp2_model<n, modulus> &x)
+{
+    return flat_coordinate_is_square(x.c0.squared() - libff::Fp2_model<n, modulus>::non_residue * x.c1.squared());
+}
+
+template<typename T>
+size_t flat_compressed_size()
+{
+    return sizeof(typename std::decay<decltype(T::one().X)>::type);
+}
+
+template<typename T>
+void flat_compress_point(const T &point, uint8_t *out)
+{
+    typedef typename std::decay<decltype(point.X)>::type CoordT;
+
+    CoordT x = CoordT::zero();
+    mp_limb_t flags = flat_compressed_infinity;
+    if (!point.is_zero())
+    {
+        T affine = point;
+        if (!affine.is_special())
+        {
+            affine.to_affine_coordinates();
+        }
+        x = affine.X;
+        flags = flat_coordinate_is_odd(affine.Y) ? flat_compressed_odd_y : 0;
+    }
+
+    reinterpret_cast<mp_limb_t*>(&x)[sizeof(CoordT) / sizeof(mp_limb_t) - 1] |= flags;
+    memcpy(out, &x, sizeof(CoordT));
+}
+
+/**
+ * Recover y from the curve equation, returns false if x is not on the curve.
+ */
+template<typename T>
+bool flat_decompress_point(const uint8_t *in, T &point)
+{
+    typedef typename std::decay<decltype(point.X)>::type CoordT;
+
+    CoordT x;
+    memcpy(&x, in, sizeof(CoordT));
+    mp_limb_t &last_limb = reinterpret_cast<mp_limb_t*>(&x)[sizeof(CoordT) / sizeof(mp_limb_t) - 1];
+    const mp_limb_t flags = last_limb & (flat_compressed_odd_y | flat_compressed_infinity);
+    last_limb &= ~(flat_compressed_odd_y | flat_compressed_infinity);
+
+    if (flags & flat_compressed_infinity)
+    {
+        point = T::zero();
+        return true;
+    }
+
+    const CoordT rhs = x.squared() * x + T::coeff_a * x + T::coeff_b;
+    if (!flat_coordinate_is_square(rhs))
+    {
+        return false;
+    }
+    CoordT y = rhs.sqrt();
+
+    if (flat_coordinate_is_odd(y) != ((flags & flat_compressed_odd_y) != 0))
+    {
+        y = -y;
+    }
+
+    point = T(x, y, CoordT::one());
+    return true;
+}
+
+template<typename T>
+void flat_compress_points(const T *points, const size_t count, std::vector<uint8_t> &out)
+{
+    const size_t element_size = flat_compressed_size<T>();
+    out.resize(count * element_size);
+    parallel_for_ranges(count, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            flat_compress_point(points[i], &out[i * element_size]);
+        }
+    });
+}
+
+template<typename T>
+bool flat_decompress_points(const uint8_t *in, const size_t count, std::vector<T> &out)
+{
+    const size_t element_size = flat_compressed_size<T>();
+    out.resize(count);
+    std::vector<char> valid((count + flat_proving_key_grain - 1) / flat_proving_key_grain, 1);
+    parallel_for_ranges(count, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (!flat_decompress_point(in + i * element_size, out[i]))
+            {
+                valid[begin / flat_proving_key_grain] = 0;
+            }
+        }
+    });
+
+    return std::find(valid.begin(), valid.end(), 0) == valid.end();
+}
+
+/**
+ * Knowledge commitments are stored as the compressed g followed by the compressed h.
+ */
+template<typename T1, typename T2>
+void flat_compress_points(const knowledge_commitment<T1, T2> *points, const size_t count, std::vector<uint8_t> &out)
+{
+    const size_t g_size = flat_compressed_size<T1>();
+    const size_t element_size = g_size + flat_compressed_size<T2>();
+    out.resize(count * element_size);
+    parallel_for_ranges(count, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            flat_compress_point(points[i].g, &out[i * element_size]);
+            flat_compress_point(points[i].h, &out[i * element_size + g_size]);
+        }
+    });
+}
+
+template<typename T1, typename T2>
+bool flat_decompress_points(const uint8_t *in, const size_t count, std::vector<knowledge_commitment<T1, T2> > &out)
+{
+    const size_t g_size = flat_compressed_size<T1>();
+    const size_t element_size = g_size + flat_compressed_size<T2>();
+    out.resize(count);
+    std::vector<char> valid((count + flat_proving_key_grain - 1) / flat_proving_key_grain, 1);
+    parallel_for_ranges(count, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (!flat_decompress_point(in + i * element_size, out[i].g)
+             || !flat_decompress_point(in + i * element_size + g_size, out[i].h))
+            {
+                valid[begin / flat_proving_key_grain] = 0;
+            }
+        }
+    });
+
+    return std::find(valid.begin(), valid.end(), 0) == valid.end();
+}
+
+inline uint64_t flat_proving_key_align(const uint64_t offset)
+{
+    return (offset + flat_proving_key_alignment - 1) / flat_proving_key_alignment * flat_proving_key_alignment;
+}
+
+inline bool r1cs_gg_ppzksnark_zok_is_flat_proving_key(const std::string &path)
+{
+    std::ifstream fh(path, std::ios::binary);
+    char magic[sizeof(flat_proving_key_magic)];
+    if (!fh.read(magic, sizeof(magic)))
+    {
+        return false;
+    }
+
+    return 0 == memcmp(magic, flat_proving_key_magic, sizeof(magic));
+}
+
+inline bool flat_proving_key_check_header(const flat_proving_key_header &header, const uint64_t size, const std::string &path)
+{
+    if (0 != memcmp(header.magic, flat_proving_key_magic, sizeof(header.magic)))
+    {
+        std::cerr << "Error: " << path << " is not a flat proving key" << std::endl;
+        return false;
+    }
+
+    if (header.version != flat_proving_key_version)
+    {
+        std::cerr << "Error: unsupported flat proving key version " << header.version << std::endl;
+        return false;
+    }
+
+    if (header.byte_order != flat_proving_key_byte_order)
+    {
+        std::cerr << "Error: proving key " << path << " was written on a host of different byte order" << std::endl;
+        return false;
+    }
+
+    if (header.section_table_offset > size
+     || header.num_sections > (size - header.section_table_offset) / sizeof(flat_proving_key_section))
+    {
+        std::cerr << "Error: proving key " << path << " is truncated" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+inline bool flat_proving_key_check_section(const flat_proving_key_section &section, const uint64_t size, const std::string &path)
+{
+    if (section.element_size == 0
+     || section.offset % sizeof(uint64_t) != 0
+     || section.offset > size
+     || section.count > (size - section.offset) / section.element_size)
+    {
+        std::cerr << "Error: proving key " << path << " has an invalid section " << section.id << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+inline bool flat_proving_key_find_section(const std::map<uint32_t, flat_proving_key_section> &sections,
+                                          const uint32_t id,
+                                          const uint32_t element_size,
+                                          const std::string &path,
+                                          flat_proving_key_section &section)
+{
+    auto it = sections.find(id);
+    if (it == sections.end() || it->second.element_size != element_size)
+    {
+        std::cerr << "Error: proving key " << path << " has no valid section " << id << std::endl;
+        return false;
+    }
+    section = it->second;
+    return true;
+}
+
+/**
+ * Validate the header and section table of a mapped key, and that it was
+ * written for this curve on a compatible host.
+ */
+template<typename ppT>
+bool flat_proving_key_read_table(const uint8_t *data,
+                                 const size_t size,
+                                 const std::string &path,
+                                 std::map<uint32_t, flat_proving_key_section> &sections)
+{
+    typedef libff::G1<ppT> G1;
+    typedef libff::G2<ppT> G2;
+
+    flat_proving_key_header header;
+    if (size < sizeof(header))
+    {
+        std::cerr << "Error: proving key " << path << " is truncated" << std::endl;
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (!flat_proving_key_check_header(header, size, path))
+    {
+        return false;
+    }
+
+    if (header.limb_bits != GMP_NUMB_BITS
+     || header.G1_size != sizeof(G1)
+     || header.G2_size != sizeof(G2))
+    {
+        std::cerr << "Error: proving key " << path << " was written on an incompatible host" << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < header.num_sections; ++i)
+    {
+        flat_proving_key_section section;
+        memcpy(&section, data + header.section_table_offset + i * sizeof(section), sizeof(section));
+
+        if (!flat_proving_key_check_section(section, size, path))
+        {
+            return false;
+        }
+
+        sections[section.id] = section;
+    }
+
+    /* The points and coefficients are used as they are, so the field representation must match exactly */
+    flat_proving_key_section generators;
+    const G1 G1_one = G1::one();
+    const G2 G2_one = G2::one();
+    if (!flat_proving_key_find_section(sections, flat_section_generators, 1, path, generators)
+     || generators.count != sizeof(G1) + sizeof(G2)
+     || 0 != memcmp(data + generators.offset, &G1_one, sizeof(G1))
+     || 0 != memcmp(data + generators.offset + sizeof(G1), &G2_one, sizeof(G2)))
+    {
+        std::cerr << "Error: proving key " << path << " is for a different curve or field representation" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+template<typename FieldT>
+size_t flat_constraint_term_size()
+{
+    return sizeof(uint64_t) + sizeof(FieldT);
+}
+
+/**
+ * Row offsets and terms of A, B then C, see flat_section_constraint_rows.
+ */
+template<typename FieldT>
+void flat_encode_constraint_system(const r1cs_constraint_system<FieldT> &cs,
+                                   std::vector<uint64_t> &rows,
+                                   std::vector<uint8_t> &terms)
+{
+    const size_t term_size = flat_constraint_term_size<FieldT>();
+    const size_t num_constraints = cs.num_constraints();
+
+    rows.resize(3 * (num_constraints + 1));
+    uint64_t num_terms = 0;
+    for (size_t matrix = 0; matrix < 3; ++matrix)
+    {
+        for (size_t i = 0; i < num_constraints; ++i)
+        {
+            const r1cs_constraint<FieldT> &constraint = cs.constraints[i];
+            const linear_combination<FieldT> &lc = (matrix == 0 ? constraint.a : (matrix == 1 ? constraint.b : constraint.c));
+            rows[matrix * (num_constraints + 1) + i] = num_terms;
+            num_terms += lc.terms.size();
+        }
+        rows[matrix * (num_constraints + 1) + num_constraints] = num_terms;
+    }
+
+    terms.resize(num_terms * term_size);
+    parallel_for_ranges(num_constraints, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+        for (size_t matrix = 0; matrix < 3; ++matrix)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const r1cs_constraint<FieldT> &constraint = cs.constraints[i];
+                const linear_combination<FieldT> &lc = (matrix == 0 ? constraint.a : (matrix == 1 ? constraint.b : constraint.c));
+                uint8_t *out = &terms[rows[matrix * (num_constraints + 1) + i] * term_size];
+                for (const linear_term<FieldT> &term : lc.terms)
+                {
+                    const uint64_t index = term.index;
+                    memcpy(out, &index, sizeof(uint64_t));
+                    memcpy(out + sizeof(uint64_t), &term.coeff, sizeof(FieldT));
+                    out += term_size;
+                }
+            }
+        }
+    });
+}
+
+/**
+ * Whether the row offsets of A, B then C fit the metadata and the terms.
+ */
+inline bool flat_check_constraint_rows(const uint64_t *rows,
+                                       const size_t num_rows,
+                                       const size_t num_terms,
+                                       const flat_proving_key_metadata &metadata)
+{
+    if (num_rows != 3 * (metadata.num_constraints + 1))
+    {
+        return false;
+    }
+
+    /* Offsets are into the terms of all three matrices, so never decrease */
+    for (size_t i = 0; i + 1 < num_rows; ++i)
+    {
+        if (rows[i] > rows[i + 1])
+        {
+            return false;
+        }
+    }
+
+    return rows[num_rows - 1] <= num_terms;
+}
+
+template<typename FieldT>
+bool flat_decode_constraint_system(const uint64_t *rows,
+                                   const size_t num_rows,
+                                   const uint8_t *terms,
+                                   const size_t num_terms,
+                                   const flat_proving_key_metadata &metadata,
+                                   r1cs_constraint_system<FieldT> &cs)
+{
+    const size_t term_size = flat_constraint_term_size<FieldT>();
+    const size_t num_constraints = metadata.num_constraints;
+    const uint64_t num_variables = metadata.primary_input_size + metadata.auxiliary_input_size;
+
+    if (!flat_check_constraint_rows(rows, num_rows, num_terms, metadata))
+    {
+        return false;
+    }
+
+    cs.primary_input_size = metadata.primary_input_size;
+    cs.auxiliary_input_size = metadata.auxiliary_input_size;
+    cs.constraints.clear();
+    cs.constraints.resize(num_constraints);
+
+    std::vector<char> valid((num_constraints + flat_proving_key_grain - 1) / flat_proving_key_grain, 1);
+    parallel_for_ranges(num_constraints, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+        for (size_t matrix = 0; matrix < 3; ++matrix)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                r1cs_constraint<FieldT> &constraint = cs.constraints[i];
+                linear_combination<FieldT> &lc = (matrix == 0 ? constraint.a : (matrix == 1 ? constraint.b : constraint.c));
+                const uint64_t row_begin = rows[matrix * (num_constraints + 1) + i];
+                const uint64_t row_end = rows[matrix * (num_constraints + 1) + i + 1];
+
+                lc.terms.resize(row_end - row_begin);
+                for (uint64_t j = row_begin; j < row_end; ++j)
+                {
+                    const uint8_t *in = terms + j * term_size;
+                    uint64_t index;
+                    memcpy(&index, in, sizeof(uint64_t));
+                    if (index > num_variables)
+                    {
+                        valid[begin / flat_proving_key_grain] = 0;
+                    }
+
+                    linear_term<FieldT> &term = lc.terms[j - row_begin];
+                    term.index = index;
+                    memcpy(&term.coeff, in + sizeof(uint64_t), sizeof(FieldT));
+                }
+            }
+        }
+    });
+
+    return std::find(valid.begin(), valid.end(), 0) == valid.end();
+}
+
+/**
+ * The matrices as qap_constraint_matrices, without going through a
+ * constraint system. Their row offsets start again from 0 for B and C.
+ */
+template<typename FieldT>
+bool flat_decode_constraint_matrices(const uint64_t *rows,
+                                     const size_t num_rows,
+                                     const uint8_t *terms,
+                                     const size_t num_terms,
+                                     const flat_proving_key_metadata &metadata,
+                                     qap_constraint_matrices<FieldT> &matrices)
+{
+    const size_t term_size = flat_constraint_term_size<FieldT>();
+    const size_t num_constraints = metadata.num_constraints;
+    const uint64_t num_variables = metadata.primary_input_size + metadata.auxiliary_input_size;
+
+    if (!flat_check_constraint_rows(rows, num_rows, num_terms, metadata))
+    {
+        return false;
+    }
+
+    matrices.num_constraints = num_constraints;
+    matrices.num_inputs = metadata.primary_input_size;
+    matrices.num_variables = num_variables;
+
+    bool valid = true;
+    for (size_t matrix = 0; matrix < 3; ++matrix)
+    {
+        const uint64_t *matrix_rows = rows + matrix * (num_constraints + 1);
+        const uint64_t first = matrix_rows[0];
+        const size_t matrix_terms = matrix_rows[num_constraints] - first;
+
+        std::vector<size_t> &out_rows = matrices.rows[matrix];
+        out_rows.resize(num_constraints + 1);
+        for (size_t i = 0; i <= num_constraints; ++i)
+        {
+            out_rows[i] = matrix_rows[i] - first;
+        }
+
+        std::vector<size_t> &indices = matrices.indices[matrix];
+        std::vector<FieldT> &coefficients = matrices.coefficients[matrix];
+        indices.resize(matrix_terms);
+        coefficients.resize(matrix_terms);
+
+        std::vector<char> valid_ranges((matrix_terms + flat_proving_key_grain - 1) / flat_proving_key_grain, 1);
+        parallel_for_ranges(matrix_terms, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+            for (size_t j = begin; j < end; ++j)
+            {
+                const uint8_t *in = terms + (first + j) * term_size;
+                uint64_t index;
+                memcpy(&index, in, sizeof(uint64_t));
+                if (index > num_variables)
+                {
+                    valid_ranges[begin / flat_proving_key_grain] = 0;
+                }
+
+                indices[j] = index;
+                memcpy(&coefficients[j], in + sizeof(uint64_t), sizeof(FieldT));
+            }
+        });
+
+        valid = valid && std::find(valid_ranges.begin(), valid_ranges.end(), 0) == valid_ranges.end();
+    }
+
+    return valid;
+}
+
+/**
+ * Load the constraint system from the matrices, or from the text
+ * serialization of keys written before them.
+ */
+template<typename ppT>
+bool flat_proving_key_read_constraint_system(const uint8_t *data,
+                                             const std::map<uint32_t, flat_proving_key_section> &sections,
+                                             const std::string &path,
+                                             r1cs_gg_ppzksnark_zok_constraint_system<ppT> &constraint_system)
+{
+    typedef libff::Fr<ppT> FieldT;
+
+    if (sections.count(flat_section_constraint_rows) == 0)
+    {
+        flat_proving_key_section text;
+        if (!flat_proving_key_find_section(sections, flat_section_constraint_system, 1, path, text))
+        {
+            return false;
+        }
+
+        flat_memory_streambuf constraint_system_buf(data + text.offset, text.count);
+        std::istream constraint_system_stream(&constraint_system_buf);
+        constraint_system_stream >> constraint_system;
+        if (constraint_system_stream.fail())
+        {
+            std::cerr << "Error: proving key " << path << " has an invalid constraint system" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    flat_proving_key_section metadata, rows, terms;
+    if (!flat_proving_key_find_section(sections, flat_section_metadata, sizeof(flat_proving_key_metadata), path, metadata)
+     || !flat_proving_key_find_section(sections, flat_section_constraint_rows, sizeof(uint64_t), path, rows)
+     || !flat_proving_key_find_section(sections, flat_section_constraint_terms, flat_constraint_term_size<FieldT>(), path, terms)
+     || metadata.count < 1)
+    {
+        return false;
+    }
+
+    flat_proving_key_metadata circuit;
+    memcpy(&circuit, data + metadata.offset, sizeof(circuit));
+
+    libff::enter_block("Load constraint system");
+    const bool valid = flat_decode_constraint_system(reinterpret_cast<const uint64_t*>(data + rows.offset), rows.count,
+                                                     data + terms.offset, terms.count,
+                                                     circuit, constraint_system);
+    libff::leave_block("Load constraint system");
+
+    if (!valid)
+    {
+        std::cerr << "Error: proving key " << path << " has an invalid constraint system" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Load the matrices of the constraint system straight from their sections,
+ * keys with a text serialized constraint system are converted.
+ */
+template<typename ppT>
+bool flat_proving_key_read_constraint_matrices(const uint8_t *data,
+                                               const std::map<uint32_t, flat_proving_key_section> &sections,
+                                               const std::string &path,
+                                               qap_constraint_matrices<libff::Fr<ppT> > &matrices)
+{
+    typedef libff::Fr<ppT> FieldT;
+
+    if (sections.count(flat_section_constraint_rows) == 0)
+    {
+        r1cs_gg_ppzksnark_zok_constraint_system<ppT> constraint_system;
+        if (!flat_proving_key_read_constraint_system<ppT>(data, sections, path, constraint_system))
+        {
+            return false;
+        }
+
+        libff::enter_block("Convert constraint system to matrices");
+        qap_make_constraint_matrices(constraint_system, matrices);
+        libff::leave_block("Convert constraint system to matrices");
+
+        return true;
+    }
+
+    flat_proving_key_section metadata, rows, terms;
+    if (!flat_proving_key_find_section(sections, flat_section_metadata, sizeof(flat_proving_key_metadata), path, metadata)
+     || !flat_proving_key_find_section(sections, flat_section_constraint_rows, sizeof(uint64_t), path, rows)
+     || !flat_proving_key_find_section(sections, flat_section_constraint_terms, flat_constraint_term_size<FieldT>(), path, terms)
+     || metadata.count < 1)
+    {
+        return false;
+    }
+
+    flat_proving_key_metadata circuit;
+    memcpy(&circuit, data + metadata.offset, sizeof(circuit));
+
+    libff::enter_block("Load constraint matrices");
+    const bool valid = flat_decode_constraint_matrices(reinterpret_cast<const uint64_t*>(data + rows.offset), rows.count,
+                                                       data + terms.offset, terms.count,
+                                                       circuit, matrices);
+    libff::leave_block("Load constraint matrices");
+
+    if (!valid)
+    {
+        std::cerr << "Error: proving key " << path << " has an invalid constraint system" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_write_flat_proving_key(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                  const std::string &path,
+                                                  const bool compressed)
+{
+    typedef libff::G1<ppT> G1;
+    typedef libff::G2<ppT> G2;
+    typedef knowledge_commitment<G2, G1> KC;
+
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_write_flat_proving_key");
+
+    const G1 G1_one = G1::one();
+    const G2 G2_one = G2::one();
+    std::vector<uint8_t> generators(sizeof(G1) + sizeof(G2));
+    memcpy(&generators[0], &G1_one, sizeof(G1));
+    memcpy(&generators[sizeof(G1)], &G2_one, sizeof(G2));
+
+    std::vector<uint8_t> key_points(3 * sizeof(G1) + 2 * sizeof(G2));
+    memcpy(&key_points[0], &pk.alpha_g1, sizeof(G1));
+    memcpy(&key_points[sizeof(G1)], &pk.beta_g1, sizeof(G1));
+    memcpy(&key_points[2 * sizeof(G1)], &pk.delta_g1, sizeof(G1));
+    memcpy(&key_points[3 * sizeof(G1)], &pk.beta_g2, sizeof(G2));
+    memcpy(&key_points[3 * sizeof(G1) + sizeof(G2)], &pk.delta_g2, sizeof(G2));
+
+    const uint64_t parameters[1] = {pk.B_query.domain_size()};
+
+    const std::vector<uint64_t> B_query_indices(pk.B_query.indices.begin(), pk.B_query.indices.end());
+
+    flat_proving_key_metadata metadata;
+    memset(&metadata, 0, sizeof(metadata));
+    metadata.primary_input_size = pk.constraint_system.primary_input_size;
+    metadata.auxiliary_input_size = pk.constraint_system.auxiliary_input_size;
+    metadata.num_constraints = pk.constraint_system.num_constraints();
+    metadata.A_query_size = pk.A_query.size();
+    metadata.B_query_size = pk.B_query.values.size();
+    metadata.H_query_size = pk.H_query.size();
+    metadata.L_query_size = pk.L_query.size();
+    metadata.compressed = compressed;
+
+    const uint32_t term_size = flat_constraint_term_size<libff::Fr<ppT> >();
+    std::vector<uint64_t> constraint_rows;
+    std::vector<uint8_t> constraint_terms;
+    flat_encode_constraint_system(pk.constraint_system, constraint_rows, constraint_terms);
+
+    std::vector<flat_proving_key_output_section> sections = {
+        {flat_section_generators, 1, generators.size(), generators.data()},
+        {flat_section_key_points, 1, key_points.size(), key_points.data()},
+        {flat_section_parameters, sizeof(uint64_t), 1, parameters},
+        {flat_section_metadata, sizeof(flat_proving_key_metadata), 1, &metadata},
+        {flat_section_B_query_indices, sizeof(uint64_t), B_query_indices.size(), B_query_indices.data()},
+        {flat_section_constraint_rows, sizeof(uint64_t), constraint_rows.size(), constraint_rows.data()},
+        {flat_section_constraint_terms, term_size, constraint_terms.size() / term_size, constraint_terms.data()}
+    };
+
+    std::vector<uint8_t> A_query, B_query_values, H_query, L_query;
+    if (compressed)
+    {
+        if (!flat_proving_key_can_compress<ppT>())
+        {
+            std::cerr << "Error: points of this curve cannot be compressed" << std::endl;
+            libff::leave_block("Call to r1cs_gg_ppzksnark_zok_write_flat_proving_key");
+            return false;
+        }
+
+        libff::enter_block("Compress queries");
+        flat_compress_points(pk.A_query.data(), pk.A_query.size(), A_query);
+        flat_compress_points(pk.B_query.values.data(), pk.B_query.values.size(), B_query_values);
+        flat_compress_points(pk.H_query.data(), pk.H_query.size(), H_query);
+        flat_compress_points(pk.L_query.data(), pk.L_query.size(), L_query);
+        libff::leave_block("Compress queries");
+
+        const uint32_t G1_size = flat_compressed_size<G1>();
+        const uint32_t KC_size = flat_compressed_size<G2>() + G1_size;
+        sections.push_back({flat_section_A_query_compressed, G1_size, pk.A_query.size(), A_query.data()});
+        sections.push_back({flat_section_B_query_values_compressed, KC_size, pk.B_query.values.size(), B_query_values.data()});
+        sections.push_back({flat_section_H_query_compressed, G1_size, pk.H_query.size(), H_query.data()});
+        sections.push_back({flat_section_L_query_compressed, G1_size, pk.L_query.size(), L_query.data()});
+    }
+    else {
+        sections.push_back({flat_section_A_query, sizeof(G1), pk.A_query.size(), pk.A_query.data()});
+        sections.push_back({flat_section_B_query_values, sizeof(KC), pk.B_query.values.size(), pk.B_query.values.data()});
+        sections.push_back({flat_section_H_query, sizeof(G1), pk.H_query.size(), pk.H_query.data()});
+        sections.push_back({flat_section_L_query, sizeof(G1), pk.L_query.size(), pk.L_query.data()});
+    }
+    const size_t num_sections = sections.size();
+
+    flat_proving_key_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, flat_proving_key_magic, sizeof(header.magic));
+    header.version = flat_proving_key_version;
+    header.num_sections = num_sections;
+    header.limb_bits = GMP_NUMB_BITS;
+    header.byte_order = flat_proving_key_byte_order;
+    header.G1_size = sizeof(G1);
+    header.G2_size = sizeof(G2);
+    header.section_table_offset = sizeof(header);
+
+    std::vector<flat_proving_key_section> table(num_sections);
+    uint64_t offset = flat_proving_key_align(sizeof(header) + num_sections * sizeof(flat_proving_key_section));
+    for (size_t i = 0; i < num_sections; ++i)
+    {
+        memset(&table[i], 0, sizeof(table[i]));
+        table[i].id = sections[i].id;
+        table[i].element_size = sections[i].element_size;
+        table[i].offset = offset;
+        table[i].count = sections[i].count;
+        offset = flat_proving_key_align(offset + sections[i].count * sections[i].element_size);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(flat_proving_key_section));
+
+    uint64_t position = sizeof(header) + table.size() * sizeof(flat_proving_key_section);
+    const std::vector<char> padding(flat_proving_key_alignment, 0);
+    for (size_t i = 0; i < num_sections && out.good(); ++i)
+    {
+        out.write(padding.data(), table[i].offset - position);
+        out.write(reinterpret_cast<const char*>(sections[i].data), sections[i].count * sections[i].element_size);
+        position = table[i].offset + sections[i].count * sections[i].element_size;
+    }
+    out.flush();
+
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_write_flat_proving_key");
+
+    return out.good();
+}
+
+inline bool r1cs_gg_ppzksnark_zok_read_flat_proving_key_info(const std::string &path, flat_proving_key_info &info)
+{
+    std::ifstream fh(path, std::ios::binary | std::ios::ate);
+    if (!fh.is_open())
+    {
+        std::cerr << "Error: cannot open proving key " << path << std::endl;
+        return false;
+    }
+    const uint64_t size = fh.tellg();
+    fh.seekg(0);
+
+    if (!fh.read(reinterpret_cast<char*>(&info.header), sizeof(info.header)))
+    {
+        std::cerr << "Error: proving key " << path << " is truncated" << std::endl;
+        return false;
+    }
+
+    if (!flat_proving_key_check_header(info.header, size, path))
+    {
+        return false;
+    }
+
+    info.sections.resize(info.header.num_sections);
+    fh.seekg(info.header.section_table_offset);
+    if (!fh.read(reinterpret_cast<char*>(info.sections.data()), info.sections.size() * sizeof(flat_proving_key_section)))
+    {
+        std::cerr << "Error: proving key " << path << " is truncated" << std::endl;
+        return false;
+    }
+
+    memset(&info.metadata, 0, sizeof(info.metadata));
+    for (const flat_proving_key_section &section : info.sections)
+    {
+        if (!flat_proving_key_check_section(section, size, path))
+        {
+            return false;
+        }
+
+        if (section.id == flat_section_metadata && section.element_size == sizeof(flat_proving_key_metadata) && section.count > 0)
+        {
+            fh.seekg(section.offset);
+            if (!fh.read(reinterpret_cast<char*>(&info.metadata), sizeof(info.metadata)))
+            {
+                std::cerr << "Error: proving key " << path << " is truncated" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_read_flat_constraint_system(const std::string &path,
+                                                       r1cs_gg_ppzksnark_zok_constraint_system<ppT> &constraint_system)
+{
+    mapped_file file;
+    if (!file.open(path))
+    {
+        std::cerr << "Error: cannot map proving key " << path << std::endl;
+        return false;
+    }
+
+    std::map<uint32_t, flat_proving_key_section> sections;
+    return flat_proving_key_read_table<ppT>(file.data(), file.size(), path, sections)
+        && flat_proving_key_read_constraint_system<ppT>(file.data(), sections, path, constraint_system);
+}
+
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT>::open(const std::string &path)
+{
+    typedef libff::G1<ppT> G1;
+    typedef libff::G2<ppT> G2;
+    typedef knowledge_commitment<G2, G1> KC;
+
+    if (!this->file.open(path))
+    {
+        std::cerr << "Error: cannot map proving key " << path << std::endl;
+        return false;
+    }
+
+    const uint8_t *data = this->file.data();
+
+    std::map<uint32_t, flat_proving_key_section> sections;
+    if (!flat_proving_key_read_table<ppT>(data, this->file.size(), path, sections))
+    {
+        return false;
+    }
+
+    const bool compressed = sections.count(flat_section_A_query_compressed) != 0;
+    const uint32_t G1_size = compressed ? flat_compressed_size<G1>() : sizeof(G1);
+    const uint32_t KC_size = compressed ? flat_compressed_size<G2>() + flat_compressed_size<G1>() : sizeof(KC);
+
+    flat_proving_key_section key_points, parameters, A_query, B_query_indices, B_query_values, H_query, L_query;
+    if (!flat_proving_key_find_section(sections, flat_section_key_points, 1, path, key_points)
+     || !flat_proving_key_find_section(sections, flat_section_parameters, sizeof(uint64_t), path, parameters)
+     || !flat_proving_key_find_section(sections, compressed ? flat_section_A_query_compressed : flat_section_A_query, G1_size, path, A_query)
+     || !flat_proving_key_find_section(sections, flat_section_B_query_indices, sizeof(uint64_t), path, B_query_indices)
+     || !flat_proving_key_find_section(sections, compressed ? flat_section_B_query_values_compressed : flat_section_B_query_values, KC_size, path, B_query_values)
+     || !flat_proving_key_find_section(sections, compressed ? flat_section_H_query_compressed : flat_section_H_query, G1_size, path, H_query)
+     || !flat_proving_key_find_section(sections, compressed ? flat_section_L_query_compressed : flat_section_L_query, G1_size, path, L_query))
+    {
+        return false;
+    }
+
+    if (key_points.count != 3 * sizeof(G1) + 2 * sizeof(G2)
+     || parameters.count < 1
+     || B_query_indices.count != B_query_values.count)
+    {
+        std::cerr << "Error: proving key " << path << " is malformed" << std::endl;
+        return false;
+    }
+
+    const uint8_t *points = data + key_points.offset;
+    memcpy(&this->alpha_g1, points, sizeof(G1));
+    memcpy(&this->beta_g1, points + sizeof(G1), sizeof(G1));
+    memcpy(&this->delta_g1, points + 2 * sizeof(G1), sizeof(G1));
+    memcpy(&this->beta_g2, points + 3 * sizeof(G1), sizeof(G2));
+    memcpy(&this->delta_g2, points + 3 * sizeof(G1) + sizeof(G2), sizeof(G2));
+
+    uint64_t B_query_domain_size;
+    memcpy(&B_query_domain_size, data + parameters.offset, sizeof(uint64_t));
+
+    this->B_query.indices = mapped_array<uint64_t>(reinterpret_cast<const uint64_t*>(data + B_query_indices.offset), B_query_indices.count);
+    this->B_query.domain_size_ = B_query_domain_size;
+
+    if (compressed)
+    {
+        if (!flat_proving_key_can_compress<ppT>())
+        {
+            std::cerr << "Error: proving key " << path << " is compressed, which this curve doesn't support" << std::endl;
+            return false;
+        }
+
+        libff::enter_block("Decompress queries");
+        const bool valid = flat_decompress_points(data + A_query.offset, A_query.count, this->A_query_storage)
+                        && flat_decompress_points(data + B_query_values.offset, B_query_values.count, this->B_query_storage)
+                        && flat_decompress_points(data + H_query.offset, H_query.count, this->H_query_storage)
+                        && flat_decompress_points(data + L_query.offset, L_query.count, this->L_query_storage);
+        libff::leave_block("Decompress queries");
+
+        if (!valid)
+        {
+            std::cerr << "Error: proving key " << path << " has compressed points not on the curve" << std::endl;
+            return false;
+        }
+
+        this->A_query = mapped_array<G1>(this->A_query_storage.data(), this->A_query_storage.size());
+        this->B_query.values = mapped_array<KC>(this->B_query_storage.data(), this->B_query_storage.size());
+        this->H_query = mapped_array<G1>(this->H_query_storage.data(), this->H_query_storage.size());
+        this->L_query = mapped_array<G1>(this->L_query_storage.data(), this->L_query_storage.size());
+    }
+    else {
+        this->A_query = mapped_array<G1>(reinterpret_cast<const G1*>(data + A_query.offset), A_query.count);
+        this->B_query.values = mapped_array<KC>(reinterpret_cast<const KC*>(data + B_query_values.offset), B_query_values.count);
+        this->H_query = mapped_array<G1>(reinterpret_cast<const G1*>(data + H_query.offset), H_query.count);
+        this->L_query = mapped_array<G1>(reinterpret_cast<const G1*>(data + L_query.offset), L_query.count);
+    }
+
+    return flat_proving_key_read_constraint_matrices<ppT>(data, sections, path, this->matrices);
+}
+
+template<typename ppT>
+void r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT>::prefault(const r1cs_gg_ppzksnark_zok_prover_options &options) const
+{
+    const parallel_thread_scope thread_scope(options.num_threads, options.numa_node);
+
+    libff::enter_block("Prefault proving key");
+    const volatile uint8_t *data = this->file.data();
+    const size_t num_pages = (this->file.size() + flat_proving_key_alignment - 1) / flat_proving_key_alignment;
+    parallel_for_ranges(num_pages, flat_proving_key_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            (void)data[i * flat_proving_key_alignment];
+        }
+    });
+    libff::leave_block("Prefault proving key");
+}
+
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_proving_key<ppT> r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT>::to_proving_key() const
+{
+    libff::G1<ppT> alpha_g1 = this->alpha_g1;
+    libff::G1<ppT> beta_g1 = this->beta_g1;
+    libff::G2<ppT> beta_g2 = this->beta_g2;
+    libff::G1<ppT> delta_g1 = this->delta_g1;
+    libff::G2<ppT> delta_g2 = this->delta_g2;
+
+    libff::G1_vector<ppT> A_query(this->A_query.begin(), this->A_query.end());
+    knowledge_commitment_vector<libff::G2<ppT>, libff::G1<ppT> > B_query;
+    B_query.indices.assign(this->B_query.indices.begin(), this->B_query.indices.end());
+    B_query.values.assign(this->B_query.values.begin(), this->B_query.values.end());
+    B_query.domain_size_ = this->B_query.domain_size();
+    libff::G1_vector<ppT> H_query(this->H_query.begin(), this->H_query.end());
+    libff::G1_vector<ppT> L_query(this->L_query.begin(), this->L_query.end());
+    r1cs_gg_ppzksnark_zok_constraint_system<ppT> constraint_system;
+    qap_make_constraint_system(this->matrices, constraint_system);
+
+    return r1cs_gg_ppzksnark_zok_proving_key<ppT>(std::move(alpha_g1),
+                                                  std::move(beta_g1),
+                                                  std::move(beta_g2),
+                                                  std::move(delta_g1),
+                                                  std::move(delta_g2),
+                                                  std::move(A_query),
+                                                  std::move(B_query),
+                                                  std::move(H_query),
+                                                  std::move(L_query),
+                                                  std::move(constraint_system));
+}
+
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options)
+{
+    return r1cs_gg_ppzksnark_zok_prover_with_tables<ppT>(pk, pk.constraint_matrices(), nullptr, primary_input, auxiliary_input, options);
+}
+
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &expanded_pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options)
+{
+    return r1cs_gg_ppzksnark_zok_prover_with_tables<ppT>(pk, pk.constraint_matrices(), &expanded_pk, primary_input, auxiliary_input, options);
+}
+
+} // libsnark
+
+#endif // FLAT_PROVING_KEY_TCC_
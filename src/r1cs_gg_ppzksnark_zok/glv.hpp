@@ -0,0 +1,85 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of interfaces for GLV scalar multiplication.
+
+ Some curves have an efficiently computable endomorphism phi with
+ phi(P) = lambda * P for a fixed lambda. A scalar k is then split into
+ k = k1 + k2 * lambda with k1 and k2 about half the size of k, and
+ k * P = k1 * P + k2 * phi(P) takes half the doublings, see \[GLV01].
+
+ On alt_bn128 G1, phi(x, y) = (beta * x, y) with beta a cube root of unity
+ in Fq, and lambda is a cube root of unity in Fr. The decomposition uses a
+ short basis of the lattice of (a, b) with a + b * lambda = 0 mod r, and
+ the half scalars are at most 128 bits.
+
+ Groups without an endomorphism leave glv_endomorphism<T>::enabled false,
+ and the functions here fall back to the full scalars.
+
+ References:
+
+ \[GLV01]:
+  "Faster Point Multiplication on Elliptic Curves with Efficient Endomorphisms",
+  Robert P. Gallant, Robert J. Lambert, Scott A. Vanstone,
+  CRYPTO 2001
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef GLV_HPP_
+#define GLV_HPP_
+
+#include <cstddef>
+
+#include <libff/algebra/curves/alt_bn128/alt_bn128_g1.hpp>
+#include <libff/algebra/curves/alt_bn128/alt_bn128_init.hpp>
+#include <libff/algebra/fields/bigint.hpp>
+
+namespace libsnark {
+
+/**
+ * The endomorphism of group T, if it has one usable for GLV.
+ */
+template<typename T>
+struct glv_endomorphism {
+    static const bool enabled = false;
+};
+
+template<>
+struct glv_endomorphism<libff::alt_bn128_G1> {
+    static const bool enabled = true;
+
+    /* Upper bound on the bits of the half scalars */
+    static const size_t scalar_bits = 128;
+
+    typedef libff::bigint<libff::alt_bn128_r_limbs> half_scalar;
+
+    /**
+     * phi(P) = lambda * P
+     */
+    static libff::alt_bn128_G1 apply(const libff::alt_bn128_G1 &P);
+
+    /**
+     * Split k into k1 + k2 * lambda mod r, as magnitudes and signs.
+     */
+    static void decompose(const libff::alt_bn128_Fr &k,
+                          half_scalar &k1, bool &k1_negative,
+                          half_scalar &k2, bool &k2_negative);
+
+    static const libff::alt_bn128_Fq &beta();
+    static const libff::alt_bn128_Fr &lambda();
+};
+
+/**
+ * k * P, with the endomorphism of T if it has one.
+ */
+template<typename T, typename FieldT>
+T glv_scalar_mul(const FieldT &k, const T &P);
+
+} // libsnark
+
+#include "r1cs_gg_ppzksnark_zok/glv.tcc"
+
+#endif // GLV_HPP_
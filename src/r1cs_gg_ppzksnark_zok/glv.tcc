@@ -0,0 +1,152 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of interfaces for GLV scalar multiplication.
+
+ See glv.hpp .
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef GLV_TCC_
+#define GLV_TCC_
+
+#include <cassert>
+#include <type_traits>
+
+#include <gmp.h>
+
+namespace libsnark {
+
+inline const libff::alt_bn128_Fq &glv_endomorphism<libff::alt_bn128_G1>::beta()
+{
+    static const libff::alt_bn128_Fq value(libff::bigint<libff::alt_bn128_q_limbs>("2203960485148121921418603742825762020974279258880205651966"));
+    return value;
+}
+
+inline const libff::alt_bn128_Fr &glv_endomorphism<libff::alt_bn128_G1>::lambda()
+{
+    static const libff::alt_bn128_Fr value(half_scalar("4407920970296243842393367215006156084916469457145843978461"));
+    return value;
+}
+
+inline libff::alt_bn128_G1 glv_endomorphism<libff::alt_bn128_G1>::apply(const libff::alt_bn128_G1 &P)
+{
+    /* x = X/Z^2 in Jacobian coordinates, so scaling X scales x */
+    return libff::alt_bn128_G1(beta() * P.X, P.Y, P.Z);
+}
+
+/**
+ * floor(k * g / 2^256)
+ */
+template<mp_size_t n>
+libff::bigint<n> glv_round(const libff::bigint<n> &k, const libff::bigint<n> &g)
+{
+    mp_limb_t product[2 * n];
+    mpn_mul_n(product, k.data, g.data, n);
+
+    const size_t shift = 256 / GMP_NUMB_BITS;
+    libff::bigint<n> result;
+    for (size_t i = 0; i < static_cast<size_t>(n); ++i)
+    {
+        result.data[i] = (shift + i < static_cast<size_t>(2 * n) ? product[shift + i] : 0);
+    }
+    return result;
+}
+
+/**
+ * The magnitude and sign of x, known to be small or close to r.
+ */
+template<typename FieldT, mp_size_t n>
+void glv_signed(const FieldT &x, const size_t scalar_bits, libff::bigint<n> &magnitude, bool &negative)
+{
+    magnitude = x.as_bigint();
+    negative = magnitude.num_bits() > scalar_bits;
+    if (negative)
+    {
+        magnitude = (-x).as_bigint();
+    }
+    assert(magnitude.num_bits() <= scalar_bits);
+}
+
+inline void glv_endomorphism<libff::alt_bn128_G1>::decompose(const libff::alt_bn128_Fr &k,
+                                                             half_scalar &k1, bool &k1_negative,
+                                                             half_scalar &k2, bool &k2_negative)
+{
+    typedef libff::alt_bn128_Fr FieldT;
+
+    /* Short basis (a1, -b1), (a2, b2) with a + b * lambda = 0 mod r */
+    static const FieldT a1(half_scalar("9931322734385697763"));
+    static const FieldT b1(half_scalar("147946756881789319000765030803803410728"));
+    static const FieldT a2(half_scalar("147946756881789319010696353538189108491"));
+    static const FieldT b2(half_scalar("9931322734385697763"));
+
+    /* floor(b2 * 2^256 / r) and floor(b1 * 2^256 / r) */
+    static const half_scalar g1("52538187511802934231");
+    static const half_scalar g2("782660544089080853078787955015628534157");
+
+    /* c1 ~ k * b2 / r and c2 ~ k * b1 / r, then (k1, k2) = (k, 0) - c1 * (a1, -b1) - c2 * (a2, b2) */
+    const half_scalar k_bigint = k.as_bigint();
+    const FieldT c1(glv_round(k_bigint, g1));
+    const FieldT c2(glv_round(k_bigint, g2));
+
+    glv_signed(k - c1 * a1 - c2 * a2, scalar_bits, k1, k1_negative);
+    glv_signed(c1 * b1 - c2 * b2, scalar_bits, k2, k2_negative);
+}
+
+template<typename T, typename FieldT>
+T glv_scalar_mul(const FieldT &k, const T &P, std::false_type)
+{
+    return k * P;
+}
+
+template<typename T, typename FieldT>
+T glv_scalar_mul(const FieldT &k, const T &P, std::true_type)
+{
+    typedef glv_endomorphism<T> glv;
+
+    typename glv::half_scalar k1, k2;
+    bool k1_negative, k2_negative;
+    glv::decompose(k, k1, k1_negative, k2, k2_negative);
+
+    /* Shamir's trick, one doubling per bit of the half scalars */
+    const T P1 = (k1_negative ? -P : P);
+    const T phi_P = glv::apply(P);
+    const T P2 = (k2_negative ? -phi_P : phi_P);
+    const T P12 = P1 + P2;
+
+    T result = T::zero();
+    for (size_t bit = glv::scalar_bits; bit-- > 0; )
+    {
+        result = result.dbl();
+
+        const bool bit1 = k1.test_bit(bit);
+        const bool bit2 = k2.test_bit(bit);
+        if (bit1 && bit2)
+        {
+            result = result + P12;
+        }
+        else if (bit1)
+        {
+            result = result + P1;
+        }
+        else if (bit2)
+        {
+            result = result + P2;
+        }
+    }
+
+    return result;
+}
+
+template<typename T, typename FieldT>
+T glv_scalar_mul(const FieldT &k, const T &P)
+{
+    return glv_scalar_mul<T, FieldT>(k, P, std::integral_constant<bool, glv_endomorphism<T>::enabled>());
+}
+
+} // libsnark
+
+#endif // GLV_TCC_
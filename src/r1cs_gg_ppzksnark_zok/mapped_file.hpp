@@ -0,0 +1,181 @@
+/** @file
+ *****************************************************************************
+
+ Read-only memory mapping of a whole file.
+
+ Pages are faulted in lazily as they are touched. On Emscripten, where files
+ live in memory anyway, the file is read into a heap buffer instead.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace libsnark {
+
+class mapped_file {
+public:
+    mapped_file() : data_(nullptr), size_(0)
+#if defined(_WIN32)
+        , file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+#endif
+    {};
+
+    mapped_file(const mapped_file &other) = delete;
+    mapped_file& operator=(const mapped_file &other) = delete;
+
+    ~mapped_file()
+    {
+        close();
+    }
+
+    /**
+     * Map `path`, returns false if it cannot be opened or mapped.
+     */
+    bool open(const std::string &path)
+    {
+        close();
+
+#if defined(_WIN32)
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (data_ == nullptr)
+        {
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(file_size.QuadPart);
+#elif defined(__EMSCRIPTEN__)
+        std::ifstream fh(path, std::ios::binary | std::ios::ate);
+        if (!fh.is_open())
+        {
+            return false;
+        }
+
+        buffer_.resize(static_cast<size_t>(fh.tellg()));
+        fh.seekg(0);
+        if (buffer_.empty() || !fh.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size()))
+        {
+            buffer_.clear();
+            return false;
+        }
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void *addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return false;
+        }
+
+        data_ = static_cast<const uint8_t*>(addr);
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+
+        return true;
+    }
+
+    void close()
+    {
+#if defined(_WIN32)
+        if (data_ != nullptr)
+        {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_ != nullptr)
+        {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+        if (file_ != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+#elif defined(__EMSCRIPTEN__)
+        std::vector<uint8_t>().swap(buffer_);
+#else
+        if (data_ != nullptr)
+        {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const uint8_t *data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+#if defined(_WIN32)
+    HANDLE file_;
+    HANDLE mapping_;
+#elif defined(__EMSCRIPTEN__)
+    std::vector<uint8_t> buffer_;
+#endif
+};
+
+} // libsnark
+
+#endif // MAPPED_FILE_HPP_
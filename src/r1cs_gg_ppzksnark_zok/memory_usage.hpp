@@ -0,0 +1,141 @@
+/** @file
+ *****************************************************************************
+
+ Peak resident set size of the process, for the prover's metrics and for
+ reporting the memory used by each stage of the out-of-core witness map.
+
+ On Linux the peak can be reset between stages, elsewhere it is the peak
+ since the process started. Windows reports nothing. The peak of the
+ process is the highest of the stages' peaks, so it is kept across the
+ resets of the stages.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef MEMORY_USAGE_HPP_
+#define MEMORY_USAGE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <libff/common/profiling.hpp>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace libsnark {
+
+/**
+ * Peak resident set size in bytes since the last reset, or 0 if unknown.
+ */
+inline size_t peak_rss_since_reset_bytes()
+{
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::stoul(line.substr(6)) * 1024;
+        }
+    }
+    return 0;
+#elif defined(_WIN32)
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/**
+ * The highest peak of the stages before the current one.
+ */
+inline std::atomic<size_t> &peak_rss_earlier_stages()
+{
+    static std::atomic<size_t> peak(0);
+    return peak;
+}
+
+/**
+ * Peak resident set size in bytes since peak_rss_reset(), including
+ * stages which have since restarted the tracking, or 0 if unknown.
+ */
+inline size_t peak_rss_bytes()
+{
+    const size_t peak = peak_rss_since_reset_bytes();
+    const size_t earlier = peak_rss_earlier_stages().load();
+    return peak > earlier ? peak : earlier;
+}
+
+/**
+ * Restart the kernel's tracking of the peak, where supported.
+ */
+inline void peak_rss_clear_refs()
+{
+#if defined(__linux__)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+}
+
+/**
+ * Restart peak tracking from the current resident set size, where supported.
+ */
+inline void peak_rss_reset()
+{
+    peak_rss_clear_refs();
+    peak_rss_earlier_stages().store(0);
+}
+
+/**
+ * Start measuring the peak of a stage. Like its report, only done with
+ * libff's profiling output enabled: the peak is process-wide, resetting it
+ * during concurrent proofs would corrupt their numbers, and the services
+ * running proofs concurrently inhibit profiling.
+ */
+inline void peak_rss_stage_begin()
+{
+    if (!libff::inhibit_profiling_info)
+    {
+        peak_rss_earlier_stages().store(peak_rss_bytes());
+        peak_rss_clear_refs();
+    }
+}
+
+/**
+ * Print the peak resident set size since peak_rss_stage_begin(), unless
+ * profiling output is inhibited.
+ */
+inline void peak_rss_stage_end(const char *stage)
+{
+    if (libff::inhibit_profiling_info)
+    {
+        return;
+    }
+
+    const size_t peak = peak_rss_since_reset_bytes();
+    if (peak != 0)
+    {
+        libff::print_indent(); printf("* Peak RSS (%s): %.1f MiB\n", stage, peak / (1024.0 * 1024.0));
+    }
+}
+
+} // libsnark
+
+#endif // MEMORY_USAGE_HPP_
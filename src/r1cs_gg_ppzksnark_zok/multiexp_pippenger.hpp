@@ -0,0 +1,136 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of interfaces for a Pippenger (bucket method) multi-exponentiation.
+
+ Unlike libff::multi_exp_method_BDLO12, which splits the bases into one chunk
+ per thread and runs the bucket method on each chunk with a window sized to
+ the chunk, this engine sizes the window to the whole input and distributes
+ the (window, range of bases) pairs across threads. Every window is summed
+ once over all bases, so the bucket reduction and the doublings are paid
+ once per window rather than once per chunk.
+
+ The work is scheduled with parallel_for_ranges, so when called from a task
+ of an enclosing parallel region (as the prover does to overlap its stages)
+ the windows are spread over the whole team instead of running on one thread.
+
+ For groups with an endomorphism (alt_bn128 G1, see glv.hpp) every scalar
+ is split into two half-size scalars of the base and of its image, so the
+ windows, and the doublings combining them, are halved.
+
+ With `batch_affine` the buckets of large windows are kept in affine
+ coordinates and filled in rounds of independent additions that share one
+ inversion, see pippenger_window_sum_batch_affine. This only helps when the
+ bases are in special form (USE_MIXED_ADDITION), others are still added in
+ Jacobian coordinates.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef MULTIEXP_PIPPENGER_HPP_
+#define MULTIEXP_PIPPENGER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <libff/algebra/fields/bigint.hpp>
+
+#include <libsnark/knowledge_commitment/knowledge_commitment.hpp>
+
+namespace libsnark {
+
+/**
+ * Window size, in bits, used to split the scalars of a multi-exponentiation
+ * of `num_bases` terms. Grows with ln(num_bases), as in bellman.
+ */
+inline size_t pippenger_window_size(const size_t num_bases);
+
+/**
+ * Return the `c`-bit digit of `scalar` starting at bit `offset`.
+ */
+template<mp_size_t n>
+size_t pippenger_get_digit(const libff::bigint<n> &scalar, const size_t offset, const size_t c);
+
+/**
+ * Computes the sum of scalar_i * base_i using the bucket method.
+ *
+ * The iterators may be std::vector iterators or plain pointers, the scalars
+ * must be field elements (anything with as_bigint() and num_limbs).
+ */
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+T multi_exp_pippenger(BaseIterT vec_start,
+                      BaseIterT vec_end,
+                      ScalarIterT scalar_start,
+                      ScalarIterT scalar_end,
+                      const size_t chunks,
+                      const bool batch_affine = false);
+
+/**
+ * As multi_exp_pippenger, but the scalars are first partitioned by density:
+ * zeros are skipped, the bases of ones are summed with batch_affine_sum, and
+ * only the remaining scalars go through the bucket method. The counts are
+ * reported in the "Partition scalars by density" profiling block.
+ */
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+T multi_exp_pippenger_with_mixed_addition(BaseIterT vec_start,
+                                          BaseIterT vec_end,
+                                          ScalarIterT scalar_start,
+                                          ScalarIterT scalar_end,
+                                          const size_t chunks,
+                                          const bool batch_affine = false);
+
+/**
+ * Knowledge-commitment counterpart of multi_exp_pippenger_with_mixed_addition,
+ * mirroring kc_multi_exp_with_mixed_addition over the sparse vector `vec`
+ * restricted to indices in [min_idx, max_idx).
+ *
+ * KCVectorT is a knowledge_commitment_vector<T1, T2>, or any type with the
+ * same sorted `indices` and `values` members.
+ *
+ * With `batch_affine` the two components are summed separately, each with
+ * affine buckets.
+ */
+template<typename T1, typename T2, typename FieldT, typename KCVectorT, typename ScalarIterT>
+knowledge_commitment<T1, T2> kc_multi_exp_pippenger_with_mixed_addition(const KCVectorT &vec,
+                                                                        const size_t min_idx,
+                                                                        const size_t max_idx,
+                                                                        ScalarIterT scalar_start,
+                                                                        ScalarIterT scalar_end,
+                                                                        const size_t chunks,
+                                                                        const bool batch_affine = false);
+
+/**
+ * Number of members of a batch over `num_bases` bases whose buckets, at the
+ * window of a single multi-exponentiation, still fit in cache together.
+ */
+inline size_t pippenger_batch_group_size(const size_t num_bases);
+
+/**
+ * Computes sum_i scalar_{k,i} * base_i for every k, where the scalars of
+ * member k start at scalar_starts[k] and are as many as the bases.
+ *
+ * The window is the one multi_exp_pippenger would use. The members are taken
+ * in groups of pippenger_batch_group_size, the bases are visited in blocks,
+ * and each block is applied to every member of the group before moving on,
+ * so the bases are read from memory once per group rather than once per
+ * member. Only one group's scalars are converted out of Montgomery form at a
+ * time.
+ *
+ * Zero digits are skipped, but the scalars aren't partitioned by density nor
+ * split with the endomorphism; at these window sizes that mostly saves the
+ * bucket reductions. When the window is too large for two members' buckets,
+ * each member is evaluated by multi_exp_pippenger instead.
+ */
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+std::vector<T> multi_exp_pippenger_batch(BaseIterT vec_start,
+                                         BaseIterT vec_end,
+                                         const std::vector<ScalarIterT> &scalar_starts,
+                                         const size_t chunks);
+
+} // libsnark
+
+#include "r1cs_gg_ppzksnark_zok/multiexp_pippenger.tcc"
+
+#endif // MULTIEXP_PIPPENGER_HPP_
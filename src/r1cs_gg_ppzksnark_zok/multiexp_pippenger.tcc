@@ -0,0 +1,743 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of interfaces for a Pippenger (bucket method) multi-exponentiation.
+
+ See multiexp_pippenger.hpp .
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef MULTIEXP_PIPPENGER_TCC_
+#define MULTIEXP_PIPPENGER_TCC_
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <libff/common/profiling.hpp>
+#include <libff/common/utils.hpp>
+
+#include "r1cs_gg_ppzksnark_zok/batch_affine.hpp"
+#include "r1cs_gg_ppzksnark_zok/glv.hpp"
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+
+namespace libsnark {
+
+/* Scalars converted out of Montgomery form per task */
+const size_t pippenger_scalar_grain = 1ul << 14;
+
+/* Bases applied to every member of a batch before moving to the next block */
+const size_t pippenger_batch_block = 1ul << 8;
+
+/* Upper bound on the buckets of the members of a batch sharing a pass over
+   the bases, per task */
+const size_t pippenger_batch_max_buckets = 1ul << 15;
+
+/* Bucket additions sharing one inversion in batch-affine accumulation */
+const size_t pippenger_affine_round = 1ul << 9;
+
+/* Below this window size there are too few buckets for the additions of a
+   round to be independent, and the inversions aren't amortized */
+const size_t pippenger_affine_min_window = 8;
+
+inline size_t pippenger_window_size(const size_t num_bases)
+{
+    if (num_bases < 32)
+    {
+        return 3;
+    }
+
+    return static_cast<size_t>(std::ceil(std::log(static_cast<double>(num_bases))));
+}
+
+inline size_t pippenger_batch_group_size(const size_t num_bases)
+{
+    return pippenger_batch_max_buckets >> pippenger_window_size(num_bases);
+}
+
+template<mp_size_t n>
+size_t pippenger_get_digit(const libff::bigint<n> &scalar, const size_t offset, const size_t c)
+{
+    const size_t limb_bits = GMP_NUMB_BITS;
+    const size_t limb = offset / limb_bits;
+    const size_t shift = offset % limb_bits;
+
+    if (limb >= static_cast<size_t>(n))
+    {
+        return 0;
+    }
+
+    mp_limb_t digit = scalar.data[limb] >> shift;
+    if (shift + c > limb_bits && limb + 1 < static_cast<size_t>(n))
+    {
+        digit |= scalar.data[limb + 1] << (limb_bits - shift);
+    }
+
+    return static_cast<size_t>(digit & ((mp_limb_t(1) << c) - 1));
+}
+
+/**
+ * sum_j (j+1) * buckets[j], via running sums from the top bucket down
+ */
+template<typename T>
+T pippenger_bucket_sum(const T *buckets, const size_t num_buckets)
+{
+    T running_sum = T::zero();
+    T result = T::zero();
+    for (size_t j = num_buckets; j-- > 0; )
+    {
+        running_sum = running_sum + buckets[j];
+        result = result + running_sum;
+    }
+
+    return result;
+}
+
+/**
+ * Sum of digit_i * base(i) for a single window, where digit_i is the `c`-bit
+ * digit of scalar_i at bit `offset`.
+ */
+template<typename T, mp_size_t n, typename BaseFuncT>
+T pippenger_window_sum(const BaseFuncT &base,
+                       const libff::bigint<n> *scalars,
+                       const size_t begin,
+                       const size_t end,
+                       const size_t offset,
+                       const size_t c)
+{
+    /* bucket j holds the bases whose digit is j+1 */
+    std::vector<T> buckets((1ul << c) - 1, T::zero());
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const size_t digit = pippenger_get_digit<n>(scalars[i], offset, c);
+        if (digit == 0)
+        {
+            continue;
+        }
+
+#ifdef USE_MIXED_ADDITION
+        buckets[digit - 1] = buckets[digit - 1].mixed_add(base(i));
+#else
+        buckets[digit - 1] = buckets[digit - 1] + base(i);
+#endif
+    }
+
+    return pippenger_bucket_sum<T>(buckets.data(), buckets.size());
+}
+
+/**
+ * Groups without affine coordinates keep the Jacobian buckets.
+ */
+template<typename T, mp_size_t n, typename BaseFuncT>
+T pippenger_window_sum_batch_affine(const BaseFuncT &base,
+                                    const libff::bigint<n> *scalars,
+                                    const size_t begin,
+                                    const size_t end,
+                                    const size_t offset,
+                                    const size_t c,
+                                    std::false_type)
+{
+    return pippenger_window_sum<T, n>(base, scalars, begin, end, offset, c);
+}
+
+/**
+ * As pippenger_window_sum, but the buckets are kept in affine coordinates.
+ *
+ * Additions are queued in rounds touching each bucket at most once, and all
+ * the additions of a round share one inversion, as in batch_affine.hpp.
+ * A base for a bucket already in the round waits for the next one, at most
+ * once. Bases not in special form, doublings and cancellations go to
+ * Jacobian buckets.
+ */
+template<typename T, mp_size_t n, typename BaseFuncT>
+T pippenger_window_sum_batch_affine(const BaseFuncT &base,
+                                    const libff::bigint<n> *scalars,
+                                    const size_t begin,
+                                    const size_t end,
+                                    const size_t offset,
+                                    const size_t c,
+                                    std::true_type)
+{
+    typedef typename std::decay<decltype(T::zero().X)>::type CoordT;
+    typedef std::pair<size_t, T> addition;
+    const CoordT coord_one = CoordT::one();
+    const size_t num_buckets = (1ul << c) - 1;
+
+    /* bucket j holds the bases whose digit is j+1, split between affine[j]
+       (when filled[j]) and jacobian[j] */
+    std::vector<T> affine(num_buckets);
+    std::vector<char> filled(num_buckets, 0);
+    std::vector<T> jacobian(num_buckets, T::zero());
+
+    std::vector<addition> round;
+    std::vector<char> in_round(num_buckets, 0);
+    std::vector<CoordT> denominators;
+    std::vector<CoordT> prefix;
+    std::vector<addition> deferred;
+    std::vector<addition> retry;
+
+    /* A round holds at most one addition per bucket, so with few buckets it
+       is flushed when half of them are in it, or when enough bases wait for
+       it, instead of deferring most of the bases to the next rounds */
+    const size_t round_size = std::max<size_t>(1, std::min(pippenger_affine_round, num_buckets / 2));
+    round.reserve(round_size);
+
+    const auto add = [&](const size_t j, const T &p) {
+        if (p.Z != coord_one)
+        {
+            jacobian[j] = jacobian[j] + p;
+        }
+        else if (in_round[j])
+        {
+            deferred.emplace_back(j, p);
+        }
+        else if (!filled[j])
+        {
+            affine[j] = p;
+            filled[j] = 1;
+        }
+        else if (p.X == affine[j].X)
+        {
+            /* P == Q or P == -Q */
+            jacobian[j] = jacobian[j].mixed_add(p);
+        }
+        else
+        {
+            round.emplace_back(j, p);
+            in_round[j] = 1;
+        }
+    };
+
+    const auto flush = [&]() {
+        denominators.resize(round.size());
+        prefix.resize(round.size());
+
+        /* prefix[k] = product of the denominators before addition k */
+        CoordT running = coord_one;
+        for (size_t k = 0; k < round.size(); ++k)
+        {
+            prefix[k] = running;
+            denominators[k] = round[k].second.X - affine[round[k].first].X;
+            running = running * denominators[k];
+        }
+
+        CoordT inverse = running.inverse();
+        for (size_t k = round.size(); k-- > 0; )
+        {
+            const T &p = round[k].second;
+            T &b = affine[round[k].first];
+
+            const CoordT d_inverse = inverse * prefix[k];
+            inverse = inverse * denominators[k];
+
+            const CoordT lambda = (p.Y - b.Y) * d_inverse;
+            const CoordT x = lambda.squared() - b.X - p.X;
+            b.Y = lambda * (b.X - x) - b.Y;
+            b.X = x;
+            in_round[round[k].first] = 0;
+        }
+        round.clear();
+
+        /* the deferred bases now have their buckets free, those which would
+           wait again for a bucket go to its Jacobian sum instead */
+        retry.swap(deferred);
+        for (const addition &a : retry)
+        {
+            if (in_round[a.first])
+            {
+                jacobian[a.first] = jacobian[a.first].mixed_add(a.second);
+            }
+            else
+            {
+                add(a.first, a.second);
+            }
+        }
+        retry.clear();
+    };
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const size_t digit = pippenger_get_digit<n>(scalars[i], offset, c);
+        if (digit == 0)
+        {
+            continue;
+        }
+
+        add(digit - 1, base(i));
+        if (round.size() >= round_size || deferred.size() >= round_size)
+        {
+            flush();
+        }
+    }
+
+    while (!round.empty())
+    {
+        flush();
+    }
+
+    for (size_t j = 0; j < num_buckets; ++j)
+    {
+        if (filled[j])
+        {
+            jacobian[j] = jacobian[j].mixed_add(affine[j]);
+        }
+    }
+
+    return pippenger_bucket_sum<T>(jacobian.data(), jacobian.size());
+}
+
+/**
+ * The bucket method over `length` bases, given by base(i), and scalars of
+ * at most `scalar_bits` bits.
+ */
+template<typename T, mp_size_t n, typename BaseFuncT>
+T pippenger_sum(const BaseFuncT &base,
+                const libff::bigint<n> *scalars,
+                const size_t length,
+                const size_t scalar_bits,
+                const size_t chunks,
+                const bool batch_affine)
+{
+    const size_t c = pippenger_window_size(length);
+    const bool affine_buckets = batch_affine && c >= pippenger_affine_min_window;
+    const size_t num_windows = (scalar_bits + c - 1) / c;
+
+    /* When there are more threads than windows, also split the bases into
+       ranges, but keep each range large enough to amortize its buckets. */
+    size_t num_ranges = (chunks + num_windows - 1) / num_windows;
+    num_ranges = std::max<size_t>(1, std::min(num_ranges, length >> c));
+    const size_t range_size = (length + num_ranges - 1) / num_ranges;
+
+    std::vector<T> partial(num_windows * num_ranges, T::zero());
+
+    parallel_for_ranges(num_windows * num_ranges, 1, [&](const size_t task, const size_t) {
+        const size_t window = task / num_ranges;
+        const size_t range_start = (task % num_ranges) * range_size;
+        const size_t range_end = std::min(length, range_start + range_size);
+        if (range_start >= range_end)
+        {
+            return;
+        }
+
+        if (affine_buckets)
+        {
+            partial[task] = pippenger_window_sum_batch_affine<T, n>(base, scalars, range_start, range_end, window * c, c,
+                                                                    std::integral_constant<bool, batch_affine_supported<T>::value>());
+        }
+        else
+        {
+            partial[task] = pippenger_window_sum<T, n>(base, scalars, range_start, range_end, window * c, c);
+        }
+    });
+
+    /* result = sum_w 2^(w*c) * window_w, from the most significant window down */
+    T result = T::zero();
+    for (size_t window = num_windows; window-- > 0; )
+    {
+        for (size_t i = 0; i < c; ++i)
+        {
+            result = result.dbl();
+        }
+
+        for (size_t r = 0; r < num_ranges; ++r)
+        {
+            result = result + partial[window * num_ranges + r];
+        }
+    }
+
+    return result;
+}
+
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+T pippenger_multi_exp(BaseIterT vec_start,
+                      const size_t length,
+                      ScalarIterT scalar_start,
+                      const size_t chunks,
+                      const bool batch_affine,
+                      std::false_type)
+{
+    const mp_size_t n = FieldT::num_limbs;
+    std::vector<libff::bigint<n> > bn_scalars(length);
+    parallel_for_ranges(length, pippenger_scalar_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            bn_scalars[i] = (*(scalar_start + i)).as_bigint();
+        }
+    });
+
+    return pippenger_sum<T, n>([&](const size_t i) -> const T& { return *(vec_start + i); },
+                               bn_scalars.data(), length, FieldT::size_in_bits(), chunks, batch_affine);
+}
+
+/**
+ * With the endomorphism of T: the scalar k_i of base P_i is split into
+ * k1_i + k2_i * lambda, and the bucket method runs over the 2 * length
+ * bases +-P_i and +-phi(P_i) with the half scalars, in half the windows.
+ */
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+T pippenger_multi_exp(BaseIterT vec_start,
+                      const size_t length,
+                      ScalarIterT scalar_start,
+                      const size_t chunks,
+                      const bool batch_affine,
+                      std::true_type)
+{
+    typedef glv_endomorphism<T> glv;
+
+    /* the half scalars of base i are at i and length + i */
+    const mp_size_t n = FieldT::num_limbs;
+    std::vector<libff::bigint<n> > bn_scalars(2 * length);
+    std::vector<char> negative(2 * length);
+    parallel_for_ranges(length, pippenger_scalar_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            bool k1_negative, k2_negative;
+            glv::decompose(*(scalar_start + i), bn_scalars[i], k1_negative, bn_scalars[length + i], k2_negative);
+            negative[i] = k1_negative;
+            negative[length + i] = k2_negative;
+        }
+    });
+
+    /* the endomorphism and negation keep Z, so special bases stay special */
+    return pippenger_sum<T, n>([&](const size_t i) -> T {
+                                   const T &P = *(vec_start + (i < length ? i : i - length));
+                                   const T Q = (i < length ? P : glv::apply(P));
+                                   return (negative[i] ? -Q : Q);
+                               },
+                               bn_scalars.data(), 2 * length, glv::scalar_bits, chunks, batch_affine);
+}
+
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+T multi_exp_pippenger(BaseIterT vec_start,
+                      BaseIterT vec_end,
+                      ScalarIterT scalar_start,
+                      ScalarIterT scalar_end,
+                      const size_t chunks,
+                      const bool batch_affine)
+{
+    const size_t length = std::distance(vec_start, vec_end);
+    assert(static_cast<size_t>(std::distance(scalar_start, scalar_end)) >= length);
+    libff::UNUSED(scalar_end);
+
+    if (length == 0)
+    {
+        return T::zero();
+    }
+
+    return pippenger_multi_exp<T, FieldT>(vec_start, length, scalar_start, chunks, batch_affine,
+                                          std::integral_constant<bool, glv_endomorphism<T>::enabled>());
+}
+
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+T multi_exp_pippenger_with_mixed_addition(BaseIterT vec_start,
+                                          BaseIterT vec_end,
+                                          ScalarIterT scalar_start,
+                                          ScalarIterT scalar_end,
+                                          const size_t chunks,
+                                          const bool batch_affine)
+{
+    const size_t length = std::distance(vec_start, vec_end);
+    assert(static_cast<size_t>(std::distance(scalar_start, scalar_end)) == length);
+    libff::UNUSED(scalar_end);
+
+    libff::enter_block("Partition scalars by density");
+
+    const FieldT zero = FieldT::zero();
+    const FieldT one = FieldT::one();
+
+    /* Each task lists the positions of its ones and general scalars */
+    const size_t num_tasks = (length + pippenger_scalar_grain - 1) / pippenger_scalar_grain;
+    std::vector<std::vector<size_t> > task_ones(num_tasks);
+    std::vector<std::vector<size_t> > task_others(num_tasks);
+    parallel_for_ranges(length, pippenger_scalar_grain, [&](const size_t begin, const size_t end) {
+        const size_t task = begin / pippenger_scalar_grain;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const FieldT &scalar = *(scalar_start + i);
+            if (scalar == zero)
+            {
+                continue;
+            }
+
+            if (scalar == one)
+            {
+                task_ones[task].emplace_back(i);
+            }
+            else
+            {
+                task_others[task].emplace_back(i);
+            }
+        }
+    });
+
+    /* Offsets of each task's entries in the gathered vectors */
+    std::vector<size_t> ones_offset(num_tasks + 1, 0);
+    std::vector<size_t> others_offset(num_tasks + 1, 0);
+    for (size_t task = 0; task < num_tasks; ++task)
+    {
+        ones_offset[task + 1] = ones_offset[task] + task_ones[task].size();
+        others_offset[task + 1] = others_offset[task] + task_others[task].size();
+    }
+
+    const size_t num_add = ones_offset[num_tasks];
+    const size_t num_other = others_offset[num_tasks];
+    const size_t num_skip = length - num_add - num_other;
+
+    std::vector<T> ones_bases(num_add);
+    std::vector<T> g(num_other);
+    std::vector<FieldT> p(num_other);
+    parallel_for_ranges(num_tasks, 1, [&](const size_t task, const size_t) {
+        for (size_t j = 0; j < task_ones[task].size(); ++j)
+        {
+            ones_bases[ones_offset[task] + j] = *(vec_start + task_ones[task][j]);
+        }
+        for (size_t j = 0; j < task_others[task].size(); ++j)
+        {
+            g[others_offset[task] + j] = *(vec_start + task_others[task][j]);
+            p[others_offset[task] + j] = *(scalar_start + task_others[task][j]);
+        }
+    });
+
+    const size_t total = std::max<size_t>(1, length);
+    if (!libff::inhibit_profiling_info)
+    {
+        libff::print_indent(); printf("* Elements of w skipped: %zu (%0.2f%%)\n", num_skip, 100.*num_skip/total);
+        libff::print_indent(); printf("* Elements of w processed with special addition: %zu (%0.2f%%)\n", num_add, 100.*num_add/total);
+        libff::print_indent(); printf("* Elements of w remaining: %zu (%0.2f%%)\n", num_other, 100.*num_other/total);
+    }
+
+    libff::leave_block("Partition scalars by density");
+
+    libff::enter_block("Sum bases of unit scalars");
+    const T acc = batch_affine_sum<T>(std::move(ones_bases));
+    libff::leave_block("Sum bases of unit scalars");
+
+    return acc + multi_exp_pippenger<T, FieldT>(g.cbegin(), g.cend(), p.cbegin(), p.cend(), chunks, batch_affine);
+}
+
+template<typename T1, typename T2, typename FieldT, typename KCVectorT, typename ScalarIterT>
+knowledge_commitment<T1, T2> kc_multi_exp_pippenger_with_mixed_addition(const KCVectorT &vec,
+                                                                        const size_t min_idx,
+                                                                        const size_t max_idx,
+                                                                        ScalarIterT scalar_start,
+                                                                        ScalarIterT scalar_end,
+                                                                        const size_t chunks,
+                                                                        const bool batch_affine)
+{
+    libff::enter_block("Process scalar vector");
+    auto index_it = std::lower_bound(vec.indices.begin(), vec.indices.end(), min_idx);
+    const size_t offset = index_it - vec.indices.begin();
+
+    auto value_it = vec.values.begin() + offset;
+
+    const FieldT zero = FieldT::zero();
+    const FieldT one = FieldT::one();
+
+    std::vector<FieldT> p;
+    std::vector<knowledge_commitment<T1, T2> > g;
+
+    knowledge_commitment<T1, T2> acc = knowledge_commitment<T1, T2>::zero();
+
+    size_t num_skip = 0;
+    size_t num_add = 0;
+    size_t num_other = 0;
+
+    const size_t scalar_length = std::distance(scalar_start, scalar_end);
+    libff::UNUSED(scalar_length);
+
+    while (index_it != vec.indices.end() && *index_it < max_idx)
+    {
+        const size_t scalar_position = (*index_it) - min_idx;
+        assert(scalar_position < scalar_length);
+
+        const FieldT scalar = *(scalar_start + scalar_position);
+
+        if (scalar == zero)
+        {
+            ++num_skip;
+        }
+        else if (scalar == one)
+        {
+#ifdef USE_MIXED_ADDITION
+            acc.g = acc.g.mixed_add(value_it->g);
+            acc.h = acc.h.mixed_add(value_it->h);
+#else
+            acc.g = acc.g + value_it->g;
+            acc.h = acc.h + value_it->h;
+#endif
+            ++num_add;
+        }
+        else
+        {
+            p.emplace_back(scalar);
+            g.emplace_back(*value_it);
+            ++num_other;
+        }
+
+        ++index_it;
+        ++value_it;
+    }
+
+    const size_t total = std::max<size_t>(1, num_skip + num_add + num_other);
+    if (!libff::inhibit_profiling_info)
+    {
+        libff::print_indent(); printf("* Elements of w skipped: %zu (%0.2f%%)\n", num_skip, 100.*num_skip/total);
+        libff::print_indent(); printf("* Elements of w processed with special addition: %zu (%0.2f%%)\n", num_add, 100.*num_add/total);
+        libff::print_indent(); printf("* Elements of w remaining: %zu (%0.2f%%)\n", num_other, 100.*num_other/total);
+    }
+
+    libff::leave_block("Process scalar vector");
+
+    if (batch_affine)
+    {
+        /* knowledge commitments have no coordinates of their own, so each
+           component gets its own affine buckets */
+        std::vector<T1> g_components(g.size());
+        std::vector<T2> h_components(g.size());
+        for (size_t i = 0; i < g.size(); ++i)
+        {
+            g_components[i] = g[i].g;
+            h_components[i] = g[i].h;
+        }
+
+        return acc + knowledge_commitment<T1, T2>(
+            multi_exp_pippenger<T1, FieldT>(g_components.cbegin(), g_components.cend(), p.cbegin(), p.cend(), chunks, true),
+            multi_exp_pippenger<T2, FieldT>(h_components.cbegin(), h_components.cend(), p.cbegin(), p.cend(), chunks, true));
+    }
+
+    return acc + multi_exp_pippenger<knowledge_commitment<T1, T2>, FieldT>(g.cbegin(), g.cend(), p.cbegin(), p.cend(), chunks);
+}
+
+template<typename T, typename FieldT, typename BaseIterT, typename ScalarIterT>
+std::vector<T> multi_exp_pippenger_batch(BaseIterT vec_start,
+                                         BaseIterT vec_end,
+                                         const std::vector<ScalarIterT> &scalar_starts,
+                                         const size_t chunks)
+{
+    const size_t length = std::distance(vec_start, vec_end);
+    const size_t batch_size = scalar_starts.size();
+
+    std::vector<T> results(batch_size, T::zero());
+    if (length == 0 || batch_size == 0)
+    {
+        return results;
+    }
+
+    /* With large windows the buckets of one member already fill the budget,
+       and its bucket method is compute-bound, so every member gets the
+       single-proof engine and its endomorphism instead. */
+    const size_t group_size = pippenger_batch_group_size(length);
+    if (group_size < 2)
+    {
+        for (size_t k = 0; k < batch_size; ++k)
+        {
+            results[k] = multi_exp_pippenger<T, FieldT>(vec_start, vec_end, scalar_starts[k], scalar_starts[k] + length, chunks);
+        }
+        return results;
+    }
+
+    /* The window of a single multi-exponentiation, whatever the batch size */
+    const size_t c = pippenger_window_size(length);
+    const size_t num_windows = (FieldT::size_in_bits() + c - 1) / c;
+    const size_t num_buckets = (1ul << c) - 1;
+
+    size_t num_ranges = (chunks + num_windows - 1) / num_windows;
+    num_ranges = std::max<size_t>(1, std::min(num_ranges, length >> c));
+    const size_t range_size = (length + num_ranges - 1) / num_ranges;
+
+    const mp_size_t n = FieldT::num_limbs;
+    std::vector<libff::bigint<n> > bn_scalars;
+    std::vector<T> partial;
+
+    for (size_t group_start = 0; group_start < batch_size; group_start += group_size)
+    {
+        const size_t members = std::min(group_size, batch_size - group_start);
+
+        /* bn_scalars[m * length + i] is the i-th scalar of the group's member m,
+           only one group is converted at a time */
+        bn_scalars.resize(members * length);
+        parallel_for_ranges(members * length, pippenger_scalar_grain, [&](const size_t begin, const size_t end) {
+            for (size_t idx = begin; idx < end; ++idx)
+            {
+                bn_scalars[idx] = (*(scalar_starts[group_start + idx / length] + (idx % length))).as_bigint();
+            }
+        });
+
+        /* partial[task * members + m] is the window sum of member m */
+        partial.assign(num_windows * num_ranges * members, T::zero());
+
+        parallel_for_ranges(num_windows * num_ranges, 1, [&](const size_t task, const size_t) {
+            const size_t window = task / num_ranges;
+            const size_t range_start = (task % num_ranges) * range_size;
+            const size_t range_end = std::min(length, range_start + range_size);
+            if (range_start >= range_end)
+            {
+                return;
+            }
+
+            std::vector<T> buckets(members * num_buckets, T::zero());
+
+            for (size_t block_start = range_start; block_start < range_end; block_start += pippenger_batch_block)
+            {
+                const size_t block_end = std::min(range_end, block_start + pippenger_batch_block);
+
+                for (size_t m = 0; m < members; ++m)
+                {
+                    T *member_buckets = &buckets[m * num_buckets];
+                    const libff::bigint<n> *member_scalars = &bn_scalars[m * length];
+
+                    for (size_t i = block_start; i < block_end; ++i)
+                    {
+                        const size_t digit = pippenger_get_digit<n>(member_scalars[i], window * c, c);
+                        if (digit == 0)
+                        {
+                            continue;
+                        }
+
+#ifdef USE_MIXED_ADDITION
+                        member_buckets[digit - 1] = member_buckets[digit - 1].mixed_add(*(vec_start + i));
+#else
+                        member_buckets[digit - 1] = member_buckets[digit - 1] + *(vec_start + i);
+#endif
+                    }
+                }
+            }
+
+            for (size_t m = 0; m < members; ++m)
+            {
+                partial[task * members + m] = pippenger_bucket_sum<T>(&buckets[m * num_buckets], num_buckets);
+            }
+        });
+
+        parallel_for_ranges(members, 1, [&](const size_t m, const size_t) {
+            T result = T::zero();
+            for (size_t window = num_windows; window-- > 0; )
+            {
+                for (size_t i = 0; i < c; ++i)
+                {
+                    result = result.dbl();
+                }
+
+                for (size_t r = 0; r < num_ranges; ++r)
+                {
+                    result = result + partial[(window * num_ranges + r) * members + m];
+                }
+            }
+            results[group_start + m] = result;
+        });
+    }
+
+    return results;
+}
+
+} // libsnark
+
+#endif // MULTIEXP_PIPPENGER_TCC_
@@ -0,0 +1,272 @@
+/** @file
+ *****************************************************************************
+
+ Helpers for running loops on the OpenMP thread team, either as a
+ worksharing loop or as tasks when already executing inside a team.
+
+ The prover overlaps its stages by running them as OpenMP tasks of a single
+ parallel region (see r1cs_gg_ppzksnark_zok_prover). Nested `omp parallel for`
+ regions inside those tasks would run on one thread only, so the kernels used
+ by the stages go through `parallel_for_ranges` instead, which turns their
+ iterations into tasks that any idle thread of the team can steal.
+
+ parallel_thread_scope sets the size of the teams opened by a thread, and
+ can pin them to the CPUs of one NUMA node. Memory is placed on the node of
+ the thread that first touches it, so a prover whose threads stay on one
+ node, with its key loaded or faulted in by them, only reads local memory.
+ On hosts with several nodes, run one pinned prover per node.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef R1CS_GG_PPZKSNARK_ZOK_PARALLEL_HPP_
+#define R1CS_GG_PPZKSNARK_ZOK_PARALLEL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace libsnark {
+
+/**
+ * Calls body(begin, end) for consecutive sub-ranges of [0, n) holding at most
+ * `grain` elements each, in parallel.
+ *
+ * Outside of a parallel region this opens one, from inside a parallel region
+ * each sub-range becomes an OpenMP task and the call returns once all of
+ * them have completed.
+ */
+template<typename FuncT>
+void parallel_for_ranges(const size_t n, const size_t grain, const FuncT &body)
+{
+    const size_t step = std::max<size_t>(1, grain);
+    const size_t num_ranges = (n + step - 1) / step;
+
+#ifdef MULTICORE
+    if (num_ranges > 1)
+    {
+        const FuncT *body_ptr = &body;
+
+        if (omp_in_parallel())
+        {
+            for (size_t i = 0; i < num_ranges; ++i)
+            {
+#pragma omp task firstprivate(i, body_ptr)
+                (*body_ptr)(i * step, std::min(n, (i + 1) * step));
+            }
+#pragma omp taskwait
+        }
+        else
+        {
+#pragma omp parallel for schedule(dynamic)
+            for (size_t i = 0; i < num_ranges; ++i)
+            {
+                (*body_ptr)(i * step, std::min(n, (i + 1) * step));
+            }
+        }
+
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < num_ranges; ++i)
+    {
+        body(i * step, std::min(n, (i + 1) * step));
+    }
+}
+
+/**
+ * Number of threads available to parallel_for_ranges from the calling context.
+ */
+inline size_t parallel_num_threads()
+{
+#ifdef MULTICORE
+    return omp_in_parallel() ? omp_get_num_threads() : omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/**
+ * Index of the calling thread within its team.
+ */
+inline size_t parallel_thread_num()
+{
+#ifdef MULTICORE
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Parse a Linux CPU list, such as "0-3,8,10-11". Returns false if malformed.
+ */
+inline bool parallel_parse_cpu_list(const std::string &list, std::vector<int> &cpus)
+{
+    cpus.clear();
+
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        item.erase(item.find_last_not_of(" \n") + 1);
+        if (item.empty())
+        {
+            continue;
+        }
+
+        char *end;
+        const long first = strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-')
+        {
+            last = strtol(end + 1, &end, 10);
+        }
+        if (*end != '\0' || first < 0 || last < first)
+        {
+            return false;
+        }
+
+        for (long cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    return true;
+}
+
+/**
+ * The CPUs of NUMA node `node`. Returns false if it is unknown, or this
+ * isn't Linux.
+ */
+inline bool parallel_numa_node_cpus(const int node, std::vector<int> &cpus)
+{
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!std::getline(in, list))
+    {
+        return false;
+    }
+
+    return parallel_parse_cpu_list(list, cpus) && !cpus.empty();
+}
+
+/**
+ * For the lifetime of the object, the OpenMP regions opened by the calling
+ * thread have `num_threads` threads (0 keeps the current setting), and with
+ * a `numa_node` of 0 or more those threads are pinned to the node's CPUs.
+ *
+ * The threads of a team are pinned by running a region of that size, OpenMP
+ * reuses them for the regions which follow. Their previous affinity is
+ * restored when the scope ends. Pinning is only supported on Linux, where
+ * it fails with a warning if the node doesn't exist.
+ */
+class parallel_thread_scope {
+public:
+    parallel_thread_scope(const size_t num_threads, const int numa_node = -1) :
+        saved_max_threads_(0)
+    {
+#ifdef MULTICORE
+        saved_max_threads_ = omp_get_max_threads();
+        if (num_threads > 0)
+        {
+            omp_set_num_threads(static_cast<int>(num_threads));
+        }
+#endif
+
+        if (numa_node < 0)
+        {
+            return;
+        }
+
+#if defined(__linux__)
+        std::vector<int> cpus;
+        if (!parallel_numa_node_cpus(numa_node, cpus))
+        {
+            std::cerr << "Warning: NUMA node " << numa_node << " not found, threads are not pinned" << std::endl;
+            return;
+        }
+
+        cpu_set_t node_set;
+        CPU_ZERO(&node_set);
+        for (const int cpu : cpus)
+        {
+            if (cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &node_set);
+            }
+        }
+
+        saved_masks_.resize(parallel_num_threads());
+        saved_.assign(saved_masks_.size(), 0);
+#ifdef MULTICORE
+#pragma omp parallel num_threads(saved_masks_.size())
+#endif
+        {
+            const size_t i = parallel_thread_num();
+            if (i < saved_masks_.size()
+             && sched_getaffinity(0, sizeof(cpu_set_t), &saved_masks_[i]) == 0
+             && sched_setaffinity(0, sizeof(cpu_set_t), &node_set) == 0)
+            {
+                saved_[i] = 1;
+            }
+        }
+#else
+        std::cerr << "Warning: pinning to a NUMA node is not supported on this platform" << std::endl;
+#endif
+    }
+
+    ~parallel_thread_scope()
+    {
+#if defined(__linux__)
+        if (!saved_masks_.empty())
+        {
+#ifdef MULTICORE
+#pragma omp parallel num_threads(saved_masks_.size())
+#endif
+            {
+                const size_t i = parallel_thread_num();
+                if (i < saved_masks_.size() && saved_[i])
+                {
+                    sched_setaffinity(0, sizeof(cpu_set_t), &saved_masks_[i]);
+                }
+            }
+        }
+#endif
+
+#ifdef MULTICORE
+        omp_set_num_threads(saved_max_threads_);
+#endif
+    }
+
+    parallel_thread_scope(const parallel_thread_scope &other) = delete;
+    parallel_thread_scope& operator=(const parallel_thread_scope &other) = delete;
+
+private:
+    int saved_max_threads_;
+#if defined(__linux__)
+    std::vector<cpu_set_t> saved_masks_;
+    std::vector<char> saved_;
+#endif
+};
+
+} // libsnark
+
+#endif // R1CS_GG_PPZKSNARK_ZOK_PARALLEL_HPP_
@@ -0,0 +1,402 @@
+/** @file
+ *****************************************************************************
+
+ Structured measurements of a proof, for tracking the prover's latency
+ without parsing libff's profiling output.
+
+ The prover fills a prover_metrics when one is passed in its options, or
+ when the ETHSNARKS_PROVER_METRICS environment variable names a file: each
+ proof then appends one JSON line to it, or rewrites it in the Prometheus
+ text format when the name ends with ".prom" (for node_exporter's textfile
+ collector, which expects the file to be replaced atomically), with the
+ last proof of every key.
+
+ Every stage records when it started relative to the proof, how long it
+ took, and for the multi-exponentiations the number of terms, how many of
+ their scalars are 0 or 1, and the bytes of bases and scalars read. The
+ witness map records the size of its evaluation domain. Thread utilization
+ is the CPU time of the process during the proof over the wall time of the
+ whole thread team.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef PROVER_METRICS_HPP_
+#define PROVER_METRICS_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "r1cs_gg_ppzksnark_zok/memory_usage.hpp"
+
+namespace libsnark {
+
+/* Environment variable naming the file the prover exports its metrics to */
+const char *const prover_metrics_env = "ETHSNARKS_PROVER_METRICS";
+
+enum prover_stage {
+    prover_stage_witness_map,
+    prover_stage_H,
+    prover_stage_A,
+    prover_stage_B,
+    prover_stage_L,
+    prover_num_stages
+};
+
+inline const char *prover_stage_name(const size_t stage)
+{
+    static const char *names[prover_num_stages] = {"witness_map", "H", "A", "B", "L"};
+    return names[stage];
+}
+
+/**
+ * Measurements of one stage of a proof.
+ */
+struct prover_stage_metrics {
+    double start_seconds;   // since the proof started
+    double seconds;
+    size_t msm_size;        // terms of the multi-exponentiation
+    size_t msm_zeros;       // terms with scalar 0
+    size_t msm_ones;        // terms with scalar 1
+    size_t bytes;           // bases and scalars read
+    size_t domain_size;     // evaluation domain of the witness map
+
+    prover_stage_metrics() :
+        start_seconds(0), seconds(0), msm_size(0), msm_zeros(0), msm_ones(0), bytes(0), domain_size(0)
+    {}
+};
+
+/**
+ * Measurements of one proof.
+ *
+ * The stages may run concurrently, each only writes its own entry, but a
+ * prover_metrics must not be shared by concurrent proofs.
+ */
+struct prover_metrics {
+    std::string label;      // exported as the `key` label, e.g. the name of the proving key
+    size_t num_constraints;
+    size_t num_variables;
+    size_t num_inputs;
+    size_t num_threads;
+    size_t chunks;
+    bool concurrent_stages;
+    double seconds;
+    double cpu_seconds;
+    size_t peak_rss_bytes;
+    prover_stage_metrics stages[prover_num_stages];
+
+    std::chrono::steady_clock::time_point start_time;
+    double start_cpu_seconds;
+
+    prover_metrics() :
+        num_constraints(0), num_variables(0), num_inputs(0), num_threads(0), chunks(0),
+        concurrent_stages(false), seconds(0), cpu_seconds(0), peak_rss_bytes(0), start_cpu_seconds(0)
+    {}
+
+    /**
+     * CPU time used by all threads of the process.
+     */
+    static double process_cpu_seconds()
+    {
+#if defined(CLOCK_PROCESS_CPUTIME_ID)
+        struct timespec ts;
+        if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+        {
+            return ts.tv_sec + ts.tv_nsec * 1e-9;
+        }
+#endif
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+    }
+
+    /** Seconds since begin() */
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    void begin()
+    {
+        start_time = std::chrono::steady_clock::now();
+        start_cpu_seconds = process_cpu_seconds();
+    }
+
+    void end()
+    {
+        seconds = elapsed();
+        cpu_seconds = process_cpu_seconds() - start_cpu_seconds;
+        peak_rss_bytes = libsnark::peak_rss_bytes();
+    }
+
+    double thread_utilization() const
+    {
+        return (seconds > 0 && num_threads > 0) ? cpu_seconds / (seconds * num_threads) : 0;
+    }
+
+    /**
+     * Record the terms of the multi-exponentiation of `stage`, whose bases
+     * are `base_size` bytes each.
+     */
+    template<typename ScalarIterT>
+    void record_msm(const size_t stage, ScalarIterT scalar_start, ScalarIterT scalar_end, const size_t base_size)
+    {
+        typedef typename std::iterator_traits<ScalarIterT>::value_type FieldT;
+        const FieldT one = FieldT::one();
+
+        prover_stage_metrics &m = stages[stage];
+        m.msm_size = std::distance(scalar_start, scalar_end);
+        m.msm_zeros = 0;
+        m.msm_ones = 0;
+        for (ScalarIterT it = scalar_start; it != scalar_end; ++it)
+        {
+            if (it->is_zero())
+            {
+                ++m.msm_zeros;
+            }
+            else if (*it == one)
+            {
+                ++m.msm_ones;
+            }
+        }
+        m.bytes = m.msm_size * (base_size + sizeof(FieldT));
+    }
+
+    void write_json(std::ostream &out) const;
+
+    /** The metrics of the last proof with each label */
+    static void write_prometheus(std::ostream &out, const std::map<std::string, prover_metrics> &latest);
+};
+
+/**
+ * Times a stage from construction to stop() or destruction, when `metrics`
+ * isn't null.
+ */
+class prover_stage_timer {
+public:
+    prover_stage_timer(prover_metrics *metrics, const size_t stage) :
+        m_metrics(metrics), m_stage(stage), m_start(metrics != nullptr ? metrics->elapsed() : 0)
+    {}
+
+    ~prover_stage_timer()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        if (m_metrics != nullptr)
+        {
+            m_metrics->stages[m_stage].start_seconds = m_start;
+            m_metrics->stages[m_stage].seconds = m_metrics->elapsed() - m_start;
+            m_metrics = nullptr;
+        }
+    }
+
+    prover_stage_timer(const prover_stage_timer&) = delete;
+    prover_stage_timer& operator=(const prover_stage_timer&) = delete;
+
+private:
+    prover_metrics *m_metrics;
+    const size_t m_stage;
+    const double m_start;
+};
+
+/**
+ * `value` escaped for a JSON string or a Prometheus label, both of which
+ * use backslash escapes for quotes, backslashes and newlines.
+ */
+inline std::string prover_metrics_escape(const std::string &value)
+{
+    std::string result;
+    for (const char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += c;
+        }
+        else if (c == '\n')
+        {
+            result += "\\n";
+        }
+        else if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            result += c;
+        }
+    }
+    return result;
+}
+
+inline void prover_metrics::write_json(std::ostream &out) const
+{
+    out << "{\"timestamp\":" << static_cast<long long>(std::time(nullptr))
+        << ",\"key\":\"" << prover_metrics_escape(label) << "\""
+        << ",\"constraints\":" << num_constraints
+        << ",\"variables\":" << num_variables
+        << ",\"inputs\":" << num_inputs
+        << ",\"threads\":" << num_threads
+        << ",\"chunks\":" << chunks
+        << ",\"concurrent_stages\":" << (concurrent_stages ? "true" : "false")
+        << ",\"seconds\":" << seconds
+        << ",\"cpu_seconds\":" << cpu_seconds
+        << ",\"thread_utilization\":" << thread_utilization()
+        << ",\"peak_rss_bytes\":" << peak_rss_bytes
+        << ",\"stages\":{";
+
+    for (size_t i = 0; i < prover_num_stages; ++i)
+    {
+        const prover_stage_metrics &m = stages[i];
+        out << (i > 0 ? "," : "") << "\"" << prover_stage_name(i) << "\":{"
+            << "\"start_seconds\":" << m.start_seconds
+            << ",\"seconds\":" << m.seconds;
+        if (i == prover_stage_witness_map)
+        {
+            out << ",\"domain_size\":" << m.domain_size;
+        }
+        else
+        {
+            out << ",\"msm_size\":" << m.msm_size
+                << ",\"msm_zeros\":" << m.msm_zeros
+                << ",\"msm_ones\":" << m.msm_ones
+                << ",\"bytes\":" << m.bytes;
+        }
+        out << "}";
+    }
+
+    out << "}}\n";
+}
+
+inline void prover_metrics::write_prometheus(std::ostream &out, const std::map<std::string, prover_metrics> &latest)
+{
+    const auto gauge = [&](const char *name, const char *help) {
+        out << "# HELP ethsnarks_prover_" << name << " " << help << "\n"
+            << "# TYPE ethsnarks_prover_" << name << " gauge\n";
+    };
+
+    /* the samples of a metric must follow its HELP and TYPE lines */
+    const auto for_each_key = [&](const std::function<void(const prover_metrics &, const std::string &)> &write_samples) {
+        for (const auto &entry : latest)
+        {
+            write_samples(entry.second, "key=\"" + prover_metrics_escape(entry.first) + "\"");
+        }
+    };
+
+    gauge("seconds", "Wall time of the last proof.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        out << "ethsnarks_prover_seconds{" << key << "} " << m.seconds << "\n";
+    });
+    gauge("cpu_seconds", "CPU time of the process during the last proof.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        out << "ethsnarks_prover_cpu_seconds{" << key << "} " << m.cpu_seconds << "\n";
+    });
+    gauge("thread_utilization", "CPU time over wall time of the thread team.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        out << "ethsnarks_prover_thread_utilization{" << key << "} " << m.thread_utilization() << "\n";
+    });
+    gauge("threads", "Threads used by the last proof.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        out << "ethsnarks_prover_threads{" << key << "} " << m.num_threads << "\n";
+    });
+    gauge("peak_rss_bytes", "Peak resident set size after the last proof.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        out << "ethsnarks_prover_peak_rss_bytes{" << key << "} " << m.peak_rss_bytes << "\n";
+    });
+    gauge("constraints", "Constraints of the circuit.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        out << "ethsnarks_prover_constraints{" << key << "} " << m.num_constraints << "\n";
+    });
+    gauge("domain_size", "Evaluation domain of the witness map.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        out << "ethsnarks_prover_domain_size{" << key << "} " << m.stages[prover_stage_witness_map].domain_size << "\n";
+    });
+
+    gauge("stage_seconds", "Wall time of each stage of the last proof.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        for (size_t i = 0; i < prover_num_stages; ++i)
+        {
+            out << "ethsnarks_prover_stage_seconds{" << key << ",stage=\"" << prover_stage_name(i) << "\"} " << m.stages[i].seconds << "\n";
+        }
+    });
+
+    gauge("msm_terms", "Terms of each multi-exponentiation, by scalar.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        for (size_t i = prover_stage_H; i < prover_num_stages; ++i)
+        {
+            const prover_stage_metrics &stage = m.stages[i];
+            const std::string labels = key + ",stage=\"" + prover_stage_name(i) + "\"";
+            out << "ethsnarks_prover_msm_terms{" << labels << ",scalar=\"zero\"} " << stage.msm_zeros << "\n"
+                << "ethsnarks_prover_msm_terms{" << labels << ",scalar=\"one\"} " << stage.msm_ones << "\n"
+                << "ethsnarks_prover_msm_terms{" << labels << ",scalar=\"other\"} " << (stage.msm_size - stage.msm_zeros - stage.msm_ones) << "\n";
+        }
+    });
+
+    gauge("msm_bytes", "Bytes of bases and scalars read by each multi-exponentiation.");
+    for_each_key([&](const prover_metrics &m, const std::string &key) {
+        for (size_t i = prover_stage_H; i < prover_num_stages; ++i)
+        {
+            out << "ethsnarks_prover_msm_bytes{" << key << ",stage=\"" << prover_stage_name(i) << "\"} " << m.stages[i].bytes << "\n";
+        }
+    });
+}
+
+/**
+ * The file named by ETHSNARKS_PROVER_METRICS, or an empty string.
+ */
+inline std::string prover_metrics_path()
+{
+    const char *path = std::getenv(prover_metrics_env);
+    return (path != nullptr ? std::string(path) : std::string());
+}
+
+/**
+ * Append `metrics` to `path` as a JSON line, or replace `path` in the
+ * Prometheus text format when it ends with ".prom". The file then holds the
+ * last proof of every label exported to it, so the series of each key served
+ * by a process stay between scrapes.
+ */
+inline bool prover_metrics_export(const prover_metrics &metrics, const std::string &path)
+{
+    /* proofs from several threads may finish at once */
+    static std::mutex export_mutex;
+    static std::map<std::string, std::map<std::string, prover_metrics> > latest_by_path;
+    std::lock_guard<std::mutex> lock(export_mutex);
+
+    const std::string prom_suffix = ".prom";
+    if (path.size() > prom_suffix.size()
+     && path.compare(path.size() - prom_suffix.size(), prom_suffix.size(), prom_suffix) == 0)
+    {
+        std::map<std::string, prover_metrics> &latest = latest_by_path[path];
+        latest[metrics.label] = metrics;
+
+        const std::string tmp_path = path + ".tmp";
+        {
+            std::ofstream out(tmp_path, std::ios::trunc);
+            prover_metrics::write_prometheus(out, latest);
+            if (!out)
+            {
+                return false;
+            }
+        }
+        return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+    }
+
+    std::ofstream out(path, std::ios::app);
+    metrics.write_json(out);
+    return static_cast<bool>(out);
+}
+
+} // libsnark
+
+#endif // PROVER_METRICS_HPP_
@@ -0,0 +1,223 @@
+/** @file
+ *****************************************************************************
+
+ Declaration of the QAP witness map used by the R1CS GG-ppzkSNARK prover.
+
+ This computes the same qap_witness as libsnark's r1cs_to_qap_witness_map
+ (with d1 = d2 = d3 = 0, as the Groth16 prover uses it), but with radix-2
+ FFT kernels that are scheduled through parallel_for_ranges, so when called
+ from a prover task the butterflies of every pass are spread over the whole
+ thread team.
+
+ The transforms avoid the bit-reversal permutation: the inverse FFTs are
+ decimation-in-frequency, leaving the coefficients in bit-reversed order,
+ which is the order the decimation-in-time FFT onto the coset takes. Passes
+ whose butterflies stay within a block are done block by block in a single
+ sweep, the remaining passes each stream through the array once.
+
+ In memory, A, B and C go through each pass together with the same
+ twiddles, the scaling by 1/m is folded into the coset shift, and the last
+ pass onto the coset, the pointwise (A*B - C)/Z and the first pass of H's
+ inverse FFT are one sweep, as they all pair the elements i and i + m/2.
+
+ Evaluation domains other than libfqfft's basic_radix2_domain are delegated
+ to r1cs_to_qap_witness_map.
+
+ The tables derived from the domain (its twiddles, the powers of the coset
+ generator and the inverse of Z on the coset) depend only on the domain
+ size, they are built by the first proof for a size and kept for the few
+ most recently used sizes, so later proofs with the same circuit, or any
+ circuit rounding up to the same domain, skip the setup.
+
+ Given a scratch directory, the evaluations of A, B and C are kept in
+ temporary files instead of memory (see scratch_array.hpp), so circuits
+ whose domain doesn't fit in RAM can still be proven. They are then
+ transformed one at a time, so only one array needs to be resident. The
+ assignment and the coefficients of H that are returned stay in memory.
+
+ The rows of A, B and C are evaluated from the constraint system in
+ compressed sparse row form (qap_constraint_matrices), with the variable
+ indices and coefficients of each matrix in contiguous arrays, rather than
+ through the term vectors of every linear_combination. Mapped proving keys
+ decode the matrices straight from the key file and hold no constraint
+ system, the witness map given a constraint system builds them on each call.
+
+ The peak resident set size is printed after each stage.
+
+The generator's counterpart, the QAP instance evaluated at the secret point
+t, is also computed here: the Lagrange coefficients at t with one inversion
+per task instead of one per point, and the A, B and C evaluation of every
+variable from the transposed matrices, so each variable is summed by one
+task without sharing writes.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef QAP_WITNESS_MAP_HPP_
+#define QAP_WITNESS_MAP_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libsnark/relations/arithmetic_programs/qap/qap.hpp>
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/r1cs.hpp>
+
+namespace libsnark {
+
+/**
+ * In-place radix-2 FFT of `a`, whose size must be a power of two, over the
+ * subgroup generated by `omega`. Same output as libfqfft's basic radix-2 FFT.
+ */
+template<typename FieldT>
+void qap_radix2_FFT(std::vector<FieldT> &a, const FieldT &omega);
+
+/**
+ * In-place inverse of qap_radix2_FFT.
+ */
+template<typename FieldT>
+void qap_radix2_iFFT(std::vector<FieldT> &a, const FieldT &omega);
+
+/**
+ * Multiply a[i] by g^i, moving the polynomial onto the coset g*S.
+ */
+template<typename FieldT>
+void qap_multiply_by_coset(std::vector<FieldT> &a, const FieldT &g);
+
+/**
+ * Blocked decimation-in-time FFT of the n = 2^k elements at `a`, taking them
+ * in bit-reversed order and leaving the result in natural order.
+ * `twiddles` holds omega^j for j < n/2.
+ */
+template<typename FieldT>
+void qap_radix2_DIT(FieldT *a, const size_t n, const FieldT *twiddles);
+
+/**
+ * Blocked decimation-in-frequency FFT, taking the elements in natural order
+ * and leaving the result in bit-reversed order.
+ */
+template<typename FieldT>
+void qap_radix2_DIF(FieldT *a, const size_t n, const FieldT *twiddles);
+
+/**
+ * Multiply a[i] by scale * g^bitreverse(i), the coset shift of coefficients
+ * held in bit-reversed order.
+ */
+template<typename FieldT>
+void qap_multiply_by_coset_bitreversed(FieldT *a, const size_t n, const FieldT &g, const FieldT &scale);
+
+/**
+ * The powers scale * g^bitreverse(i) for i < n, factored as a table of g^(j*n/C)
+ * for j < C and the n/C bases at multiples of the chunk size C.
+ */
+template<typename FieldT>
+struct qap_coset_table {
+    size_t chunk;
+    std::vector<FieldT> low_powers;
+    std::vector<FieldT> chunk_bases;
+};
+
+/**
+ * What the witness map derives from an evaluation domain of size m.
+ */
+template<typename FieldT>
+struct qap_domain_tables {
+    size_t m;
+    FieldT omega;
+    FieldT m_inverse;
+    /* Z(X) = X^m - 1 is constant over the coset */
+    FieldT Z_inverse_at_coset;
+    /* 1/m * g^bitreverse(i) and 1/m * g^-bitreverse(i), g the coset generator */
+    qap_coset_table<FieldT> coset_shift;
+    qap_coset_table<FieldT> coset_unshift;
+    /* omega^j and omega^-j for j < m/2, only if built with_twiddles */
+    bool has_twiddles;
+    std::vector<FieldT> twiddles;
+    std::vector<FieldT> inverse_twiddles;
+};
+
+/**
+ * The tables for the domain libfqfft chooses for `min_size` points, built on
+ * first use and cached by the size of the domain, which evicts the least
+ * recently used size once more than qap_domain_cache_size are held. Returns
+ * null if that is not a basic_radix2_domain. The twiddles, which take as
+ * much memory as one polynomial, are only built if `with_twiddles` is set.
+ */
+template<typename FieldT>
+std::shared_ptr<const qap_domain_tables<FieldT> > qap_get_domain_tables(const size_t min_size, const bool with_twiddles);
+
+/**
+ * Drop the cached domain tables, proofs in progress keep theirs.
+ */
+template<typename FieldT>
+void qap_clear_domain_tables();
+
+/**
+ * The A, B and C matrices of a constraint system in compressed sparse row
+ * form. The terms of row i of matrix k (0 for A, 1 for B, 2 for C) are
+ * rows[k][i] up to rows[k][i+1] in indices[k] and coefficients[k], an
+ * index of 0 is the constant one and j > 0 is variable j-1.
+ */
+template<typename FieldT>
+struct qap_constraint_matrices {
+    size_t num_constraints;
+    size_t num_inputs;
+    size_t num_variables;
+    std::vector<size_t> rows[3];
+    std::vector<size_t> indices[3];
+    std::vector<FieldT> coefficients[3];
+
+    qap_constraint_matrices() : num_constraints(0), num_inputs(0), num_variables(0) {}
+};
+
+/**
+ * Convert `cs` into compressed sparse row matrices.
+ */
+template<typename FieldT>
+void qap_make_constraint_matrices(const r1cs_constraint_system<FieldT> &cs, qap_constraint_matrices<FieldT> &matrices);
+
+/**
+ * Convert `matrices` back into a constraint system.
+ */
+template<typename FieldT>
+void qap_make_constraint_system(const qap_constraint_matrices<FieldT> &matrices, r1cs_constraint_system<FieldT> &cs);
+
+/**
+ * Compute the coefficients of H, and the variable assignment, for the
+ * Groth16 prover. Equivalent to r1cs_to_qap_witness_map(cs, primary_input,
+ * auxiliary_input, 0, 0, 0).
+ *
+ * With a `scratch_directory` the intermediate evaluations are kept out of
+ * core, in temporary files created there.
+ */
+template<typename FieldT>
+qap_witness<FieldT> r1cs_gg_ppzksnark_zok_witness_map(const r1cs_constraint_system<FieldT> &cs,
+                                                      const r1cs_primary_input<FieldT> &primary_input,
+                                                      const r1cs_auxiliary_input<FieldT> &auxiliary_input,
+                                                      const std::string &scratch_directory = std::string());
+
+/**
+ * As above, for the constraint system given as `matrices`.
+ */
+template<typename FieldT>
+qap_witness<FieldT> r1cs_gg_ppzksnark_zok_witness_map(const qap_constraint_matrices<FieldT> &matrices,
+                                                      const r1cs_primary_input<FieldT> &primary_input,
+                                                      const r1cs_auxiliary_input<FieldT> &auxiliary_input,
+                                                      const std::string &scratch_directory = std::string());
+
+/**
+ * The QAP instance of `cs` evaluated at `t`, for the generator. Equivalent to
+ * r1cs_to_qap_instance_map_with_evaluation(cs, t), which it delegates to for
+ * domains other than basic_radix2_domain.
+ */
+template<typename FieldT>
+qap_instance_evaluation<FieldT> r1cs_gg_ppzksnark_zok_instance_map_with_evaluation(const r1cs_constraint_system<FieldT> &cs,
+                                                                                   const FieldT &t);
+
+} // libsnark
+
+#include "r1cs_gg_ppzksnark_zok/qap_witness_map.tcc"
+
+#endif // QAP_WITNESS_MAP_HPP_
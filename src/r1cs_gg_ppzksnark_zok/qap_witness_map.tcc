@@ -0,0 +1,942 @@
+/** @file
+ *****************************************************************************
+
+ Implementation of the QAP witness map used by the R1CS GG-ppzkSNARK prover.
+
+ See qap_witness_map.hpp .
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef QAP_WITNESS_MAP_TCC_
+#define QAP_WITNESS_MAP_TCC_
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include <libff/common/profiling.hpp>
+#include <libff/common/utils.hpp>
+#include <libfqfft/evaluation_domain/domains/basic_radix2_domain.hpp>
+#include <libfqfft/evaluation_domain/get_evaluation_domain.hpp>
+
+#include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
+
+#include "r1cs_gg_ppzksnark_zok/memory_usage.hpp"
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+#include "r1cs_gg_ppzksnark_zok/scratch_array.hpp"
+
+namespace libsnark {
+
+/* Field elements (or butterflies) handled per task by the FFT kernels */
+const size_t qap_fft_grain = 1ul << 13;
+
+/* Constraints evaluated per task */
+const size_t qap_constraint_grain = 1ul << 10;
+
+/* Elements transformed together by the passes of the blocked FFTs, a power of two */
+const size_t qap_fft_block = 1ul << 16;
+
+/* Variables whose columns are evaluated per task by the instance map */
+const size_t qap_column_grain = 1ul << 10;
+
+/* Domain sizes whose tables are kept between proofs */
+const size_t qap_domain_cache_size = 4;
+
+/**
+ * out[i] = base^i for i < count
+ */
+template<typename FieldT>
+void qap_powers(FieldT *out, const size_t count, const FieldT &base)
+{
+    parallel_for_ranges(count, qap_fft_grain, [&](const size_t begin, const size_t end) {
+        FieldT power = base ^ static_cast<unsigned long>(begin);
+        for (size_t i = begin; i < end; ++i)
+        {
+            out[i] = power;
+            power *= base;
+        }
+    });
+}
+
+template<typename FieldT>
+void qap_powers(std::vector<FieldT> &out, const size_t count, const FieldT &base)
+{
+    out.resize(count);
+    qap_powers(out.data(), count, base);
+}
+
+template<typename FieldT>
+void qap_make_constraint_matrices(const r1cs_constraint_system<FieldT> &cs, qap_constraint_matrices<FieldT> &matrices)
+{
+    const size_t num_constraints = cs.num_constraints();
+    matrices.num_constraints = num_constraints;
+    matrices.num_inputs = cs.num_inputs();
+    matrices.num_variables = cs.num_variables();
+
+    for (size_t k = 0; k < 3; ++k)
+    {
+        std::vector<size_t> &rows = matrices.rows[k];
+        rows.resize(num_constraints + 1);
+        size_t num_terms = 0;
+        for (size_t i = 0; i < num_constraints; ++i)
+        {
+            const r1cs_constraint<FieldT> &constraint = cs.constraints[i];
+            const linear_combination<FieldT> &lc = (k == 0 ? constraint.a : (k == 1 ? constraint.b : constraint.c));
+            rows[i] = num_terms;
+            num_terms += lc.terms.size();
+        }
+        rows[num_constraints] = num_terms;
+
+        matrices.indices[k].resize(num_terms);
+        matrices.coefficients[k].resize(num_terms);
+    }
+
+    parallel_for_ranges(num_constraints, qap_constraint_grain, [&](const size_t begin, const size_t end) {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const r1cs_constraint<FieldT> &constraint = cs.constraints[i];
+                const linear_combination<FieldT> &lc = (k == 0 ? constraint.a : (k == 1 ? constraint.b : constraint.c));
+                size_t j = matrices.rows[k][i];
+                for (const linear_term<FieldT> &term : lc.terms)
+                {
+                    matrices.indices[k][j] = term.index;
+                    matrices.coefficients[k][j] = term.coeff;
+                    ++j;
+                }
+            }
+        }
+    });
+}
+
+template<typename FieldT>
+void qap_make_constraint_system(const qap_constraint_matrices<FieldT> &matrices, r1cs_constraint_system<FieldT> &cs)
+{
+    const size_t num_constraints = matrices.num_constraints;
+    cs.primary_input_size = matrices.num_inputs;
+    cs.auxiliary_input_size = matrices.num_variables - matrices.num_inputs;
+    cs.constraints.clear();
+    cs.constraints.resize(num_constraints);
+
+    parallel_for_ranges(num_constraints, qap_constraint_grain, [&](const size_t begin, const size_t end) {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                r1cs_constraint<FieldT> &constraint = cs.constraints[i];
+                linear_combination<FieldT> &lc = (k == 0 ? constraint.a : (k == 1 ? constraint.b : constraint.c));
+                const size_t row_begin = matrices.rows[k][i];
+                const size_t row_end = matrices.rows[k][i + 1];
+                lc.terms.resize(row_end - row_begin);
+                for (size_t j = row_begin; j < row_end; ++j)
+                {
+                    lc.terms[j - row_begin].index = matrices.indices[k][j];
+                    lc.terms[j - row_begin].coeff = matrices.coefficients[k][j];
+                }
+            }
+        }
+    });
+}
+
+/**
+ * Row i of matrix k times the assignment, the index 0 being the constant one.
+ */
+template<typename FieldT>
+FieldT qap_evaluate_row(const qap_constraint_matrices<FieldT> &matrices,
+                        const size_t k,
+                        const size_t i,
+                        const r1cs_variable_assignment<FieldT> &full_variable_assignment)
+{
+    const size_t *indices = matrices.indices[k].data();
+    const FieldT *coefficients = matrices.coefficients[k].data();
+
+    FieldT acc = FieldT::zero();
+    for (size_t j = matrices.rows[k][i]; j < matrices.rows[k][i + 1]; ++j)
+    {
+        acc += (indices[j] == 0 ? coefficients[j] : coefficients[j] * full_variable_assignment[indices[j] - 1]);
+    }
+    return acc;
+}
+
+/**
+ * Evaluate the rows of A, B and C, and the rows input_i * 0 = 0 which follow
+ * them, into zeroed arrays of the domain size.
+ */
+template<typename FieldT>
+void qap_evaluate_constraints(const qap_constraint_matrices<FieldT> &matrices,
+                              const r1cs_variable_assignment<FieldT> &full_variable_assignment,
+                              FieldT *aA, FieldT *aB, FieldT *aC)
+{
+    for (size_t i = 0; i <= matrices.num_inputs; ++i)
+    {
+        aA[i+matrices.num_constraints] = (i > 0 ? full_variable_assignment[i-1] : FieldT::one());
+    }
+
+    parallel_for_ranges(matrices.num_constraints, qap_constraint_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            aA[i] += qap_evaluate_row(matrices, 0, i, full_variable_assignment);
+            aB[i] = qap_evaluate_row(matrices, 1, i, full_variable_assignment);
+            aC[i] = qap_evaluate_row(matrices, 2, i, full_variable_assignment);
+        }
+    });
+}
+
+template<typename FieldT>
+void qap_radix2_FFT(std::vector<FieldT> &a, const FieldT &omega)
+{
+    const size_t n = a.size();
+    const size_t logn = libff::log2(n);
+    assert(n == (1ul << logn));
+
+    /* bit-reversal permutation, each pair is swapped by its smaller index */
+    parallel_for_ranges(n, qap_fft_grain, [&](const size_t begin, const size_t end) {
+        for (size_t k = begin; k < end; ++k)
+        {
+            const size_t rk = libff::bitreverse(k, logn);
+            if (k < rk)
+            {
+                std::swap(a[k], a[rk]);
+            }
+        }
+    });
+
+    /* twiddles[j] = omega^j, the stage with butterflies of half-size m uses every (n/2m)-th */
+    std::vector<FieldT> twiddles;
+    qap_powers(twiddles, n / 2, omega);
+
+    for (size_t m = 1; m < n; m *= 2)
+    {
+        const size_t stride = n / (2 * m);
+        parallel_for_ranges(n / 2, qap_fft_grain, [&](const size_t begin, const size_t end) {
+            for (size_t t = begin; t < end; ++t)
+            {
+                const size_t j = t % m;
+                const size_t k = (t - j) * 2 + j;
+
+                const FieldT u = twiddles[j * stride] * a[k + m];
+                a[k + m] = a[k] - u;
+                a[k] += u;
+            }
+        });
+    }
+}
+
+template<typename FieldT>
+void qap_radix2_iFFT(std::vector<FieldT> &a, const FieldT &omega)
+{
+    qap_radix2_FFT(a, omega.inverse());
+
+    const FieldT sconst = FieldT(a.size()).inverse();
+    parallel_for_ranges(a.size(), qap_fft_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            a[i] *= sconst;
+        }
+    });
+}
+
+template<typename FieldT>
+void qap_multiply_by_coset(std::vector<FieldT> &a, const FieldT &g)
+{
+    parallel_for_ranges(a.size(), qap_fft_grain, [&](const size_t begin, const size_t end) {
+        FieldT u = g ^ static_cast<unsigned long>(begin);
+        for (size_t i = begin; i < end; ++i)
+        {
+            a[i] *= u;
+            u *= g;
+        }
+    });
+}
+
+/**
+ * Block size of the blocked FFTs for n elements, shrunk from qap_fft_block
+ * until there are enough blocks to keep every thread busy.
+ */
+inline size_t qap_fft_block_size(const size_t n)
+{
+    const size_t min_blocks = 4 * parallel_num_threads();
+    size_t block = std::min(n, qap_fft_block);
+    while (block > qap_fft_grain && n / block < min_blocks)
+    {
+        block /= 2;
+    }
+    return block;
+}
+
+/**
+ * The decimation-in-time passes with butterflies of half-size m < end_half_size,
+ * applied to each of the `num_polys` arrays in turn with the same twiddles.
+ */
+template<typename FieldT>
+void qap_radix2_DIT_passes(FieldT *const *polys, const size_t num_polys, const size_t n, const FieldT *twiddles, const size_t end_half_size)
+{
+    const size_t block = qap_fft_block_size(n);
+    const size_t block_end = std::min(block, end_half_size);
+
+    /* passes with butterflies of half-size m < block, one block at a time */
+    parallel_for_ranges(n / block, 1, [&](const size_t begin, const size_t end) {
+        for (size_t b = begin; b < end; ++b)
+        {
+            for (size_t m = 1; m < block_end; m *= 2)
+            {
+                const size_t stride = n / (2 * m);
+                for (size_t k = b * block; k < (b + 1) * block; k += 2 * m)
+                {
+                    for (size_t j = 0; j < m; ++j)
+                    {
+                        const FieldT &w = twiddles[j * stride];
+                        for (size_t p = 0; p < num_polys; ++p)
+                        {
+                            FieldT *x = polys[p];
+                            const FieldT u = w * x[k + j + m];
+                            x[k + j + m] = x[k + j] - u;
+                            x[k + j] += u;
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    /* the remaining passes span blocks, each streams through the arrays once */
+    for (size_t m = block; m < end_half_size; m *= 2)
+    {
+        const size_t stride = n / (2 * m);
+        parallel_for_ranges(n / 2, qap_fft_grain, [&](const size_t begin, const size_t end) {
+            for (size_t t = begin; t < end; ++t)
+            {
+                const size_t j = t % m;
+                const size_t k = (t - j) * 2 + j;
+                const FieldT &w = twiddles[j * stride];
+                for (size_t p = 0; p < num_polys; ++p)
+                {
+                    FieldT *x = polys[p];
+                    const FieldT u = w * x[k + m];
+                    x[k + m] = x[k] - u;
+                    x[k] += u;
+                }
+            }
+        });
+    }
+}
+
+/**
+ * The decimation-in-frequency passes with butterflies of half-size
+ * m <= start_half_size, from the largest down.
+ */
+template<typename FieldT>
+void qap_radix2_DIF_passes(FieldT *const *polys, const size_t num_polys, const size_t n, const FieldT *twiddles, const size_t start_half_size)
+{
+    const size_t block = qap_fft_block_size(n);
+
+    /* passes spanning blocks come first */
+    size_t block_start = start_half_size;
+    for (; block_start >= block && block_start > 0; block_start /= 2)
+    {
+        const size_t m = block_start;
+        const size_t stride = n / (2 * m);
+        parallel_for_ranges(n / 2, qap_fft_grain, [&](const size_t begin, const size_t end) {
+            for (size_t t = begin; t < end; ++t)
+            {
+                const size_t j = t % m;
+                const size_t k = (t - j) * 2 + j;
+                const FieldT &w = twiddles[j * stride];
+                for (size_t p = 0; p < num_polys; ++p)
+                {
+                    FieldT *x = polys[p];
+                    const FieldT u = x[k];
+                    const FieldT v = x[k + m];
+                    x[k] = u + v;
+                    x[k + m] = (u - v) * w;
+                }
+            }
+        });
+    }
+
+    parallel_for_ranges(n / block, 1, [&](const size_t begin, const size_t end) {
+        for (size_t b = begin; b < end; ++b)
+        {
+            for (size_t m = block_start; m >= 1; m /= 2)
+            {
+                const size_t stride = n / (2 * m);
+                for (size_t k = b * block; k < (b + 1) * block; k += 2 * m)
+                {
+                    for (size_t j = 0; j < m; ++j)
+                    {
+                        const FieldT &w = twiddles[j * stride];
+                        for (size_t p = 0; p < num_polys; ++p)
+                        {
+                            FieldT *x = polys[p];
+                            const FieldT u = x[k + j];
+                            const FieldT v = x[k + j + m];
+                            x[k + j] = u + v;
+                            x[k + j + m] = (u - v) * w;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+template<typename FieldT>
+void qap_radix2_DIT(FieldT *a, const size_t n, const FieldT *twiddles)
+{
+    qap_radix2_DIT_passes(&a, 1, n, twiddles, n);
+}
+
+template<typename FieldT>
+void qap_radix2_DIF(FieldT *a, const size_t n, const FieldT *twiddles)
+{
+    qap_radix2_DIF_passes(&a, 1, n, twiddles, n / 2);
+}
+
+/**
+ * Fill `table` with the powers scale * g^bitreverse(i) for i < n.
+ */
+template<typename FieldT>
+void qap_make_coset_table(qap_coset_table<FieldT> &table, const size_t n, const FieldT &g, const FieldT &scale)
+{
+    /* For i = begin + r, with begin a multiple of the chunk size C and r < C,
+       bitreverse(i) = bitreverse(begin) + bitreverse_C(r) * n/C */
+    const size_t logn = libff::log2(n);
+    table.chunk = std::min(n, qap_fft_grain);
+    qap_powers(table.low_powers, table.chunk, g ^ static_cast<unsigned long>(n / table.chunk));
+
+    table.chunk_bases.resize(n / table.chunk);
+    parallel_for_ranges(table.chunk_bases.size(), 1, [&](const size_t begin, const size_t end) {
+        for (size_t k = begin; k < end; ++k)
+        {
+            table.chunk_bases[k] = scale * (g ^ static_cast<unsigned long>(libff::bitreverse(k * table.chunk, logn)));
+        }
+    });
+}
+
+/**
+ * Calls body(i, factor) for every i < n, in parallel, with the factors of `table`.
+ */
+template<typename FieldT, typename FuncT>
+void qap_for_each_coset_power_bitreversed(const qap_coset_table<FieldT> &table, const size_t n, const FuncT &body)
+{
+    const size_t log_chunk = libff::log2(table.chunk);
+
+    parallel_for_ranges(n, table.chunk, [&](const size_t begin, const size_t end) {
+        const FieldT &base = table.chunk_bases[begin / table.chunk];
+        for (size_t r = 0; r < end - begin; ++r)
+        {
+            body(begin + r, base * table.low_powers[libff::bitreverse(r, log_chunk)]);
+        }
+    });
+}
+
+/**
+ * Calls body(i, scale * g^bitreverse(i)) for every i < n, in parallel.
+ */
+template<typename FieldT, typename FuncT>
+void qap_for_each_coset_power_bitreversed(const size_t n, const FieldT &g, const FieldT &scale, const FuncT &body)
+{
+    qap_coset_table<FieldT> table;
+    qap_make_coset_table(table, n, g, scale);
+    qap_for_each_coset_power_bitreversed(table, n, body);
+}
+
+template<typename FieldT>
+void qap_multiply_by_coset_bitreversed(FieldT *a, const size_t n, const qap_coset_table<FieldT> &table)
+{
+    qap_for_each_coset_power_bitreversed(table, n, [&](const size_t i, const FieldT &factor) {
+        a[i] *= factor;
+    });
+}
+
+template<typename FieldT>
+void qap_multiply_by_coset_bitreversed(FieldT *a, const size_t n, const FieldT &g, const FieldT &scale)
+{
+    qap_coset_table<FieldT> table;
+    qap_make_coset_table(table, n, g, scale);
+    qap_multiply_by_coset_bitreversed(a, n, table);
+}
+
+/**
+ * Process wide cache of qap_domain_tables, keyed by the domain size, so
+ * circuits whose sizes round up to the same domain share the tables. Holds
+ * the qap_domain_cache_size most recently used sizes.
+ */
+template<typename FieldT>
+class qap_domain_cache {
+public:
+    struct entry {
+        std::shared_ptr<const qap_domain_tables<FieldT> > tables;
+        size_t last_use;
+    };
+
+    std::mutex mutex;
+    std::map<size_t, entry> entries;
+    size_t uses;
+
+    qap_domain_cache() : uses(0) {}
+
+    static qap_domain_cache<FieldT> &instance()
+    {
+        static qap_domain_cache<FieldT> cache;
+        return cache;
+    }
+};
+
+template<typename FieldT>
+std::shared_ptr<const qap_domain_tables<FieldT> > qap_get_domain_tables(const size_t min_size, const bool with_twiddles)
+{
+    /* Only the domain's size and omega, its tables are what is cached */
+    const std::shared_ptr<libfqfft::evaluation_domain<FieldT> > domain = libfqfft::get_evaluation_domain<FieldT>(min_size);
+    const libfqfft::basic_radix2_domain<FieldT> *radix2_domain = dynamic_cast<const libfqfft::basic_radix2_domain<FieldT>*>(domain.get());
+    if (radix2_domain == nullptr)
+    {
+        return std::shared_ptr<const qap_domain_tables<FieldT> >();
+    }
+    const size_t m = domain->m;
+
+    qap_domain_cache<FieldT> &cache = qap_domain_cache<FieldT>::instance();
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        const auto it = cache.entries.find(m);
+        if (it != cache.entries.end() && (it->second.tables->has_twiddles || !with_twiddles))
+        {
+            it->second.last_use = ++cache.uses;
+            return it->second.tables;
+        }
+    }
+
+    /* Built without holding the lock: the kernels spawn tasks, and the
+       thread waiting for them may pick up another proof which needs the
+       cache. Two proofs racing for the same size both build it, and the
+       first to finish is kept unless it lacks twiddles the other has. */
+    libff::enter_block("Build evaluation domain tables");
+    const FieldT coset = FieldT::multiplicative_generator;
+
+    std::shared_ptr<qap_domain_tables<FieldT> > tables = std::make_shared<qap_domain_tables<FieldT> >();
+    tables->m = m;
+    tables->omega = radix2_domain->omega;
+    tables->m_inverse = FieldT(m).inverse();
+    tables->Z_inverse_at_coset = ((coset ^ static_cast<unsigned long>(m)) - FieldT::one()).inverse();
+    qap_make_coset_table(tables->coset_shift, m, coset, tables->m_inverse);
+    qap_make_coset_table(tables->coset_unshift, m, coset.inverse(), tables->m_inverse);
+    tables->has_twiddles = with_twiddles;
+    if (with_twiddles)
+    {
+        qap_powers(tables->twiddles, m / 2, tables->omega);
+        qap_powers(tables->inverse_twiddles, m / 2, tables->omega.inverse());
+    }
+    libff::leave_block("Build evaluation domain tables");
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    typename qap_domain_cache<FieldT>::entry &entry = cache.entries[m];
+    if (!entry.tables || (with_twiddles && !entry.tables->has_twiddles))
+    {
+        entry.tables = tables;
+    }
+    entry.last_use = ++cache.uses;
+
+    /* Proofs still using an evicted size keep their tables until they finish */
+    while (cache.entries.size() > qap_domain_cache_size)
+    {
+        auto oldest = cache.entries.begin();
+        for (auto it = cache.entries.begin(); it != cache.entries.end(); ++it)
+        {
+            if (it->second.last_use < oldest->second.last_use)
+            {
+                oldest = it;
+            }
+        }
+        cache.entries.erase(oldest);
+    }
+
+    return entry.tables;
+}
+
+template<typename FieldT>
+void qap_clear_domain_tables()
+{
+    qap_domain_cache<FieldT> &cache = qap_domain_cache<FieldT>::instance();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.entries.clear();
+}
+
+/**
+ * The witness map with the evaluations of A, B and C in scratch files.
+ */
+template<typename FieldT>
+qap_witness<FieldT> qap_witness_map_out_of_core(const qap_constraint_matrices<FieldT> &matrices,
+                                                r1cs_variable_assignment<FieldT> &&full_variable_assignment,
+                                                const qap_domain_tables<FieldT> &domain,
+                                                const std::string &scratch_directory)
+{
+    const FieldT zero = FieldT::zero();
+    const size_t m = domain.m;
+
+    libff::enter_block("Allocate scratch files");
+    scratch_array<FieldT> aA, aB, aC, twiddles, inverse_twiddles;
+    if (!aA.allocate(scratch_directory, m)
+     || !aB.allocate(scratch_directory, m)
+     || !aC.allocate(scratch_directory, m)
+     || !twiddles.allocate(scratch_directory, m / 2)
+     || !inverse_twiddles.allocate(scratch_directory, m / 2))
+    {
+        throw std::runtime_error("Cannot create scratch files in " + scratch_directory);
+    }
+    qap_powers(twiddles.data(), m / 2, domain.omega);
+    qap_powers(inverse_twiddles.data(), m / 2, domain.omega.inverse());
+    libff::leave_block("Allocate scratch files");
+
+    peak_rss_stage_begin();
+    libff::enter_block("Compute evaluation of polynomials A, B, C on set S");
+    qap_evaluate_constraints(matrices, full_variable_assignment, aA.data(), aB.data(), aC.data());
+    libff::leave_block("Compute evaluation of polynomials A, B, C on set S");
+    peak_rss_stage_end("A, B, C on set S");
+
+    peak_rss_stage_begin();
+    libff::enter_block("Compute evaluation of polynomials A, B, C on set T");
+    /* one polynomial at a time, so the working set is a single array */
+    FieldT *polys[3] = {aA.data(), aB.data(), aC.data()};
+    for (size_t i = 0; i < 3; ++i)
+    {
+        qap_radix2_DIF(polys[i], m, inverse_twiddles.data());
+        qap_multiply_by_coset_bitreversed(polys[i], m, domain.coset_shift);
+        qap_radix2_DIT(polys[i], m, twiddles.data());
+    }
+    libff::leave_block("Compute evaluation of polynomials A, B, C on set T");
+    peak_rss_stage_end("A, B, C on set T");
+
+    peak_rss_stage_begin();
+    libff::enter_block("Compute evaluation of polynomial H on set T");
+    parallel_for_ranges(m, qap_fft_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            aA[i] = (aA[i] * aB[i] - aC[i]) * domain.Z_inverse_at_coset;
+        }
+    });
+    aB.release();
+    aC.release();
+    libff::leave_block("Compute evaluation of polynomial H on set T");
+    peak_rss_stage_end("H on set T");
+
+    peak_rss_stage_begin();
+    libff::enter_block("Compute coefficients of polynomial H");
+    qap_radix2_DIF(aA.data(), m, inverse_twiddles.data());
+    qap_multiply_by_coset_bitreversed(aA.data(), m, domain.coset_unshift);
+
+    const size_t logm = libff::log2(m);
+    std::vector<FieldT> coefficients_for_H(m + 1, zero);
+    parallel_for_ranges(m, qap_fft_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            coefficients_for_H[libff::bitreverse(i, logm)] = aA[i];
+        }
+    });
+    libff::leave_block("Compute coefficients of polynomial H");
+    peak_rss_stage_end("coefficients of H");
+
+    return qap_witness<FieldT>(matrices.num_variables, m, matrices.num_inputs, zero, zero, zero, std::move(full_variable_assignment), std::move(coefficients_for_H));
+}
+
+template<typename FieldT>
+qap_witness<FieldT> r1cs_gg_ppzksnark_zok_witness_map(const qap_constraint_matrices<FieldT> &matrices,
+                                                      const r1cs_primary_input<FieldT> &primary_input,
+                                                      const r1cs_auxiliary_input<FieldT> &auxiliary_input,
+                                                      const std::string &scratch_directory)
+{
+    const FieldT zero = FieldT::zero();
+
+    /* out of core the twiddles are kept in scratch files too */
+    const std::shared_ptr<const qap_domain_tables<FieldT> > domain = qap_get_domain_tables<FieldT>(matrices.num_constraints + matrices.num_inputs + 1, scratch_directory.empty());
+    if (!domain)
+    {
+        r1cs_constraint_system<FieldT> cs;
+        qap_make_constraint_system(matrices, cs);
+        return r1cs_to_qap_witness_map(cs, primary_input, auxiliary_input, zero, zero, zero);
+    }
+
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_witness_map");
+
+    const size_t m = domain->m;
+    const std::vector<FieldT> &twiddles = domain->twiddles;
+    const std::vector<FieldT> &inverse_twiddles = domain->inverse_twiddles;
+    const FieldT &Z_inverse_at_coset = domain->Z_inverse_at_coset;
+
+    r1cs_variable_assignment<FieldT> full_variable_assignment = primary_input;
+    full_variable_assignment.insert(full_variable_assignment.end(), auxiliary_input.begin(), auxiliary_input.end());
+
+    if (!scratch_directory.empty())
+    {
+        qap_witness<FieldT> result = qap_witness_map_out_of_core(matrices, std::move(full_variable_assignment), *domain, scratch_directory);
+        libff::leave_block("Call to r1cs_gg_ppzksnark_zok_witness_map");
+        return result;
+    }
+
+    libff::enter_block("Compute evaluation of polynomials A, B, C on set S");
+    std::vector<FieldT> aA(m, zero), aB(m, zero), aC(m, zero);
+    qap_evaluate_constraints(matrices, full_variable_assignment, aA.data(), aB.data(), aC.data());
+    libff::leave_block("Compute evaluation of polynomials A, B, C on set S");
+
+    /* The three polynomials go through every pass together, sharing the
+       twiddles, and no pass bit-reverses: the inverse FFTs leave the
+       coefficients in bit-reversed order, the coset shift (with the 1/m of
+       the inverse) is applied in that order, and the FFTs onto the coset
+       take it as their input order. */
+    libff::enter_block("Compute evaluation of polynomials A, B, C on set T");
+    FieldT *const polys[3] = {aA.data(), aB.data(), aC.data()};
+    qap_radix2_DIF_passes(polys, 3, m, inverse_twiddles.data(), m / 2);
+    qap_for_each_coset_power_bitreversed(domain->coset_shift, m, [&](const size_t i, const FieldT &factor) {
+        aA[i] *= factor;
+        aB[i] *= factor;
+        aC[i] *= factor;
+    });
+    /* all but the last pass, which is fused with the computation of H */
+    qap_radix2_DIT_passes(polys, 3, m, twiddles.data(), m / 2);
+    libff::leave_block("Compute evaluation of polynomials A, B, C on set T");
+
+    libff::enter_block("Compute evaluation of polynomial H on set T");
+    std::vector<FieldT> &H_tmp = aA; // can overwrite aA because it is not used later
+    if (m == 1)
+    {
+        H_tmp[0] = (aA[0] * aB[0] - aC[0]) * Z_inverse_at_coset;
+    }
+    else {
+        /* The last DIT pass of A, B and C, the pointwise H = (A*B - C)/Z and
+           the first DIF pass of H's inverse FFT all pair element t with t + m/2 */
+        const size_t half = m / 2;
+        parallel_for_ranges(half, qap_fft_grain, [&](const size_t begin, const size_t end) {
+            for (size_t t = begin; t < end; ++t)
+            {
+                FieldT values[2][3];
+                for (size_t p = 0; p < 3; ++p)
+                {
+                    const FieldT u = twiddles[t] * polys[p][t + half];
+                    values[0][p] = polys[p][t] + u;
+                    values[1][p] = polys[p][t] - u;
+                }
+
+                const FieldT h0 = (values[0][0] * values[0][1] - values[0][2]) * Z_inverse_at_coset;
+                const FieldT h1 = (values[1][0] * values[1][1] - values[1][2]) * Z_inverse_at_coset;
+                H_tmp[t] = h0 + h1;
+                H_tmp[t + half] = (h0 - h1) * inverse_twiddles[t];
+            }
+        });
+    }
+    std::vector<FieldT>().swap(aB);
+    std::vector<FieldT>().swap(aC);
+    libff::leave_block("Compute evaluation of polynomial H on set T");
+
+    libff::enter_block("Compute coefficients of polynomial H");
+    FieldT *const H_poly = H_tmp.data();
+    qap_radix2_DIF_passes(&H_poly, 1, m, inverse_twiddles.data(), m / 4);
+
+    /* undo the coset shift while copying out of bit-reversed order */
+    const size_t logm = libff::log2(m);
+    std::vector<FieldT> coefficients_for_H(m + 1, zero);
+    qap_for_each_coset_power_bitreversed(domain->coset_unshift, m, [&](const size_t i, const FieldT &factor) {
+        coefficients_for_H[libff::bitreverse(i, logm)] = H_tmp[i] * factor;
+    });
+    std::vector<FieldT>().swap(H_tmp);
+    libff::leave_block("Compute coefficients of polynomial H");
+
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_witness_map");
+
+    return qap_witness<FieldT>(matrices.num_variables, m, matrices.num_inputs, zero, zero, zero, std::move(full_variable_assignment), std::move(coefficients_for_H));
+}
+
+template<typename FieldT>
+qap_witness<FieldT> r1cs_gg_ppzksnark_zok_witness_map(const r1cs_constraint_system<FieldT> &cs,
+                                                      const r1cs_primary_input<FieldT> &primary_input,
+                                                      const r1cs_auxiliary_input<FieldT> &auxiliary_input,
+                                                      const std::string &scratch_directory)
+{
+    libff::enter_block("Convert constraint system to matrices");
+    qap_constraint_matrices<FieldT> matrices;
+    qap_make_constraint_matrices(cs, matrices);
+    libff::leave_block("Convert constraint system to matrices");
+
+    return r1cs_gg_ppzksnark_zok_witness_map(matrices, primary_input, auxiliary_input, scratch_directory);
+}
+
+/**
+ * u[i] = L_i(t), the Lagrange basis polynomials of the domain evaluated at t,
+ * as libfqfft's basic_radix2_domain::evaluate_all_lagrange_polynomials. Off
+ * the domain L_i(t) = Z(t)/m * omega^i / (t - omega^i), the denominators of
+ * each task's range are inverted together with one field inversion.
+ */
+template<typename FieldT>
+void qap_evaluate_all_lagrange(const qap_domain_tables<FieldT> &domain, const FieldT &t, std::vector<FieldT> &u)
+{
+    const size_t m = domain.m;
+    const FieldT Z = (t ^ static_cast<unsigned long>(m)) - FieldT::one();
+    u.assign(m, FieldT::zero());
+
+    if (Z.is_zero())
+    {
+        /* t is omega^i for some i, where L_i is 1 and the others are 0 */
+        FieldT omega_i = FieldT::one();
+        for (size_t i = 0; i < m; ++i)
+        {
+            if (omega_i == t)
+            {
+                u[i] = FieldT::one();
+                return;
+            }
+            omega_i *= domain.omega;
+        }
+        return;
+    }
+
+    const FieldT Z_over_m = Z * domain.m_inverse;
+    const FieldT omega_inverse = domain.omega.inverse();
+    parallel_for_ranges(m, qap_fft_grain, [&](const size_t begin, const size_t end) {
+        /* u[i] first holds the product of the denominators up to i */
+        std::vector<FieldT> denominators;
+        denominators.reserve(end - begin);
+        const FieldT omega_begin = domain.omega ^ static_cast<unsigned long>(begin);
+        FieldT r = omega_begin;
+        FieldT product = FieldT::one();
+        for (size_t i = begin; i < end; ++i)
+        {
+            denominators.emplace_back(t - r);
+            product *= denominators.back();
+            u[i] = product;
+            r *= domain.omega;
+        }
+
+        FieldT inverse = product.inverse();
+        FieldT l = Z_over_m * omega_begin * (domain.omega ^ static_cast<unsigned long>(end - begin - 1));
+        for (size_t i = end; i-- > begin; )
+        {
+            const FieldT denominator_inverse = (i > begin ? inverse * u[i - 1] : inverse);
+            inverse *= denominators[i - begin];
+            u[i] = l * denominator_inverse;
+            l *= omega_inverse;
+        }
+    });
+}
+
+/**
+ * out[k][j] += the sum over rows i of u[i] times the coefficient of index j
+ * in row i of matrix k. Each matrix is first transposed, listing the terms
+ * of every column in row order, so that a column is accumulated by a single
+ * task.
+ */
+template<typename FieldT>
+void qap_evaluate_columns(const qap_constraint_matrices<FieldT> &matrices,
+                          const std::vector<FieldT> &u,
+                          std::vector<FieldT> *out)
+{
+    const size_t num_columns = matrices.num_variables + 1;
+
+    for (size_t k = 0; k < 3; ++k)
+    {
+        const std::vector<size_t> &rows = matrices.rows[k];
+        const std::vector<size_t> &indices = matrices.indices[k];
+        const FieldT *coefficients = matrices.coefficients[k].data();
+
+        /* the terms of column j are columns[j] up to columns[j+1] in
+           term_rows and term_positions, the latter indexing coefficients */
+        std::vector<size_t> columns(num_columns + 1, 0);
+        for (const size_t index : indices)
+        {
+            assert(index < num_columns);
+            ++columns[index + 1];
+        }
+        for (size_t j = 0; j < num_columns; ++j)
+        {
+            columns[j + 1] += columns[j];
+        }
+
+        std::vector<size_t> next(columns.begin(), columns.end() - 1);
+        std::vector<size_t> term_rows(indices.size());
+        std::vector<size_t> term_positions(indices.size());
+        for (size_t i = 0; i < matrices.num_constraints; ++i)
+        {
+            for (size_t j = rows[i]; j < rows[i + 1]; ++j)
+            {
+                const size_t position = next[indices[j]]++;
+                term_rows[position] = i;
+                term_positions[position] = j;
+            }
+        }
+        std::vector<size_t>().swap(next);
+
+        std::vector<FieldT> &column_values = out[k];
+        parallel_for_ranges(num_columns, qap_column_grain, [&](const size_t begin, const size_t end) {
+            for (size_t j = begin; j < end; ++j)
+            {
+                FieldT acc = FieldT::zero();
+                for (size_t p = columns[j]; p < columns[j + 1]; ++p)
+                {
+                    acc += u[term_rows[p]] * coefficients[term_positions[p]];
+                }
+                column_values[j] += acc;
+            }
+        });
+    }
+}
+
+template<typename FieldT>
+qap_instance_evaluation<FieldT> r1cs_gg_ppzksnark_zok_instance_map_with_evaluation(const r1cs_constraint_system<FieldT> &cs,
+                                                                                   const FieldT &t)
+{
+    const size_t min_size = cs.num_constraints() + cs.num_inputs() + 1;
+    const std::shared_ptr<const qap_domain_tables<FieldT> > tables = qap_get_domain_tables<FieldT>(min_size, false);
+    if (!tables)
+    {
+        return r1cs_to_qap_instance_map_with_evaluation(cs, t);
+    }
+
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_instance_map_with_evaluation");
+
+    const size_t m = tables->m;
+    const FieldT zero = FieldT::zero();
+
+    libff::enter_block("Convert constraint system to matrices");
+    qap_constraint_matrices<FieldT> matrices;
+    qap_make_constraint_matrices(cs, matrices);
+    libff::leave_block("Convert constraint system to matrices");
+
+    libff::enter_block("Compute evaluations of A, B, C, H at t");
+    std::vector<FieldT> u;
+    qap_evaluate_all_lagrange(*tables, t, u);
+
+    std::vector<FieldT> columns[3];
+    for (size_t k = 0; k < 3; ++k)
+    {
+        columns[k].assign(cs.num_variables() + 1, zero);
+    }
+
+    /* the constraints input_i * 0 = 0, which follow the others, ensure the
+       soundness of input consistency */
+    for (size_t i = 0; i <= cs.num_inputs(); ++i)
+    {
+        columns[0][i] = u[cs.num_constraints() + i];
+    }
+    qap_evaluate_columns(matrices, u, columns);
+
+    std::vector<FieldT> Ht;
+    qap_powers(Ht, m + 1, t);
+    const FieldT Zt = (t ^ static_cast<unsigned long>(m)) - FieldT::one();
+    libff::leave_block("Compute evaluations of A, B, C, H at t");
+
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_instance_map_with_evaluation");
+
+    const std::shared_ptr<libfqfft::evaluation_domain<FieldT> > domain = libfqfft::get_evaluation_domain<FieldT>(min_size);
+    return qap_instance_evaluation<FieldT>(domain, cs.num_variables(), m, cs.num_inputs(), t,
+                                           std::move(columns[0]), std::move(columns[1]), std::move(columns[2]),
+                                           std::move(Ht), Zt);
+}
+
+} // libsnark
+
+#endif // QAP_WITNESS_MAP_TCC_
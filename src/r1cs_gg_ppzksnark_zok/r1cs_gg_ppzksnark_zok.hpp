@@ -6,6 +6,7 @@ in the generic group (GG) model.
 
 This includes:
 - class for proving key
+- class for expanded proving key (fixed-base tables of the proving key)
 - class for verification key
 - class for processed verification key
 - class for key pair (proving key & verification key)
@@ -47,12 +48,16 @@ References:
 #define R1CS_GG_PPZKSNARK_HPP_
 
 #include <memory>
+#include <string>
 
 #include <libff/algebra/curves/public_params.hpp>
 
 #include <libsnark/common/data_structures/accumulation_vector.hpp>
 #include <libsnark/knowledge_commitment/knowledge_commitment.hpp>
 #include <libsnark/relations/constraint_satisfaction_problems/r1cs/r1cs.hpp>
+#include "r1cs_gg_ppzksnark_zok/fixed_base_multiexp.hpp"
+#include "r1cs_gg_ppzksnark_zok/prover_metrics.hpp"
+#include "r1cs_gg_ppzksnark_zok/qap_witness_map.hpp"
 #include "r1cs_gg_ppzksnark_zok/r1cs_gg_ppzksnark_zok_params.hpp"
 
 namespace libsnark {
@@ -155,6 +160,68 @@ public:
 };
 
 
+/*************************** Expanded proving key ****************************/
+
+template<typename ppT>
+class r1cs_gg_ppzksnark_zok_expanded_proving_key;
+
+template<typename ppT>
+std::ostream& operator<<(std::ostream &out, const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &epk);
+
+template<typename ppT>
+std::istream& operator>>(std::istream &in, r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &epk);
+
+/**
+ * Fixed-base tables for the A, B, H and L queries of a proving key, see
+ * fixed_base_multiexp.hpp. Each table is about bits(Fr)/window times the
+ * size of its query; it is only valid together with the key it was built from,
+ * which is recognised by its query sizes and delta_g1, random for every setup.
+ */
+template<typename ppT>
+class r1cs_gg_ppzksnark_zok_expanded_proving_key {
+public:
+    fixed_base_table<libff::G1<ppT> > A_table;
+    fixed_base_table<knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> > > B_table; // over the non-zero entries of B_query
+    fixed_base_table<libff::G1<ppT> > H_table;
+    fixed_base_table<libff::G1<ppT> > L_table;
+    libff::G1<ppT> pk_delta_g1;
+
+    r1cs_gg_ppzksnark_zok_expanded_proving_key() {};
+    r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT>& operator=(const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &other) = default;
+    r1cs_gg_ppzksnark_zok_expanded_proving_key(const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &other) = default;
+    r1cs_gg_ppzksnark_zok_expanded_proving_key(r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &&other) = default;
+
+    size_t size_in_bits() const
+    {
+        return (A_table.size_in_bits() + B_table.size_in_bits() +
+                H_table.size_in_bits() + L_table.size_in_bits());
+    }
+
+    void print_size() const
+    {
+        libff::print_indent(); printf("* Expanded PK windows (A, B, H, L): %zu, %zu, %zu, %zu bits\n",
+                                      A_table.window, B_table.window, H_table.window, L_table.window);
+        libff::print_indent(); printf("* Expanded PK size in bits: %zu\n", this->size_in_bits());
+    }
+
+    /* Whether the tables were built from `pk`, a proving or mapped proving key */
+    template<typename ProvingKeyT>
+    bool is_expansion_of(const ProvingKeyT &pk) const
+    {
+        return (A_table.num_bases() == pk.A_query.size() &&
+                B_table.num_bases() == pk.B_query.values.size() &&
+                B_table.num_bases() == pk.B_query.indices.size() &&
+                H_table.num_bases() == pk.H_query.size() &&
+                L_table.num_bases() == pk.L_query.size() &&
+                pk_delta_g1 == pk.delta_g1);
+    }
+
+    bool operator==(const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &other) const;
+    friend std::ostream& operator<< <ppT>(std::ostream &out, const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &epk);
+    friend std::istream& operator>> <ppT>(std::istream &in, r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &epk);
+};
+
+
 /******************************* Verification key ****************************/
 
 template<typename ppT>
@@ -239,22 +306,34 @@ std::ostream& operator<<(std::ostream &out, const r1cs_gg_ppzksnark_zok_processe
 template<typename ppT>
 std::istream& operator>>(std::istream &in, r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> &pvk);
 
+/* Inputs from which processed verification keys hold a table of gamma_ABC_g1 */
+const size_t r1cs_gg_ppzksnark_zok_input_table_threshold = 16;
+
 /**
  * A processed verification key for the R1CS GG-ppzkSNARK.
  *
  * Compared to a (non-processed) verification key, a processed verification key
  * contains a small constant amount of additional pre-computed information that
- * enables a faster verification time.
+ * enables a faster verification time: the G2 precomputations of gamma and
+ * delta, and the pairing e(alpha, beta), so a verifier that keeps it computes
+ * no pairing of the key's own points.
+ *
+ * Keys with at least r1cs_gg_ppzksnark_zok_input_table_threshold inputs also
+ * hold a fixed-base table of gamma_ABC_g1, through which the inputs are
+ * accumulated as one multi-exponentiation instead of a scalar multiplication
+ * per input.
  */
 template<typename ppT>
 class r1cs_gg_ppzksnark_zok_processed_verification_key {
 public:
     libff::G1<ppT> vk_alpha_g1;
     libff::G2<ppT> vk_beta_g2;
+    libff::GT<ppT> vk_alpha_g1_beta_g2;
     libff::G2_precomp<ppT> vk_gamma_g2_precomp;
     libff::G2_precomp<ppT> vk_delta_g2_precomp;
 
     accumulation_vector<libff::G1<ppT> > gamma_ABC_g1;
+    fixed_base_table<libff::G1<ppT> > gamma_ABC_table; // over gamma_ABC_g1.rest, empty for few inputs
 
     bool operator==(const r1cs_gg_ppzksnark_zok_processed_verification_key &other) const;
     friend std::ostream& operator<< <ppT>(std::ostream &out, const r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> &pvk);
@@ -360,6 +439,74 @@ public:
 };
 
 
+/****************************** Prover options *******************************/
+
+/**
+ * Multi-exponentiation engine used by the prover to evaluate a query.
+ */
+enum r1cs_gg_ppzksnark_zok_multi_exp_method {
+    /* libff::multi_exp_method_BDLO12, one bucket method per chunk of bases */
+    r1cs_gg_ppzksnark_zok_multi_exp_BDLO12,
+    /* Pippenger bucket method with windows sized to the whole query, see multiexp_pippenger.hpp */
+    r1cs_gg_ppzksnark_zok_multi_exp_pippenger,
+    /* As above, with the buckets accumulated by batches of affine additions */
+    r1cs_gg_ppzksnark_zok_multi_exp_pippenger_batch_affine
+};
+
+/**
+ * Tunables for the prover.
+ *
+ * The multi-exponentiation engine can be selected separately for each of the
+ * A, B, H and L queries.
+ *
+ * With `concurrent_stages` (and MULTICORE) the H polynomial and the four
+ * query evaluations run as OpenMP tasks sharing one thread team, instead of
+ * one after another. libff's profiler is not thread-safe, so this only
+ * happens when libff::inhibit_profiling_counters is set. The prover never
+ * changes that flag itself: callers running proofs from several threads at
+ * once must set it, and inhibit_profiling_info, beforehand, as
+ * prover_service does.
+ *
+ * A non-empty `scratch_directory` computes H out of core, with the evaluations
+ * of A, B and C in temporary files created there, see qap_witness_map.hpp.
+ * Only those are out of core: the full assignment and the m+1 coefficients
+ * of H, which the multi-exponentiations read, are still held in memory.
+ *
+ * `num_threads` sets the size of the prover's thread team, instead of taking
+ * it from OMP_NUM_THREADS, and `chunks` the number of pieces each
+ * multi-exponentiation is split into, by default one per thread. With a
+ * `numa_node` the team is pinned to that node's CPUs for the proof, see
+ * parallel_thread_scope.
+ *
+ * A non-null `metrics` is filled with the timings and sizes of the proof's
+ * stages, see prover_metrics.hpp.
+ */
+struct r1cs_gg_ppzksnark_zok_prover_options {
+    r1cs_gg_ppzksnark_zok_multi_exp_method A_query_method;
+    r1cs_gg_ppzksnark_zok_multi_exp_method B_query_method;
+    r1cs_gg_ppzksnark_zok_multi_exp_method H_query_method;
+    r1cs_gg_ppzksnark_zok_multi_exp_method L_query_method;
+    bool concurrent_stages;
+    std::string scratch_directory;
+    size_t num_threads;
+    int numa_node;
+    size_t chunks;
+    prover_metrics *metrics;
+
+    r1cs_gg_ppzksnark_zok_prover_options() :
+        A_query_method(r1cs_gg_ppzksnark_zok_multi_exp_pippenger),
+        B_query_method(r1cs_gg_ppzksnark_zok_multi_exp_pippenger),
+        H_query_method(r1cs_gg_ppzksnark_zok_multi_exp_pippenger),
+        L_query_method(r1cs_gg_ppzksnark_zok_multi_exp_pippenger),
+        concurrent_stages(true),
+        num_threads(0),
+        numa_node(-1),
+        chunks(0),
+        metrics(nullptr)
+    {}
+};
+
+
 /***************************** Main algorithms *******************************/
 
 /**
@@ -383,6 +530,65 @@ r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzk
                                                       const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
                                                       const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input);
 
+/**
+ * As above, with explicit prover options (e.g. the multi-exponentiation
+ * engine used for each query).
+ */
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options);
+
+/**
+ * Precompute the fixed-base tables of `pk`. A `window` of 0 picks a window
+ * size for each query from its length.
+ */
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> r1cs_gg_ppzksnark_zok_expand_proving_key(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                                                    const size_t window = 0);
+
+/**
+ * As above, evaluating the queries with the fixed-base tables of `expanded_pk`
+ * instead of the multi-exponentiation engines selected in `options`.
+ * Throws std::invalid_argument if they weren't built from `pk`.
+ */
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &expanded_pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options);
+
+/**
+ * A batch prover for the R1CS GG-ppzkSNARK.
+ *
+ * Produces one proof for every (primary_inputs[k], auxiliary_inputs[k]) pair,
+ * the result is the same as calling the prover on each of them. The query
+ * evaluations use multi_exp_pippenger_batch, which for queries small enough
+ * reads each block of the proving key once and applies it to a group of
+ * witnesses, instead of streaming the whole key once per proof.
+ *
+ * The H polynomials of all witnesses are held in memory at the same time, so
+ * large batches should be split by the caller.
+ */
+template<typename ppT>
+std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > r1cs_gg_ppzksnark_zok_prover_batch(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> > &auxiliary_inputs);
+
+/**
+ * As above, with the thread team, chunks, NUMA node and scratch directory of
+ * `options`. The queries are always evaluated by multi_exp_pippenger_batch,
+ * one after another, so the per-query methods, `concurrent_stages` and
+ * `metrics` are not used.
+ */
+template<typename ppT>
+std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > r1cs_gg_ppzksnark_zok_prover_batch(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> > &auxiliary_inputs,
+                                                                              const r1cs_gg_ppzksnark_zok_prover_options &options);
+
 /*
   Below are four variants of verifier algorithm for the R1CS GG-ppzkSNARK.
 
@@ -419,9 +625,12 @@ bool r1cs_gg_ppzksnark_zok_verifier_strong_IC(const r1cs_gg_ppzksnark_zok_verifi
 
 /**
  * Convert a (non-processed) verification key into a processed verification key.
+ * The table of gamma_ABC_g1, which costs about as much to build as one
+ * accumulation without it, is only built `with_input_table`.
  */
 template<typename ppT>
-r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> r1cs_gg_ppzksnark_zok_verifier_process_vk(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &vk);
+r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> r1cs_gg_ppzksnark_zok_verifier_process_vk(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &vk,
+                                                                                              const bool with_input_table = true);
 
 /**
  * A verifier algorithm for the R1CS GG-ppzkSNARK that:
@@ -443,6 +652,34 @@ bool r1cs_gg_ppzksnark_zok_online_verifier_strong_IC(const r1cs_gg_ppzksnark_zok
                                                  const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
                                                  const r1cs_gg_ppzksnark_zok_proof<ppT> &proof);
 
+/**
+ * Verify a batch of proofs against the same processed verification key, with
+ * strong input consistency. Returns true only if every proof is valid.
+ *
+ * Each proof's equation e(A, B) = e(alpha, beta) * e(acc, gamma) * e(C, delta)
+ * is raised to a random scalar r_i and the equations are multiplied together:
+ * one Miller loop per proof on (r_i * A_i, B_i), one double Miller loop for
+ * the input and C terms, which are combined into a single multi-exponentiation
+ * each, and a single final exponentiation, compared with the key's e(alpha,
+ * beta) to the power sum r_i. An invalid proof passes with probability about
+ * 1/r.
+ *
+ * The Miller loops run in parallel only when libff::inhibit_profiling_counters
+ * is set, which callers verifying from several threads at once must do.
+ */
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC(const r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> &pvk,
+                                                       const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                       const std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > &proofs);
+
+/**
+ * As above, with a (non-processed) verification key.
+ */
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &vk,
+                                                const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                const std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > &proofs);
+
 /****************************** Miscellaneous ********************************/
 
 /**
@@ -19,6 +19,8 @@ See r1cs_gg_ppzksnark_zok.hpp .
 #include <functional>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <type_traits>
 
 #include <libff/algebra/scalar_multiplication/multiexp.hpp>
 #include <libff/common/profiling.hpp>
@@ -31,8 +33,19 @@ See r1cs_gg_ppzksnark_zok.hpp .
 #include <libsnark/knowledge_commitment/kc_multiexp.hpp>
 #include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
 
+#include "r1cs_gg_ppzksnark_zok/glv.hpp"
+#include "r1cs_gg_ppzksnark_zok/multiexp_pippenger.hpp"
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+#include "r1cs_gg_ppzksnark_zok/qap_witness_map.hpp"
+
 namespace libsnark {
 
+/* Variables handled per task by the generator's loops over the QAP */
+const size_t r1cs_gg_ppzksnark_zok_generator_grain = 1ul << 12;
+
+/* Proofs whose Miller loops are computed per task by the batch verifier */
+const size_t r1cs_gg_ppzksnark_zok_verifier_batch_grain = 8;
+
 template<typename ppT>
 bool r1cs_gg_ppzksnark_zok_proving_key<ppT>::operator==(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &other) const
 {
@@ -87,6 +100,41 @@ std::istream& operator>>(std::istream &in, r1cs_gg_ppzksnark_zok_proving_key<ppT
     return in;
 }
 
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT>::operator==(const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &other) const
+{
+    return (this->A_table == other.A_table &&
+            this->B_table == other.B_table &&
+            this->H_table == other.H_table &&
+            this->L_table == other.L_table &&
+            this->pk_delta_g1 == other.pk_delta_g1);
+}
+
+template<typename ppT>
+std::ostream& operator<<(std::ostream &out, const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &epk)
+{
+    out << epk.A_table;
+    out << epk.B_table;
+    out << epk.H_table;
+    out << epk.L_table;
+    out << epk.pk_delta_g1 << OUTPUT_NEWLINE;
+
+    return out;
+}
+
+template<typename ppT>
+std::istream& operator>>(std::istream &in, r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &epk)
+{
+    in >> epk.A_table;
+    in >> epk.B_table;
+    in >> epk.H_table;
+    in >> epk.L_table;
+    in >> epk.pk_delta_g1;
+    libff::consume_OUTPUT_NEWLINE(in);
+
+    return in;
+}
+
 template<typename ppT>
 bool r1cs_gg_ppzksnark_zok_verification_key<ppT>::operator==(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &other) const
 {
@@ -131,9 +179,11 @@ bool r1cs_gg_ppzksnark_zok_processed_verification_key<ppT>::operator==(const r1c
 {
     return (this->vk_alpha_g1 == other.vk_alpha_g1 &&
             this->vk_beta_g2 == other.vk_beta_g2 &&
+            this->vk_alpha_g1_beta_g2 == other.vk_alpha_g1_beta_g2 &&
             this->vk_gamma_g2_precomp == other.vk_gamma_g2_precomp &&
             this->vk_delta_g2_precomp == other.vk_delta_g2_precomp &&
-            this->gamma_ABC_g1 == other.gamma_ABC_g1);
+            this->gamma_ABC_g1 == other.gamma_ABC_g1 &&
+            this->gamma_ABC_table == other.gamma_ABC_table);
 }
 
 template<typename ppT>
@@ -141,9 +191,11 @@ std::ostream& operator<<(std::ostream &out, const r1cs_gg_ppzksnark_zok_processe
 {
     out << pvk.vk_alpha_g1 << OUTPUT_NEWLINE;
     out << pvk.vk_beta_g2 << OUTPUT_NEWLINE;
+    out << pvk.vk_alpha_g1_beta_g2 << OUTPUT_NEWLINE;
     out << pvk.vk_gamma_g2_precomp << OUTPUT_NEWLINE;
     out << pvk.vk_delta_g2_precomp << OUTPUT_NEWLINE;
     out << pvk.gamma_ABC_g1 << OUTPUT_NEWLINE;
+    out << pvk.gamma_ABC_table << OUTPUT_NEWLINE;
 
     return out;
 }
@@ -155,12 +207,16 @@ std::istream& operator>>(std::istream &in, r1cs_gg_ppzksnark_zok_processed_verif
     libff::consume_OUTPUT_NEWLINE(in);
     in >> pvk.vk_beta_g2;
     libff::consume_OUTPUT_NEWLINE(in);
+    in >> pvk.vk_alpha_g1_beta_g2;
+    libff::consume_OUTPUT_NEWLINE(in);
     in >> pvk.vk_gamma_g2_precomp;
     libff::consume_OUTPUT_NEWLINE(in);
     in >> pvk.vk_delta_g2_precomp;
     libff::consume_OUTPUT_NEWLINE(in);
     in >> pvk.gamma_ABC_g1;
     libff::consume_OUTPUT_NEWLINE(in);
+    in >> pvk.gamma_ABC_table;
+    libff::consume_OUTPUT_NEWLINE(in);
 
     return in;
 }
@@ -236,7 +292,7 @@ r1cs_gg_ppzksnark_zok_keypair<ppT> r1cs_gg_ppzksnark_zok_generator(const r1cs_gg
     const libff::Fr<ppT> delta_inverse = delta.inverse();
 
     /* A quadratic arithmetic program evaluated at t. */
-    qap_instance_evaluation<libff::Fr<ppT> > qap = r1cs_to_qap_instance_map_with_evaluation(r1cs_copy, t);
+    qap_instance_evaluation<libff::Fr<ppT> > qap = r1cs_gg_ppzksnark_zok_instance_map_with_evaluation(r1cs_copy, t);
 
     libff::print_indent(); printf("* QAP number of variables: %zu\n", qap.num_variables());
     libff::print_indent(); printf("* QAP pre degree: %zu\n", r1cs_copy.constraints.size());
@@ -244,18 +300,29 @@ r1cs_gg_ppzksnark_zok_keypair<ppT> r1cs_gg_ppzksnark_zok_generator(const r1cs_gg
     libff::print_indent(); printf("* QAP number of input variables: %zu\n", qap.num_inputs());
 
     libff::enter_block("Compute query densities");
+    const size_t num_density_ranges = (qap.num_variables() + 1 + r1cs_gg_ppzksnark_zok_generator_grain - 1) / r1cs_gg_ppzksnark_zok_generator_grain;
+    std::vector<size_t> range_non_zero_At(num_density_ranges, 0);
+    std::vector<size_t> range_non_zero_Bt(num_density_ranges, 0);
+    parallel_for_ranges(qap.num_variables() + 1, r1cs_gg_ppzksnark_zok_generator_grain, [&](const size_t begin, const size_t end) {
+        const size_t range = begin / r1cs_gg_ppzksnark_zok_generator_grain;
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (!qap.At[i].is_zero())
+            {
+                ++range_non_zero_At[range];
+            }
+            if (!qap.Bt[i].is_zero())
+            {
+                ++range_non_zero_Bt[range];
+            }
+        }
+    });
     size_t non_zero_At = 0;
     size_t non_zero_Bt = 0;
-    for (size_t i = 0; i < qap.num_variables() + 1; ++i)
+    for (size_t range = 0; range < num_density_ranges; ++range)
     {
-        if (!qap.At[i].is_zero())
-        {
-            ++non_zero_At;
-        }
-        if (!qap.Bt[i].is_zero())
-        {
-            ++non_zero_Bt;
-        }
+        non_zero_At += range_non_zero_At[range];
+        non_zero_Bt += range_non_zero_Bt[range];
     }
     libff::leave_block("Compute query densities");
 
@@ -267,26 +334,28 @@ r1cs_gg_ppzksnark_zok_keypair<ppT> r1cs_gg_ppzksnark_zok_generator(const r1cs_gg
 
     /* The gamma inverse product component: (beta*A_i(t) + alpha*B_i(t) + C_i(t)) * gamma^{-1}. */
     libff::enter_block("Compute gamma_ABC for R1CS verification key");
-    libff::Fr_vector<ppT> gamma_ABC;
-    gamma_ABC.reserve(qap.num_inputs());
+    libff::Fr_vector<ppT> gamma_ABC(qap.num_inputs());
 
     const libff::Fr<ppT> gamma_ABC_0 = (beta * At[0] + alpha * Bt[0] + Ct[0]) * gamma_inverse;
-    for (size_t i = 1; i < qap.num_inputs() + 1; ++i)
-    {
-        gamma_ABC.emplace_back((beta * At[i] + alpha * Bt[i] + Ct[i]) * gamma_inverse);
-    }
+    parallel_for_ranges(qap.num_inputs(), r1cs_gg_ppzksnark_zok_generator_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            gamma_ABC[i] = (beta * At[i + 1] + alpha * Bt[i + 1] + Ct[i + 1]) * gamma_inverse;
+        }
+    });
     libff::leave_block("Compute gamma_ABC for R1CS verification key");
 
     /* The delta inverse product component: (beta*A_i(t) + alpha*B_i(t) + C_i(t)) * delta^{-1}. */
     libff::enter_block("Compute L query for R1CS proving key");
-    libff::Fr_vector<ppT> Lt;
-    Lt.reserve(qap.num_variables() - qap.num_inputs());
+    libff::Fr_vector<ppT> Lt(qap.num_variables() - qap.num_inputs());
 
     const size_t Lt_offset = qap.num_inputs() + 1;
-    for (size_t i = 0; i < qap.num_variables() - qap.num_inputs(); ++i)
-    {
-        Lt.emplace_back((beta * At[Lt_offset + i] + alpha * Bt[Lt_offset + i] + Ct[Lt_offset + i]) * delta_inverse);
-    }
+    parallel_for_ranges(Lt.size(), r1cs_gg_ppzksnark_zok_generator_grain, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            Lt[i] = (beta * At[Lt_offset + i] + alpha * Bt[Lt_offset + i] + Ct[Lt_offset + i]) * delta_inverse;
+        }
+    });
     libff::leave_block("Compute L query for R1CS proving key");
 
     /**
@@ -396,140 +465,752 @@ r1cs_gg_ppzksnark_zok_keypair<ppT> r1cs_gg_ppzksnark_zok_generator(const r1cs_gg
     return r1cs_gg_ppzksnark_zok_keypair<ppT>(std::move(pk), std::move(vk));
 }
 
-template <typename ppT>
-r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
-                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
-                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input)
+/**
+ * libff's BDLO12 engine only takes std::vector iterators, bases held elsewhere
+ * (e.g. in a mapped proving key) are evaluated with the Pippenger engine.
+ */
+template<typename T, typename FieldT>
+T r1cs_gg_ppzksnark_zok_multi_exp_BDLO12(typename std::vector<T>::const_iterator vec_start,
+                                         typename std::vector<T>::const_iterator vec_end,
+                                         typename std::vector<FieldT>::const_iterator scalar_start,
+                                         typename std::vector<FieldT>::const_iterator scalar_end,
+                                         const size_t chunks,
+                                         const bool mixed_addition,
+                                         std::true_type)
 {
-    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_prover");
+    if (mixed_addition)
+    {
+        return libff::multi_exp_with_mixed_addition<T, FieldT, libff::multi_exp_method_BDLO12>(vec_start, vec_end, scalar_start, scalar_end, chunks);
+    }
 
-#ifdef DEBUG
-    assert(pk.constraint_system.is_satisfied(primary_input, auxiliary_input));
-#endif
+    return libff::multi_exp<T, FieldT, libff::multi_exp_method_BDLO12>(vec_start, vec_end, scalar_start, scalar_end, chunks);
+}
+
+template<typename T, typename FieldT, typename BaseIterT>
+T r1cs_gg_ppzksnark_zok_multi_exp_BDLO12(BaseIterT vec_start,
+                                         BaseIterT vec_end,
+                                         typename std::vector<FieldT>::const_iterator scalar_start,
+                                         typename std::vector<FieldT>::const_iterator scalar_end,
+                                         const size_t chunks,
+                                         const bool mixed_addition,
+                                         std::false_type)
+{
+    if (mixed_addition)
+    {
+        return multi_exp_pippenger_with_mixed_addition<T, FieldT>(vec_start, vec_end, scalar_start, scalar_end, chunks);
+    }
+
+    return multi_exp_pippenger<T, FieldT>(vec_start, vec_end, scalar_start, scalar_end, chunks);
+}
 
-    libff::enter_block("Compute the polynomial H");
-    const qap_witness<libff::Fr<ppT> > qap_wit = r1cs_to_qap_witness_map(pk.constraint_system, primary_input, auxiliary_input, libff::Fr<ppT>::zero(), libff::Fr<ppT>::zero(), libff::Fr<ppT>::zero());
+/**
+ * Evaluate a G1 query with the multi-exponentiation engine selected by `method`.
+ */
+template<typename T, typename FieldT, typename BaseIterT>
+T r1cs_gg_ppzksnark_zok_multi_exp(const r1cs_gg_ppzksnark_zok_multi_exp_method method,
+                                  BaseIterT vec_start,
+                                  BaseIterT vec_end,
+                                  typename std::vector<FieldT>::const_iterator scalar_start,
+                                  typename std::vector<FieldT>::const_iterator scalar_end,
+                                  const size_t chunks)
+{
+    if (method != r1cs_gg_ppzksnark_zok_multi_exp_BDLO12)
+    {
+        const bool batch_affine = (method == r1cs_gg_ppzksnark_zok_multi_exp_pippenger_batch_affine);
+        return multi_exp_pippenger<T, FieldT>(vec_start, vec_end, scalar_start, scalar_end, chunks, batch_affine);
+    }
 
-    /* We are dividing degree 2(d-1) polynomial by degree d polynomial
-       and not adding a PGHR-style ZK-patch, so our H is degree d-2 */
-    assert(!qap_wit.coefficients_for_H[qap_wit.degree()-2].is_zero());
-    assert(qap_wit.coefficients_for_H[qap_wit.degree()-1].is_zero());
-    assert(qap_wit.coefficients_for_H[qap_wit.degree()].is_zero());
-    libff::leave_block("Compute the polynomial H");
+    return r1cs_gg_ppzksnark_zok_multi_exp_BDLO12<T, FieldT>(vec_start, vec_end, scalar_start, scalar_end, chunks, false,
+                                                             std::is_same<BaseIterT, typename std::vector<T>::const_iterator>());
+}
 
-#ifdef DEBUG
-    const libff::Fr<ppT> t = libff::Fr<ppT>::random_element();
-    qap_instance_evaluation<libff::Fr<ppT> > qap_inst = r1cs_to_qap_instance_map_with_evaluation(pk.constraint_system, t);
-    assert(qap_inst.is_satisfied(qap_wit));
-#endif
+template<typename T, typename FieldT, typename BaseIterT>
+T r1cs_gg_ppzksnark_zok_multi_exp_with_mixed_addition(const r1cs_gg_ppzksnark_zok_multi_exp_method method,
+                                                      BaseIterT vec_start,
+                                                      BaseIterT vec_end,
+                                                      typename std::vector<FieldT>::const_iterator scalar_start,
+                                                      typename std::vector<FieldT>::const_iterator scalar_end,
+                                                      const size_t chunks)
+{
+    if (method != r1cs_gg_ppzksnark_zok_multi_exp_BDLO12)
+    {
+        const bool batch_affine = (method == r1cs_gg_ppzksnark_zok_multi_exp_pippenger_batch_affine);
+        return multi_exp_pippenger_with_mixed_addition<T, FieldT>(vec_start, vec_end, scalar_start, scalar_end, chunks, batch_affine);
+    }
+
+    return r1cs_gg_ppzksnark_zok_multi_exp_BDLO12<T, FieldT>(vec_start, vec_end, scalar_start, scalar_end, chunks, true,
+                                                             std::is_same<BaseIterT, typename std::vector<T>::const_iterator>());
+}
+
+/**
+ * As above, libsnark's BDLO12 engine for knowledge commitments only takes a
+ * knowledge_commitment_vector.
+ */
+template<typename T1, typename T2, typename FieldT>
+knowledge_commitment<T1, T2> r1cs_gg_ppzksnark_zok_kc_multi_exp_BDLO12(const knowledge_commitment_vector<T1, T2> &vec,
+                                                                      const size_t min_idx,
+                                                                      const size_t max_idx,
+                                                                      typename std::vector<FieldT>::const_iterator scalar_start,
+                                                                      typename std::vector<FieldT>::const_iterator scalar_end,
+                                                                      const size_t chunks,
+                                                                      std::true_type)
+{
+    return kc_multi_exp_with_mixed_addition<T1, T2, FieldT, libff::multi_exp_method_BDLO12>(vec, min_idx, max_idx, scalar_start, scalar_end, chunks);
+}
+
+template<typename T1, typename T2, typename FieldT, typename KCVectorT>
+knowledge_commitment<T1, T2> r1cs_gg_ppzksnark_zok_kc_multi_exp_BDLO12(const KCVectorT &vec,
+                                                                      const size_t min_idx,
+                                                                      const size_t max_idx,
+                                                                      typename std::vector<FieldT>::const_iterator scalar_start,
+                                                                      typename std::vector<FieldT>::const_iterator scalar_end,
+                                                                      const size_t chunks,
+                                                                      std::false_type)
+{
+    return kc_multi_exp_pippenger_with_mixed_addition<T1, T2, FieldT>(vec, min_idx, max_idx, scalar_start, scalar_end, chunks);
+}
+
+/**
+ * Evaluate the knowledge-commitment B query with the engine selected by `method`.
+ */
+template<typename T1, typename T2, typename FieldT, typename KCVectorT>
+knowledge_commitment<T1, T2> r1cs_gg_ppzksnark_zok_kc_multi_exp_with_mixed_addition(const r1cs_gg_ppzksnark_zok_multi_exp_method method,
+                                                                                   const KCVectorT &vec,
+                                                                                   const size_t min_idx,
+                                                                                   const size_t max_idx,
+                                                                                   typename std::vector<FieldT>::const_iterator scalar_start,
+                                                                                   typename std::vector<FieldT>::const_iterator scalar_end,
+                                                                                   const size_t chunks)
+{
+    if (method != r1cs_gg_ppzksnark_zok_multi_exp_BDLO12)
+    {
+        const bool batch_affine = (method == r1cs_gg_ppzksnark_zok_multi_exp_pippenger_batch_affine);
+        return kc_multi_exp_pippenger_with_mixed_addition<T1, T2, FieldT>(vec, min_idx, max_idx, scalar_start, scalar_end, chunks, batch_affine);
+    }
+
+    return r1cs_gg_ppzksnark_zok_kc_multi_exp_BDLO12<T1, T2, FieldT>(vec, min_idx, max_idx, scalar_start, scalar_end, chunks,
+                                                                     std::is_same<KCVectorT, knowledge_commitment_vector<T1, T2> >());
+}
+
+template<typename ppT>
+r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> r1cs_gg_ppzksnark_zok_expand_proving_key(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                                                    const size_t window)
+{
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_expand_proving_key");
+
+    r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> expanded_pk;
+
+    libff::enter_block("Compute the A-query table");
+    expanded_pk.A_table = fixed_base_table_build<libff::G1<ppT>, libff::Fr<ppT> >(pk.A_query.begin(), pk.A_query.end(), window);
+    libff::leave_block("Compute the A-query table");
+
+    libff::enter_block("Compute the B-query table");
+    expanded_pk.B_table = fixed_base_table_build<knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> >, libff::Fr<ppT> >(pk.B_query.values.begin(), pk.B_query.values.end(), window);
+    libff::leave_block("Compute the B-query table");
+
+    libff::enter_block("Compute the H-query table");
+    expanded_pk.H_table = fixed_base_table_build<libff::G1<ppT>, libff::Fr<ppT> >(pk.H_query.begin(), pk.H_query.end(), window);
+    libff::leave_block("Compute the H-query table");
+
+    libff::enter_block("Compute the L-query table");
+    expanded_pk.L_table = fixed_base_table_build<libff::G1<ppT>, libff::Fr<ppT> >(pk.L_query.begin(), pk.L_query.end(), window);
+    libff::leave_block("Compute the L-query table");
+
+    expanded_pk.pk_delta_g1 = pk.delta_g1;
+    expanded_pk.print_size();
+
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_expand_proving_key");
+
+    return expanded_pk;
+}
+
+/**
+ * The last step of the prover: picks r and s, and combines the evaluations of
+ * the queries into the proof.
+ */
+template <typename ppT, typename ProvingKeyT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover_finish(const ProvingKeyT &pk,
+                                                                 const libff::G1<ppT> &evaluation_At,
+                                                                 const knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> > &evaluation_Bt,
+                                                                 const libff::G1<ppT> &evaluation_Ht,
+                                                                 const libff::G1<ppT> &evaluation_Lt)
+{
+    /* The G1 scalar multiplications below use the curve's endomorphism when it has one */
+    typedef libff::G1<ppT> G1;
+    typedef libff::Fr<ppT> Fr;
 
     /* Choose two random field elements for prover zero-knowledge. */
     const libff::Fr<ppT> r = libff::Fr<ppT>::random_element();
     const libff::Fr<ppT> s = libff::Fr<ppT>::random_element();
 
+    /* A = alpha + sum_i(a_i*A_i(t)) + r*delta */
+    libff::G1<ppT> g1_A = pk.alpha_g1 + evaluation_At + glv_scalar_mul<G1, Fr>(r, pk.delta_g1);
+
+    /* B = beta + sum_i(a_i*B_i(t)) + s*delta */
+    libff::G1<ppT> g1_B = pk.beta_g1 + evaluation_Bt.h + glv_scalar_mul<G1, Fr>(s, pk.delta_g1);
+    libff::G2<ppT> g2_B = pk.beta_g2 + evaluation_Bt.g + s * pk.delta_g2;
+
+    /* C = sum_i(a_i*((beta*A_i(t) + alpha*B_i(t) + C_i(t)) + H(t)*Z(t))/delta) + A*s + r*b - r*s*delta */
+    libff::G1<ppT> g1_C = evaluation_Ht + evaluation_Lt + glv_scalar_mul<G1, Fr>(s, g1_A) + glv_scalar_mul<G1, Fr>(r, g1_B) - glv_scalar_mul<G1, Fr>(r * s, pk.delta_g1);
+
+    return r1cs_gg_ppzksnark_zok_proof<ppT>(std::move(g1_A), std::move(g2_B), std::move(g1_C));
+}
+
+/**
+ * The prover, evaluating the queries with the tables of `expanded_pk` when
+ * it isn't null, for the constraint system of the key given as `matrices`.
+ * ProvingKeyT is r1cs_gg_ppzksnark_zok_proving_key or any key with the same
+ * points and queries, whose queries provide random-access iterators, such
+ * as r1cs_gg_ppzksnark_zok_mapped_proving_key.
+ */
+template <typename ppT, typename ProvingKeyT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover_with_tables(const ProvingKeyT &pk,
+                                                                      const qap_constraint_matrices<libff::Fr<ppT> > &matrices,
+                                                                      const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> *expanded_pk,
+                                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                                      const r1cs_gg_ppzksnark_zok_prover_options &options)
+{
+    /* stale tables, e.g. left over from a previous key, would index past the queries */
+    if (expanded_pk != nullptr && !expanded_pk->is_expansion_of(pk))
+    {
+        throw std::invalid_argument("expanded proving key was not built from this proving key");
+    }
+
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_prover");
+
 #ifdef DEBUG
-    assert(qap_wit.coefficients_for_ABCs.size() == qap_wit.num_variables());
-    assert(pk.A_query.size() == qap_wit.num_variables()+1);
-    assert(pk.B_query.domain_size() == qap_wit.num_variables()+1);
-    assert(pk.H_query.size() == qap_wit.degree() - 1);
-    assert(pk.L_query.size() == qap_wit.num_variables() - qap_wit.num_inputs());
+    r1cs_gg_ppzksnark_zok_constraint_system<ppT> constraint_system;
+    qap_make_constraint_system(matrices, constraint_system);
+    assert(constraint_system.is_satisfied(primary_input, auxiliary_input));
 #endif
 
-#ifdef MULTICORE
-    const size_t chunks = omp_get_max_threads(); // to override, set OMP_NUM_THREADS env var or call omp_set_num_threads()
-#else
-    const size_t chunks = 1;
+    const size_t num_variables = matrices.num_variables;
+    const size_t num_inputs = matrices.num_inputs;
+
+#ifdef DEBUG
+    assert(primary_input.size() + auxiliary_input.size() == num_variables);
+    assert(pk.A_query.size() == num_variables+1);
+    assert(pk.B_query.domain_size() == num_variables+1);
+    assert(pk.L_query.size() == num_variables - num_inputs);
 #endif
 
+    const parallel_thread_scope thread_scope(options.num_threads, options.numa_node);
+    const size_t num_threads = parallel_num_threads(); // options.num_threads, or OMP_NUM_THREADS
+    const size_t chunks = (options.chunks > 0 ? options.chunks : num_threads);
+
+    /* libff's profiler keeps global state and is not thread-safe, so the
+       stages only overlap when the caller has inhibited its blocks. */
+    const bool concurrent_stages = (options.concurrent_stages && num_threads > 1 && libff::inhibit_profiling_counters);
+
+    /* The caller's metrics, or our own when they are only exported */
+    const std::string metrics_path = prover_metrics_path();
+    prover_metrics exported_metrics;
+    prover_metrics *metrics = (options.metrics != nullptr ? options.metrics : (metrics_path.empty() ? nullptr : &exported_metrics));
+    if (metrics != nullptr)
+    {
+        metrics->num_constraints = matrices.num_constraints;
+        metrics->num_variables = num_variables;
+        metrics->num_inputs = num_inputs;
+        metrics->num_threads = num_threads;
+        metrics->chunks = chunks;
+        metrics->concurrent_stages = concurrent_stages;
+        metrics->begin();
+    }
+
     libff::enter_block("Compute the proof");
 
-    libff::enter_block("Compute evaluation to A-query", false);
+    /* The A, B and L queries only need the assignment, which is built here
+       rather than taken from the QAP witness so they don't wait for H. */
     // TODO: sort out indexing
     libff::Fr_vector<ppT> const_padded_assignment(1, libff::Fr<ppT>::one());
-    const_padded_assignment.insert(const_padded_assignment.end(), qap_wit.coefficients_for_ABCs.begin(), qap_wit.coefficients_for_ABCs.end());
+    const_padded_assignment.reserve(num_variables + 1);
+    const_padded_assignment.insert(const_padded_assignment.end(), primary_input.begin(), primary_input.end());
+    const_padded_assignment.insert(const_padded_assignment.end(), auxiliary_input.begin(), auxiliary_input.end());
+
+    libff::G1<ppT> evaluation_At;
+    knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> > evaluation_Bt;
+    libff::G1<ppT> evaluation_Ht;
+    libff::G1<ppT> evaluation_Lt;
+
+    auto compute_H = [&]() {
+        libff::enter_block("Compute the polynomial H");
+        prover_stage_timer witness_map_timer(metrics, prover_stage_witness_map);
+        const qap_witness<libff::Fr<ppT> > qap_wit = r1cs_gg_ppzksnark_zok_witness_map(matrices, primary_input, auxiliary_input, options.scratch_directory);
+        witness_map_timer.stop();
+
+        /* We are dividing degree 2(d-1) polynomial by degree d polynomial
+           and not adding a PGHR-style ZK-patch, so our H is degree d-2 */
+        assert(!qap_wit.coefficients_for_H[qap_wit.degree()-2].is_zero());
+        assert(qap_wit.coefficients_for_H[qap_wit.degree()-1].is_zero());
+        assert(qap_wit.coefficients_for_H[qap_wit.degree()].is_zero());
+        libff::leave_block("Compute the polynomial H");
+
+#ifdef DEBUG
+        const libff::Fr<ppT> t = libff::Fr<ppT>::random_element();
+        qap_instance_evaluation<libff::Fr<ppT> > qap_inst = r1cs_to_qap_instance_map_with_evaluation(constraint_system, t);
+        assert(qap_inst.is_satisfied(qap_wit));
+        assert(pk.H_query.size() == qap_wit.degree() - 1);
+#endif
+
+        if (metrics != nullptr)
+        {
+            metrics->stages[prover_stage_witness_map].domain_size = qap_wit.degree();
+            metrics->record_msm(prover_stage_H,
+                                qap_wit.coefficients_for_H.cbegin(),
+                                qap_wit.coefficients_for_H.cbegin() + (qap_wit.degree() - 1),
+                                sizeof(libff::G1<ppT>));
+        }
+
+        libff::enter_block("Compute evaluation to H-query", false);
+        const prover_stage_timer timer(metrics, prover_stage_H);
+        if (expanded_pk != nullptr)
+        {
+            evaluation_Ht = fixed_base_multi_exp<libff::G1<ppT>, libff::Fr<ppT> >(
+                expanded_pk->H_table,
+                qap_wit.coefficients_for_H.begin(),
+                qap_wit.coefficients_for_H.begin() + (qap_wit.degree() - 1),
+                chunks);
+        }
+        else
+        {
+            evaluation_Ht = r1cs_gg_ppzksnark_zok_multi_exp<libff::G1<ppT>,
+                                                            libff::Fr<ppT> >(
+                options.H_query_method,
+                pk.H_query.begin(),
+                pk.H_query.begin() + (qap_wit.degree() - 1),
+                qap_wit.coefficients_for_H.begin(),
+                qap_wit.coefficients_for_H.begin() + (qap_wit.degree() - 1),
+                chunks);
+        }
+        libff::leave_block("Compute evaluation to H-query", false);
+    };
+
+    auto compute_A = [&]() {
+        if (metrics != nullptr)
+        {
+            metrics->record_msm(prover_stage_A,
+                                const_padded_assignment.cbegin(),
+                                const_padded_assignment.cbegin() + num_variables + 1,
+                                sizeof(libff::G1<ppT>));
+        }
+
+        libff::enter_block("Compute evaluation to A-query", false);
+        const prover_stage_timer timer(metrics, prover_stage_A);
+        if (expanded_pk != nullptr)
+        {
+            evaluation_At = fixed_base_multi_exp<libff::G1<ppT>, libff::Fr<ppT> >(
+                expanded_pk->A_table,
+                const_padded_assignment.cbegin(),
+                const_padded_assignment.cbegin() + num_variables + 1,
+                chunks);
+        }
+        else
+        {
+            evaluation_At = r1cs_gg_ppzksnark_zok_multi_exp_with_mixed_addition<libff::G1<ppT>,
+                                                                                libff::Fr<ppT> >(
+                options.A_query_method,
+                pk.A_query.begin(),
+                pk.A_query.begin() + num_variables + 1,
+                const_padded_assignment.cbegin(),
+                const_padded_assignment.cbegin() + num_variables + 1,
+                chunks);
+        }
+        libff::leave_block("Compute evaluation to A-query", false);
+    };
+
+    auto compute_B = [&]() {
+        if (metrics != nullptr)
+        {
+            metrics->record_msm(prover_stage_B,
+                                const_padded_assignment.cbegin(),
+                                const_padded_assignment.cbegin() + num_variables + 1,
+                                sizeof(knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> >));
+        }
+
+        libff::enter_block("Compute evaluation to B-query", false);
+        const prover_stage_timer timer(metrics, prover_stage_B);
+        if (expanded_pk != nullptr)
+        {
+            /* the table covers the non-zero entries of B_query only */
+            libff::Fr_vector<ppT> B_scalars(expanded_pk->B_table.num_bases());
+            for (size_t i = 0; i < B_scalars.size(); ++i)
+            {
+                B_scalars[i] = const_padded_assignment[pk.B_query.indices[i]];
+            }
+
+            evaluation_Bt = fixed_base_multi_exp<knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> >, libff::Fr<ppT> >(
+                expanded_pk->B_table,
+                B_scalars.cbegin(),
+                B_scalars.cend(),
+                chunks);
+        }
+        else
+        {
+            evaluation_Bt = r1cs_gg_ppzksnark_zok_kc_multi_exp_with_mixed_addition<libff::G2<ppT>,
+                                                                                   libff::G1<ppT>,
+                                                                                   libff::Fr<ppT> >(
+                options.B_query_method,
+                pk.B_query,
+                0,
+                num_variables + 1,
+                const_padded_assignment.cbegin(),
+                const_padded_assignment.cbegin() + num_variables + 1,
+                chunks);
+        }
+        libff::leave_block("Compute evaluation to B-query", false);
+    };
+
+    auto compute_L = [&]() {
+        if (metrics != nullptr)
+        {
+            metrics->record_msm(prover_stage_L,
+                                const_padded_assignment.cbegin() + num_inputs + 1,
+                                const_padded_assignment.cbegin() + num_variables + 1,
+                                sizeof(libff::G1<ppT>));
+        }
+
+        libff::enter_block("Compute evaluation to L-query", false);
+        const prover_stage_timer timer(metrics, prover_stage_L);
+        if (expanded_pk != nullptr)
+        {
+            evaluation_Lt = fixed_base_multi_exp<libff::G1<ppT>, libff::Fr<ppT> >(
+                expanded_pk->L_table,
+                const_padded_assignment.cbegin() + num_inputs + 1,
+                const_padded_assignment.cbegin() + num_variables + 1,
+                chunks);
+        }
+        else
+        {
+            evaluation_Lt = r1cs_gg_ppzksnark_zok_multi_exp_with_mixed_addition<libff::G1<ppT>,
+                                                                                libff::Fr<ppT> >(
+                options.L_query_method,
+                pk.L_query.begin(),
+                pk.L_query.end(),
+                const_padded_assignment.cbegin() + num_inputs + 1,
+                const_padded_assignment.cbegin() + num_variables + 1,
+                chunks);
+        }
+        libff::leave_block("Compute evaluation to L-query", false);
+    };
+
+#ifdef MULTICORE
+    if (concurrent_stages)
+    {
+        /* each stage is timed here instead of by libff's blocks */
+        const char *stage_names[4] = {"H", "B-query", "A-query", "L-query"};
+        const std::function<void()> stages[4] = {compute_H, compute_B, compute_A, compute_L};
+        long long stage_start[4];
+        long long stage_end[4];
+
+        const long long concurrent_start = libff::get_nsec_time();
+
+        /* H is queued first as it is the longest chain (witness map, then
+           its multi-exponentiation); the kernels of every stage spawn their
+           own tasks, which idle threads pick up. */
+#pragma omp parallel num_threads(num_threads)
+#pragma omp single
+        {
+            for (size_t i = 0; i < 4; ++i)
+            {
+#pragma omp task firstprivate(i)
+                {
+                    stage_start[i] = libff::get_nsec_time();
+                    stages[i]();
+                    stage_end[i] = libff::get_nsec_time();
+                }
+            }
+#pragma omp taskwait
+        }
 
-    libff::G1<ppT> evaluation_At = libff::multi_exp_with_mixed_addition<libff::G1<ppT>,
-                                                                        libff::Fr<ppT>,
-                                                                        libff::multi_exp_method_BDLO12>(
+        if (!libff::inhibit_profiling_info)
+        {
+            for (size_t i = 0; i < 4; ++i)
+            {
+                libff::print_indent(); printf("* Stage %s: started at +%.4fs, took %.4fs\n",
+                                              stage_names[i],
+                                              (stage_start[i] - concurrent_start) * 1e-9,
+                                              (stage_end[i] - stage_start[i]) * 1e-9);
+            }
+            libff::print_indent(); printf("* All stages: %.4fs on %zu threads\n",
+                                          (libff::get_nsec_time() - concurrent_start) * 1e-9, num_threads);
+        }
+    }
+    else
+#endif
+    {
+        compute_H();
+        compute_A();
+        compute_B();
+        compute_L();
+    }
+
+    r1cs_gg_ppzksnark_zok_proof<ppT> proof = r1cs_gg_ppzksnark_zok_prover_finish<ppT>(pk, evaluation_At, evaluation_Bt, evaluation_Ht, evaluation_Lt);
+
+    if (metrics != nullptr)
+    {
+        metrics->end();
+        if (!metrics_path.empty() && !prover_metrics_export(*metrics, metrics_path))
+        {
+            std::cerr << "Warning: cannot write prover metrics to " << metrics_path << std::endl;
+        }
+    }
+
+    libff::leave_block("Compute the proof");
+
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_prover");
+
+    proof.print_size();
+
+    return proof;
+}
+
+/**
+ * The prover with an owned proving key, whose constraint system is converted
+ * to matrices for each proof rather than kept beside it.
+ */
+template <typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover_with_tables(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                                      const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> *expanded_pk,
+                                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                                      const r1cs_gg_ppzksnark_zok_prover_options &options)
+{
+    libff::enter_block("Convert constraint system to matrices");
+    qap_constraint_matrices<libff::Fr<ppT> > matrices;
+    qap_make_constraint_matrices(pk.constraint_system, matrices);
+    libff::leave_block("Convert constraint system to matrices");
+
+    return r1cs_gg_ppzksnark_zok_prover_with_tables<ppT>(pk, matrices, expanded_pk, primary_input, auxiliary_input, options);
+}
+
+template <typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input)
+{
+    return r1cs_gg_ppzksnark_zok_prover<ppT>(pk, primary_input, auxiliary_input, r1cs_gg_ppzksnark_zok_prover_options());
+}
+
+template <typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options)
+{
+    return r1cs_gg_ppzksnark_zok_prover_with_tables<ppT>(pk, nullptr, primary_input, auxiliary_input, options);
+}
+
+template <typename ppT>
+r1cs_gg_ppzksnark_zok_proof<ppT> r1cs_gg_ppzksnark_zok_prover(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                      const r1cs_gg_ppzksnark_zok_expanded_proving_key<ppT> &expanded_pk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
+                                                      const r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> &auxiliary_input,
+                                                      const r1cs_gg_ppzksnark_zok_prover_options &options)
+{
+    return r1cs_gg_ppzksnark_zok_prover_with_tables<ppT>(pk, &expanded_pk, primary_input, auxiliary_input, options);
+}
+
+template <typename ppT>
+std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > r1cs_gg_ppzksnark_zok_prover_batch(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> > &auxiliary_inputs)
+{
+    return r1cs_gg_ppzksnark_zok_prover_batch<ppT>(pk, primary_inputs, auxiliary_inputs, r1cs_gg_ppzksnark_zok_prover_options());
+}
+
+template <typename ppT>
+std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > r1cs_gg_ppzksnark_zok_prover_batch(const r1cs_gg_ppzksnark_zok_proving_key<ppT> &pk,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                                              const std::vector<r1cs_gg_ppzksnark_zok_auxiliary_input<ppT> > &auxiliary_inputs,
+                                                                              const r1cs_gg_ppzksnark_zok_prover_options &options)
+{
+    typedef typename libff::Fr_vector<ppT>::const_iterator scalar_iterator;
+
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_prover_batch");
+    const long long batch_start = libff::get_nsec_time();
+
+    assert(primary_inputs.size() == auxiliary_inputs.size());
+    const size_t batch_size = primary_inputs.size();
+
+    const size_t num_variables = pk.constraint_system.num_variables();
+    const size_t num_inputs = pk.constraint_system.num_inputs();
+
+    const parallel_thread_scope thread_scope(options.num_threads, options.numa_node);
+    const size_t chunks = (options.chunks > 0 ? options.chunks : parallel_num_threads());
+
+    libff::enter_block("Compute the polynomials H");
+    /* converted once for the whole batch */
+    qap_constraint_matrices<libff::Fr<ppT> > matrices;
+    qap_make_constraint_matrices(pk.constraint_system, matrices);
+
+    std::vector<libff::Fr_vector<ppT> > const_padded_assignments(batch_size);
+    std::vector<libff::Fr_vector<ppT> > coefficients_for_H(batch_size);
+    size_t degree = 0;
+    for (size_t k = 0; k < batch_size; ++k)
+    {
+#ifdef DEBUG
+        assert(pk.constraint_system.is_satisfied(primary_inputs[k], auxiliary_inputs[k]));
+#endif
+        qap_witness<libff::Fr<ppT> > qap_wit = r1cs_gg_ppzksnark_zok_witness_map(matrices, primary_inputs[k], auxiliary_inputs[k], options.scratch_directory);
+        degree = qap_wit.degree();
+
+        libff::Fr_vector<ppT> &const_padded_assignment = const_padded_assignments[k];
+        const_padded_assignment.reserve(num_variables + 1);
+        const_padded_assignment.emplace_back(libff::Fr<ppT>::one());
+        const_padded_assignment.insert(const_padded_assignment.end(), qap_wit.coefficients_for_ABCs.begin(), qap_wit.coefficients_for_ABCs.end());
+
+        coefficients_for_H[k] = std::move(qap_wit.coefficients_for_H);
+    }
+    libff::leave_block("Compute the polynomials H");
+
+#ifdef DEBUG
+    assert(pk.A_query.size() == num_variables+1);
+    assert(pk.B_query.domain_size() == num_variables+1);
+    assert(batch_size == 0 || pk.H_query.size() == degree - 1);
+    assert(pk.L_query.size() == num_variables - num_inputs);
+#endif
+
+    libff::enter_block("Compute the proofs");
+
+    std::vector<scalar_iterator> A_scalars, H_scalars, L_scalars, B_scalars;
+    for (size_t k = 0; k < batch_size; ++k)
+    {
+        A_scalars.emplace_back(const_padded_assignments[k].cbegin());
+        H_scalars.emplace_back(coefficients_for_H[k].cbegin());
+        L_scalars.emplace_back(const_padded_assignments[k].cbegin() + num_inputs + 1);
+    }
+
+    libff::enter_block("Compute evaluation to A-query", false);
+    const std::vector<libff::G1<ppT> > evaluation_At = multi_exp_pippenger_batch<libff::G1<ppT>, libff::Fr<ppT> >(
         pk.A_query.begin(),
-        pk.A_query.begin() + qap_wit.num_variables() + 1,
-        const_padded_assignment.begin(),
-        const_padded_assignment.begin() + qap_wit.num_variables() + 1,
+        pk.A_query.begin() + num_variables + 1,
+        A_scalars,
         chunks);
     libff::leave_block("Compute evaluation to A-query", false);
 
     libff::enter_block("Compute evaluation to B-query", false);
-    knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> > evaluation_Bt = kc_multi_exp_with_mixed_addition<libff::G2<ppT>,
-                                                                                                           libff::G1<ppT>,
-                                                                                                           libff::Fr<ppT>,
-                                                                                                           libff::multi_exp_method_BDLO12>(
-        pk.B_query,
-        0,
-        qap_wit.num_variables() + 1,
-        const_padded_assignment.begin(),
-        const_padded_assignment.begin() + qap_wit.num_variables() + 1,
+    /* B_query is sparse, gather the scalars of its non-zero entries */
+    const size_t B_length = std::lower_bound(pk.B_query.indices.begin(), pk.B_query.indices.end(), num_variables + 1) - pk.B_query.indices.begin();
+    std::vector<libff::Fr_vector<ppT> > B_gathered(batch_size, libff::Fr_vector<ppT>(B_length));
+    for (size_t k = 0; k < batch_size; ++k)
+    {
+        for (size_t i = 0; i < B_length; ++i)
+        {
+            B_gathered[k][i] = const_padded_assignments[k][pk.B_query.indices[i]];
+        }
+        B_scalars.emplace_back(B_gathered[k].cbegin());
+    }
+
+    const std::vector<knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> > > evaluation_Bt = multi_exp_pippenger_batch<knowledge_commitment<libff::G2<ppT>, libff::G1<ppT> >, libff::Fr<ppT> >(
+        pk.B_query.values.begin(),
+        pk.B_query.values.begin() + B_length,
+        B_scalars,
         chunks);
     libff::leave_block("Compute evaluation to B-query", false);
 
     libff::enter_block("Compute evaluation to H-query", false);
-    libff::G1<ppT> evaluation_Ht = libff::multi_exp<libff::G1<ppT>,
-                                                    libff::Fr<ppT>,
-                                                    libff::multi_exp_method_BDLO12>(
+    const std::vector<libff::G1<ppT> > evaluation_Ht = multi_exp_pippenger_batch<libff::G1<ppT>, libff::Fr<ppT> >(
         pk.H_query.begin(),
-        pk.H_query.begin() + (qap_wit.degree() - 1),
-        qap_wit.coefficients_for_H.begin(),
-        qap_wit.coefficients_for_H.begin() + (qap_wit.degree() - 1),
+        pk.H_query.begin() + (degree - 1),
+        H_scalars,
         chunks);
     libff::leave_block("Compute evaluation to H-query", false);
 
     libff::enter_block("Compute evaluation to L-query", false);
-    libff::G1<ppT> evaluation_Lt = libff::multi_exp_with_mixed_addition<libff::G1<ppT>,
-                                                                        libff::Fr<ppT>,
-                                                                        libff::multi_exp_method_BDLO12>(
+    const std::vector<libff::G1<ppT> > evaluation_Lt = multi_exp_pippenger_batch<libff::G1<ppT>, libff::Fr<ppT> >(
         pk.L_query.begin(),
         pk.L_query.end(),
-        const_padded_assignment.begin() + qap_wit.num_inputs() + 1,
-        const_padded_assignment.begin() + qap_wit.num_variables() + 1,
+        L_scalars,
         chunks);
     libff::leave_block("Compute evaluation to L-query", false);
 
-    /* A = alpha + sum_i(a_i*A_i(t)) + r*delta */
-    libff::G1<ppT> g1_A = pk.alpha_g1 + evaluation_At + r * pk.delta_g1;
-
-    /* B = beta + sum_i(a_i*B_i(t)) + s*delta */
-    libff::G1<ppT> g1_B = pk.beta_g1 + evaluation_Bt.h + s * pk.delta_g1;
-    libff::G2<ppT> g2_B = pk.beta_g2 + evaluation_Bt.g + s * pk.delta_g2;
-
-    /* C = sum_i(a_i*((beta*A_i(t) + alpha*B_i(t) + C_i(t)) + H(t)*Z(t))/delta) + A*s + r*b - r*s*delta */
-    libff::G1<ppT> g1_C = evaluation_Ht + evaluation_Lt + s *  g1_A + r * g1_B - (r * s) * pk.delta_g1;
+    std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > proofs;
+    proofs.reserve(batch_size);
+    for (size_t k = 0; k < batch_size; ++k)
+    {
+        proofs.emplace_back(r1cs_gg_ppzksnark_zok_prover_finish<ppT>(pk, evaluation_At[k], evaluation_Bt[k], evaluation_Ht[k], evaluation_Lt[k]));
+    }
 
-    libff::leave_block("Compute the proof");
+    libff::leave_block("Compute the proofs");
 
-    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_prover");
+    const double elapsed = (libff::get_nsec_time() - batch_start) * 1e-9;
+    if (!libff::inhibit_profiling_info && batch_size > 0)
+    {
+        libff::print_indent(); printf("* Batch of %zu proofs: %.4fs total, %.4fs per proof, %.2f proofs/s\n",
+                                      batch_size, elapsed, elapsed / batch_size, batch_size / elapsed);
+    }
 
-    r1cs_gg_ppzksnark_zok_proof<ppT> proof = r1cs_gg_ppzksnark_zok_proof<ppT>(std::move(g1_A), std::move(g2_B), std::move(g1_C));
-    proof.print_size();
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_prover_batch");
 
-    return proof;
+    return proofs;
 }
 
 template <typename ppT>
-r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> r1cs_gg_ppzksnark_zok_verifier_process_vk(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &vk)
+r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> r1cs_gg_ppzksnark_zok_verifier_process_vk(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &vk,
+                                                                                              const bool with_input_table)
 {
     libff::enter_block("Call to r1cs_gg_ppzksnark_zok_verifier_process_vk");
 
     r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> pvk;
     pvk.vk_alpha_g1 = vk.alpha_g1;
     pvk.vk_beta_g2 = vk.beta_g2;
+    pvk.vk_alpha_g1_beta_g2 = ppT::reduced_pairing(vk.alpha_g1, vk.beta_g2);
     pvk.vk_gamma_g2_precomp = ppT::precompute_G2(vk.gamma_g2);
     pvk.vk_delta_g2_precomp = ppT::precompute_G2(vk.delta_g2);
     pvk.gamma_ABC_g1 = vk.gamma_ABC_g1;
 
+    /* only for dense gamma_ABC_g1, which is how the generator and the JSON
+       import build it */
+    const sparse_vector<libff::G1<ppT> > &rest = vk.gamma_ABC_g1.rest;
+    if (with_input_table && rest.domain_size() >= r1cs_gg_ppzksnark_zok_input_table_threshold && rest.values.size() == rest.domain_size())
+    {
+        pvk.gamma_ABC_table = fixed_base_table_build<libff::G1<ppT>, libff::Fr<ppT> >(rest.values.begin(), rest.values.end(), 0);
+    }
+
     libff::leave_block("Call to r1cs_gg_ppzksnark_zok_verifier_process_vk");
 
     return pvk;
 }
 
+/**
+ * gamma_ABC_g1[0] + sum_j x_j * gamma_ABC_g1[j+1] for an input no longer than
+ * the key's: through the key's table when it has one, otherwise with a
+ * Pippenger multi-exponentiation from r1cs_gg_ppzksnark_zok_input_table_threshold
+ * inputs, and below that one scalar multiplication per input.
+ */
+template<typename ppT>
+libff::G1<ppT> r1cs_gg_ppzksnark_zok_accumulate_input(const r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> &pvk,
+                                                      const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input)
+{
+    const fixed_base_table<libff::G1<ppT> > &table = pvk.gamma_ABC_table;
+    const sparse_vector<libff::G1<ppT> > &rest = pvk.gamma_ABC_g1.rest;
+    if (table.num_bases() == 0 || primary_input.size() > table.num_bases())
+    {
+        if (primary_input.size() < r1cs_gg_ppzksnark_zok_input_table_threshold
+         || rest.values.size() != rest.domain_size() || primary_input.size() > rest.domain_size())
+        {
+            return pvk.gamma_ABC_g1.template accumulate_chunk<libff::Fr<ppT> >(primary_input.begin(), primary_input.end(), 0).first;
+        }
+
+        /* the bucket method adds the bases with mixed addition */
+        std::vector<libff::G1<ppT> > bases(rest.values.begin(), rest.values.begin() + primary_input.size());
+#ifdef USE_MIXED_ADDITION
+        libff::batch_to_special<libff::G1<ppT> >(bases);
+#endif
+        return pvk.gamma_ABC_g1.first + multi_exp_pippenger<libff::G1<ppT>, libff::Fr<ppT> >(bases.begin(), bases.end(), primary_input.begin(), primary_input.end(), parallel_num_threads());
+    }
+
+    if (primary_input.size() < table.num_bases())
+    {
+        r1cs_gg_ppzksnark_zok_primary_input<ppT> padded_input(primary_input);
+        padded_input.resize(table.num_bases(), libff::Fr<ppT>::zero());
+        return pvk.gamma_ABC_g1.first + fixed_base_multi_exp<libff::G1<ppT>, libff::Fr<ppT> >(table, padded_input.begin(), padded_input.end(), parallel_num_threads());
+    }
+
+    return pvk.gamma_ABC_g1.first + fixed_base_multi_exp<libff::G1<ppT>, libff::Fr<ppT> >(table, primary_input.begin(), primary_input.end(), parallel_num_threads());
+}
+
 template <typename ppT>
 bool r1cs_gg_ppzksnark_zok_online_verifier_weak_IC(const r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> &pvk,
                                                const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
@@ -539,8 +1220,7 @@ bool r1cs_gg_ppzksnark_zok_online_verifier_weak_IC(const r1cs_gg_ppzksnark_zok_p
     assert(pvk.gamma_ABC_g1.domain_size() >= primary_input.size());
 
     libff::enter_block("Accumulate input");
-    const accumulation_vector<libff::G1<ppT> > accumulated_IC = pvk.gamma_ABC_g1.template accumulate_chunk<libff::Fr<ppT> >(primary_input.begin(), primary_input.end(), 0);
-    const libff::G1<ppT> &acc = accumulated_IC.first;
+    const libff::G1<ppT> acc = r1cs_gg_ppzksnark_zok_accumulate_input(pvk, primary_input);
     libff::leave_block("Accumulate input");
 
     bool result = true;
@@ -569,9 +1249,7 @@ bool r1cs_gg_ppzksnark_zok_online_verifier_weak_IC(const r1cs_gg_ppzksnark_zok_p
         proof_g_C_precomp, pvk.vk_delta_g2_precomp);
     const libff::GT<ppT> QAP = ppT::final_exponentiation(QAP1 * QAP2.unitary_inverse());
 
-    libff::GT<ppT> vk_alpha_g1_beta_g2 = ppT::reduced_pairing(pvk.vk_alpha_g1, pvk.vk_beta_g2);
-
-    if (QAP != vk_alpha_g1_beta_g2)
+    if (QAP != pvk.vk_alpha_g1_beta_g2)
     {
         if (!libff::inhibit_profiling_info)
         {
@@ -593,7 +1271,7 @@ bool r1cs_gg_ppzksnark_zok_verifier_weak_IC(const r1cs_gg_ppzksnark_zok_verifica
                                         const r1cs_gg_ppzksnark_zok_proof<ppT> &proof)
 {
     libff::enter_block("Call to r1cs_gg_ppzksnark_zok_verifier_weak_IC");
-    r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> pvk = r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(vk);
+    r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> pvk = r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(vk, false);
     bool result = r1cs_gg_ppzksnark_zok_online_verifier_weak_IC<ppT>(pvk, primary_input, proof);
     libff::leave_block("Call to r1cs_gg_ppzksnark_zok_verifier_weak_IC");
     return result;
@@ -627,12 +1305,127 @@ bool r1cs_gg_ppzksnark_zok_verifier_strong_IC(const r1cs_gg_ppzksnark_zok_verifi
                                           const r1cs_gg_ppzksnark_zok_proof<ppT> &proof)
 {
     libff::enter_block("Call to r1cs_gg_ppzksnark_zok_verifier_strong_IC");
-    r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> pvk = r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(vk);
+    r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> pvk = r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(vk, false);
     bool result = r1cs_gg_ppzksnark_zok_online_verifier_strong_IC<ppT>(pvk, primary_input, proof);
     libff::leave_block("Call to r1cs_gg_ppzksnark_zok_verifier_strong_IC");
     return result;
 }
 
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC(const r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> &pvk,
+                                                       const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                       const std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > &proofs)
+{
+    const size_t batch_size = proofs.size();
+    if (primary_inputs.size() != batch_size)
+    {
+        libff::print_indent(); printf("Number of inputs differs from number of proofs (got %zu, expected %zu).\n", primary_inputs.size(), batch_size);
+        return false;
+    }
+    if (batch_size == 0)
+    {
+        return true;
+    }
+
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC");
+
+    const size_t num_inputs = pvk.gamma_ABC_g1.domain_size();
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+        if (primary_inputs[i].size() != num_inputs)
+        {
+            libff::print_indent(); printf("Input length of proof %zu differs from expected (got %zu, expected %zu).\n", i, primary_inputs[i].size(), num_inputs);
+            libff::leave_block("Call to r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC");
+            return false;
+        }
+        if (!proofs[i].is_well_formed())
+        {
+            if (!libff::inhibit_profiling_info)
+            {
+                libff::print_indent(); printf("At least one of the elements of proof %zu does not lie on the curve.\n", i);
+            }
+            libff::leave_block("Call to r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC");
+            return false;
+        }
+    }
+
+    libff::enter_block("Combine inputs and C");
+    std::vector<libff::Fr<ppT> > r;
+    r.reserve(batch_size);
+    libff::Fr<ppT> r_sum = libff::Fr<ppT>::zero();
+    std::vector<libff::Fr<ppT> > combined_input(num_inputs, libff::Fr<ppT>::zero());
+    std::vector<libff::G1<ppT> > C(batch_size);
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+        r.emplace_back(libff::Fr<ppT>::random_element());
+        r_sum += r[i];
+        for (size_t j = 0; j < num_inputs; ++j)
+        {
+            combined_input[j] += r[i] * primary_inputs[i][j];
+        }
+        C[i] = proofs[i].g_C;
+    }
+#ifdef USE_MIXED_ADDITION
+    /* the buckets add the bases with mixed addition */
+    libff::batch_to_special<libff::G1<ppT> >(C);
+#endif
+
+    /* sum r_i * (gamma_ABC_0 + sum_j x_ij * gamma_ABC_j) */
+    const libff::G1<ppT> acc = r1cs_gg_ppzksnark_zok_accumulate_input(pvk, combined_input)
+                             + (r_sum - libff::Fr<ppT>::one()) * pvk.gamma_ABC_g1.first;
+    const libff::G1<ppT> C_sum = multi_exp_pippenger<libff::G1<ppT>, libff::Fr<ppT> >(C.begin(), C.end(), r.begin(), r.end(), parallel_num_threads());
+    libff::leave_block("Combine inputs and C");
+
+    libff::enter_block("Online pairing computations");
+    /* libff's profiler is not thread-safe and the pairing code opens blocks,
+       so the Miller loops only run in parallel when the caller has inhibited
+       them */
+    const size_t grain = (libff::inhibit_profiling_counters ? r1cs_gg_ppzksnark_zok_verifier_batch_grain : batch_size);
+    const size_t num_ranges = (batch_size + grain - 1) / grain;
+    std::vector<libff::Fqk<ppT> > range_products(num_ranges, libff::Fqk<ppT>::one());
+    parallel_for_ranges(batch_size, grain, [&](const size_t begin, const size_t end) {
+        libff::Fqk<ppT> &product = range_products[begin / grain];
+        for (size_t i = begin; i < end; ++i)
+        {
+            const libff::G1<ppT> r_A = glv_scalar_mul<libff::G1<ppT>, libff::Fr<ppT> >(r[i], proofs[i].g_A);
+            product = product * ppT::miller_loop(ppT::precompute_G1(r_A), ppT::precompute_G2(proofs[i].g_B));
+        }
+    });
+
+    libff::Fqk<ppT> AB = libff::Fqk<ppT>::one();
+    for (const libff::Fqk<ppT> &product : range_products)
+    {
+        AB = AB * product;
+    }
+    const libff::Fqk<ppT> acc_C = ppT::double_miller_loop(
+        ppT::precompute_G1(acc), pvk.vk_gamma_g2_precomp,
+        ppT::precompute_G1(C_sum), pvk.vk_delta_g2_precomp);
+    const libff::GT<ppT> QAP = ppT::final_exponentiation(AB * acc_C.unitary_inverse());
+
+    const bool result = (QAP == (pvk.vk_alpha_g1_beta_g2 ^ r_sum.as_bigint()));
+    if (!result && !libff::inhibit_profiling_info)
+    {
+        libff::print_indent(); printf("Batched QAP divisibility check failed.\n");
+    }
+    libff::leave_block("Online pairing computations");
+
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC");
+
+    return result;
+}
+
+template<typename ppT>
+bool r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &vk,
+                                                const std::vector<r1cs_gg_ppzksnark_zok_primary_input<ppT> > &primary_inputs,
+                                                const std::vector<r1cs_gg_ppzksnark_zok_proof<ppT> > &proofs)
+{
+    libff::enter_block("Call to r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC");
+    r1cs_gg_ppzksnark_zok_processed_verification_key<ppT> pvk = r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(vk, false);
+    bool result = r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC<ppT>(pvk, primary_inputs, proofs);
+    libff::leave_block("Call to r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC");
+    return result;
+}
+
 template<typename ppT>
 bool r1cs_gg_ppzksnark_zok_affine_verifier_weak_IC(const r1cs_gg_ppzksnark_zok_verification_key<ppT> &vk,
                                                const r1cs_gg_ppzksnark_zok_primary_input<ppT> &primary_input,
@@ -0,0 +1,119 @@
+/** @file
+ *****************************************************************************
+
+ Writable array backed by a temporary file, for intermediate results that
+ may not fit in memory.
+
+ The file is unlinked as soon as it is created and mapped shared, so the
+ kernel can write dirty pages back to it and evict them under memory
+ pressure instead of failing the allocation. Elements start out as all-zero
+ bytes, which is zero for field elements in Montgomery form.
+
+ On Windows and Emscripten the array is an ordinary heap allocation.
+
+ *****************************************************************************
+ * @author     This file is part of ethsnarks, derived from libff/libsnark.
+ * @copyright  MIT license (see LICENSE file)
+ *****************************************************************************/
+
+#ifndef SCRATCH_ARRAY_HPP_
+#define SCRATCH_ARRAY_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__)
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace libsnark {
+
+template<typename T>
+class scratch_array {
+public:
+    scratch_array() : data_(nullptr), size_(0) {};
+
+    scratch_array(const scratch_array<T> &other) = delete;
+    scratch_array<T>& operator=(const scratch_array<T> &other) = delete;
+
+    ~scratch_array()
+    {
+        release();
+    }
+
+    /**
+     * Allocate `count` zeroed elements in a file in `directory`, returns
+     * false if the file cannot be created or mapped.
+     */
+    bool allocate(const std::string &directory, const size_t count)
+    {
+        release();
+
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+        (void)directory;
+        buffer_.assign(count, T::zero());
+        data_ = buffer_.data();
+#else
+        std::string path = directory + "/ethsnarks-scratch-XXXXXX";
+        const int fd = ::mkstemp(&path[0]);
+        if (fd < 0)
+        {
+            return false;
+        }
+        ::unlink(path.c_str());
+
+        const size_t bytes = count * sizeof(T);
+        void *addr = MAP_FAILED;
+        if (bytes == 0 || ::ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+        {
+            addr = ::mmap(nullptr, bytes == 0 ? sizeof(T) : bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return false;
+        }
+        data_ = static_cast<T*>(addr);
+#endif
+        size_ = count;
+
+        return true;
+    }
+
+    /**
+     * Unmap the array, which also frees the file.
+     */
+    void release()
+    {
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+        std::vector<T>().swap(buffer_);
+#else
+        if (data_ != nullptr)
+        {
+            ::munmap(data_, size_ == 0 ? sizeof(T) : size_ * sizeof(T));
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+    size_t size() const { return size_; }
+    T &operator[](const size_t i) { return data_[i]; }
+    const T &operator[](const size_t i) const { return data_[i]; }
+
+private:
+    T *data_;
+    size_t size_;
+#if defined(_WIN32) || defined(__EMSCRIPTEN__)
+    std::vector<T> buffer_;
+#endif
+};
+
+} // libsnark
+
+#endif // SCRATCH_ARRAY_HPP_
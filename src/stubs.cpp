@@ -3,53 +3,193 @@
 
 #include <libsnark/gadgetlib1/protoboard.hpp>
 
+#include <memory>
+#include <mutex>  // call_once
 #include <sstream>  // stringstream
+#include <cstdio>  // remove
 
 #include "utils.hpp"
 #include "import.hpp"
 #include "export.hpp"
+#include "wire_format.hpp"
 
 #include "r1cs_gg_ppzksnark_zok/r1cs_gg_ppzksnark_zok.hpp"
+#include "r1cs_gg_ppzksnark_zok/flat_proving_key.hpp"
 
 namespace ethsnarks {
 
+void stub_init_public_params()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, []{ ppT::init_public_params(); });
+}
+
+
+ProcessedVerificationKeyT *stub_vk_load( const char *vk_json, bool with_input_table )
+{
+    stub_init_public_params();
+
+    try {
+        std::stringstream vk_stream;
+        vk_stream << vk_json;
+        const auto vk = vk_from_json(vk_stream);
+
+        return new ProcessedVerificationKeyT(libsnark::r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(vk, with_input_table));
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot load verifying key: " << ex.what() << std::endl;
+        return nullptr;
+    }
+}
+
+
+bool stub_verify_with( const ProcessedVerificationKeyT &pvk, const char *proof_json )
+{
+    try {
+        std::stringstream proof_stream;
+        proof_stream << proof_json;
+        auto proof_pair = proof_from_json(proof_stream);
+
+        return libsnark::r1cs_gg_ppzksnark_zok_online_verifier_strong_IC<ppT>(pvk, proof_pair.first, proof_pair.second);
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot load proof: " << ex.what() << std::endl;
+        return false;
+    }
+}
+
+
+bool stub_verify_batch_with( const ProcessedVerificationKeyT &pvk, const char **proofs_json, size_t n_proofs )
+{
+    std::vector<PrimaryInputT> primary_inputs;
+    std::vector<ProofT> proofs;
+    primary_inputs.reserve(n_proofs);
+    proofs.reserve(n_proofs);
+
+    try {
+        for( size_t i = 0; i < n_proofs; i++ )
+        {
+            std::stringstream proof_stream;
+            proof_stream << proofs_json[i];
+            auto proof_pair = proof_from_json(proof_stream);
+            primary_inputs.emplace_back(std::move(proof_pair.first));
+            proofs.emplace_back(std::move(proof_pair.second));
+        }
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot load proof: " << ex.what() << std::endl;
+        return false;
+    }
+
+    return libsnark::r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC<ppT>(pvk, primary_inputs, proofs);
+}
+
+
+ProcessedVerificationKeyT *stub_vk_load_wire( const uint8_t *vk_data, size_t vk_size, bool with_input_table )
+{
+    stub_init_public_params();
+
+    VerificationKeyT vk;
+    if( ! vk_from_wire(vk_data, vk_size, vk) ) {
+        std::cerr << "Error: cannot load verifying key: invalid encoding" << std::endl;
+        return nullptr;
+    }
+
+    return new ProcessedVerificationKeyT(libsnark::r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(vk, with_input_table));
+}
+
+
+bool stub_verify_wire_with( const ProcessedVerificationKeyT &pvk, const uint8_t *proof_data, size_t proof_size )
+{
+    InputProofPairType proof_pair;
+    if( ! proof_from_wire(proof_data, proof_size, proof_pair) ) {
+        std::cerr << "Error: cannot load proof: invalid encoding" << std::endl;
+        return false;
+    }
+
+    return libsnark::r1cs_gg_ppzksnark_zok_online_verifier_strong_IC<ppT>(pvk, proof_pair.first, proof_pair.second);
+}
+
+
 bool stub_verify( const char *vk_json, const char *proof_json )
 {
-    ppT::init_public_params();
+    std::unique_ptr<ProcessedVerificationKeyT> pvk(stub_vk_load(vk_json, false));
 
-    std::stringstream vk_stream;
-    vk_stream << vk_json;
-    auto vk = vk_from_json(vk_stream);
+    return pvk && stub_verify_with(*pvk, proof_json);
+}
 
-    std::stringstream proof_stream;
-    proof_stream << proof_json;
-    auto proof_pair = proof_from_json(proof_stream);
 
-    auto status = libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC <ppT> (vk, proof_pair.first, proof_pair.second);
-    if( status )
-        return true;
+bool stub_verify_batch( const char *vk_json, const char **proofs_json, size_t n_proofs )
+{
+    std::unique_ptr<ProcessedVerificationKeyT> pvk(stub_vk_load(vk_json, false));
+
+    return pvk && stub_verify_batch_with(*pvk, proofs_json, n_proofs);
+}
+
 
-    return false;
+std::string stub_expanded_pk_path( const char *pk_file )
+{
+    return std::string(pk_file) + ".expanded";
+}
+
+
+template<typename ProvingKeyT>
+static std::string stub_prove_with_key( ProtoboardT& pb, const ProvingKeyT &proving_key )
+{
+    const auto primary_input = pb.primary_input();
+    const libsnark::r1cs_gg_ppzksnark_zok_prover_options options;
+
+    auto proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ethsnarks::ppT>(proving_key, primary_input, pb.auxiliary_input(), options);
+    return ethsnarks::proof_to_json(proof, primary_input);
 }
 
 
 std::string stub_prove_from_pb( ProtoboardT& pb, const char *pk_file )
 {
+    if( libsnark::r1cs_gg_ppzksnark_zok_is_flat_proving_key(pk_file) )
+    {
+        libsnark::r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> proving_key;
+        if( ! proving_key.open(pk_file) ) {
+            return std::string();
+        }
+
+        return stub_prove_with_key(pb, proving_key);
+    }
+
     auto proving_key = ethsnarks::loadFromFile<ethsnarks::ProvingKeyT>(pk_file);
     // TODO: verify if proving key was loaded correctly, if not return NULL
 
-    auto primary_input = pb.primary_input();
-    auto proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ethsnarks::ppT>(proving_key, primary_input, pb.auxiliary_input());
-    return ethsnarks::proof_to_json(proof, primary_input);
+    return stub_prove_with_key(pb, proving_key);
 }
 
 
-int stub_genkeys_from_pb( ProtoboardT& pb, const char *pk_file, const char *vk_file )
+int stub_genkeys_from_pb( ProtoboardT& pb, const char *pk_file, const char *vk_file, int flags )
 {
     const auto constraints = pb.get_constraint_system();
     auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(constraints);
     vk2json_file(keypair.vk, vk_file);
-    writeToFile<decltype(keypair.pk)>(pk_file, keypair.pk);
+
+    if( flags & (STUB_GENKEYS_FLAT | STUB_GENKEYS_COMPRESSED) )
+    {
+        if( ! libsnark::r1cs_gg_ppzksnark_zok_write_flat_proving_key<ppT>(keypair.pk, pk_file, (flags & STUB_GENKEYS_COMPRESSED) != 0) )
+        {
+            std::cerr << "Error: cannot write " << pk_file << std::endl;
+            return 1;
+        }
+    }
+    else {
+        writeToFile<decltype(keypair.pk)>(pk_file, keypair.pk);
+    }
+
+    if( flags & STUB_GENKEYS_EXPANDED )
+    {
+        auto expanded_pk = libsnark::r1cs_gg_ppzksnark_zok_expand_proving_key<ppT>(keypair.pk);
+        writeToFile<decltype(expanded_pk)>(stub_expanded_pk_path(pk_file), expanded_pk);
+    }
+    else {
+        // tables of a previous key would be picked up with this one
+        ::remove(stub_expanded_pk_path(pk_file).c_str());
+    }
 
     return 0;
 }
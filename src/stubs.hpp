@@ -6,27 +6,82 @@
 
 namespace ethsnarks {
 
+/**
+* Initialise the curve parameters, only the first call does so; safe to call
+* from any thread. libff's init_public_params rewrites globals each time it
+* runs, which races with threads already using them.
+*/
+void stub_init_public_params();
+
 bool stub_verify( const char *vk_json, const char *proof_json );
 
+/**
+* Verifies `n_proofs` proofs made with the same key at once, true only if all are valid
+*/
+bool stub_verify_batch( const char *vk_json, const char **proofs_json, size_t n_proofs );
+
+/**
+* Parses and processes a verifying key once, for stub_verify_with, which
+* then skips the G2 precomputations and the e(alpha, beta) pairing.
+* Returns nullptr if the JSON is invalid, the key is freed with delete.
+* Keys used only once should skip `with_input_table`, the table of gamma_ABC
+* costs about one input accumulation to build.
+*/
+ProcessedVerificationKeyT *stub_vk_load( const char *vk_json, bool with_input_table = true );
+
+bool stub_verify_with( const ProcessedVerificationKeyT &pvk, const char *proof_json );
+
+bool stub_verify_batch_with( const ProcessedVerificationKeyT &pvk, const char **proofs_json, size_t n_proofs );
+
+/**
+* As stub_vk_load and stub_verify_with, for keys and proofs in the binary
+* encoding of wire_format.hpp
+*/
+ProcessedVerificationKeyT *stub_vk_load_wire( const uint8_t *vk_data, size_t vk_size, bool with_input_table = true );
+
+bool stub_verify_wire_with( const ProcessedVerificationKeyT &pvk, const uint8_t *proof_data, size_t proof_size );
+
 int stub_main_verify( const char *prog_name, int argc, const char **argv );
 
 bool stub_test_proof_verify( const ProtoboardT &in_pb );
 
-int stub_genkeys_from_pb( ProtoboardT& pb, const char *pk_file, const char *vk_file );
-
+/**
+* Path of the expanded proving key (fixed-base tables) stored next to `pk_file`
+*/
+std::string stub_expanded_pk_path( const char *pk_file );
+
+enum stub_genkeys_flags {
+    /* Also write the fixed-base tables of the proving key to stub_expanded_pk_path(pk_file), used by prover_service */
+    STUB_GENKEYS_EXPANDED = 1,
+    /* Write the proving key in the flat format, which is memory-mapped when proving */
+    STUB_GENKEYS_FLAT = 2,
+    /* Compress the points of the flat format, implies STUB_GENKEYS_FLAT */
+    STUB_GENKEYS_COMPRESSED = 4
+};
+
+/**
+* Writes the proving key and verification key, `flags` is a combination of stub_genkeys_flags
+*/
+int stub_genkeys_from_pb( ProtoboardT& pb, const char *pk_file, const char *vk_file, int flags = 0 );
+
+/**
+* Proves with the proving key in `pk_file`, either format is detected from the file.
+* The expanded tables aren't loaded, parsing them costs more than they save
+* on a single proof, they are for prover_service which keeps them resident.
+*/
 std::string stub_prove_from_pb( ProtoboardT& pb, const char *pk_file );
 
 
 template<class GadgetT>
-int stub_genkeys( const char *pk_file, const char *vk_file )
+int stub_genkeys( const char *pk_file, const char *vk_file, int flags = 0 )
 {
-    ppT::init_public_params();
+    stub_init_public_params();
 
     ProtoboardT pb;
     GadgetT mod(pb, "module");
     mod.generate_r1cs_constraints();
 
-    return stub_genkeys_from_pb(pb, pk_file, vk_file);
+    return stub_genkeys_from_pb(pb, pk_file, vk_file, flags);
 }
 
 
@@ -35,14 +90,33 @@ int stub_main_genkeys( const char *prog_name, int argc, char **argv )
 {
     if( argc < 3 )
     {
-        std::cerr << "Usage: " << prog_name << " " << argv[0] << " <pk-output.raw> <vk-output.json>" << std::endl;
+        std::cerr << "Usage: " << prog_name << " " << argv[0] << " <pk-output.raw> <vk-output.json> [--expanded] [--flat] [--compressed]" << std::endl;
         return 1;
     }
 
     auto pk_file = argv[1];
     auto vk_file = argv[2];
 
-    if( 0 != stub_genkeys<GadgetT>( pk_file, vk_file ) )
+    int flags = 0;
+    for( int i = 3; i < argc; i++ )
+    {
+        const std::string arg(argv[i]);
+        if( arg == "--expanded" ) {
+            flags |= STUB_GENKEYS_EXPANDED;
+        }
+        else if( arg == "--flat" ) {
+            flags |= STUB_GENKEYS_FLAT;
+        }
+        else if( arg == "--compressed" ) {
+            flags |= STUB_GENKEYS_FLAT | STUB_GENKEYS_COMPRESSED;
+        }
+        else {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if( 0 != stub_genkeys<GadgetT>( pk_file, vk_file, flags ) )
     {
         std::cerr << "Error: failed to generate proving and verifying keys" << std::endl;
         return 1;
@@ -0,0 +1,117 @@
+#include <cstdlib>
+
+#include <libff/common/profiling.hpp>
+#include <libsnark/knowledge_commitment/kc_multiexp.hpp>
+
+#include "ethsnarks.hpp"
+#include "r1cs_gg_ppzksnark_zok/multiexp_pippenger.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+using ethsnarks::G1T;
+using ethsnarks::G2T;
+
+typedef libsnark::knowledge_commitment<G2T, G1T> KcT;
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+
+/**
+* Bases derived by repeated addition, see benchmark_multiexp
+*/
+template<typename T>
+static std::vector<T> make_bases( size_t n )
+{
+    std::vector<T> bases;
+    bases.reserve(n);
+
+    const T step = T::random_element();
+    T current = T::random_element();
+    for( size_t i = 0; i < n; i++ )
+    {
+        bases.emplace_back(current);
+        current = current + step;
+    }
+
+#ifdef USE_MIXED_ADDITION
+    libff::batch_to_special<T>(bases);
+#endif
+
+    return bases;
+}
+
+
+/**
+* Compare libsnark's kc_multi_exp_with_mixed_addition, as used for the B query,
+* against the Pippenger engine with Jacobian and with batch-affine buckets,
+* for queries of 2^min_log .. 2^max_log terms
+*
+* Usage: benchmark_kc_multiexp [min_log] [max_log]
+*/
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const size_t min_log = argc > 1 ? ::atoi(argv[1]) : 12;
+    const size_t max_log = argc > 2 ? ::atoi(argv[2]) : 20;
+
+#ifdef MULTICORE
+    const size_t chunks = omp_get_max_threads();
+#else
+    const size_t chunks = 1;
+#endif
+
+    const size_t max_n = 1ul << max_log;
+    const auto g = make_bases<G2T>(max_n);
+    const auto h = make_bases<G1T>(max_n);
+    std::vector<FieldT> scalars;
+    scalars.reserve(max_n);
+    for( size_t i = 0; i < max_n; i++ )
+    {
+        scalars.emplace_back(FieldT::random_element());
+    }
+
+    ::printf("log2(n),threads,kc_multi_exp (ms),pippenger (ms),batch affine (ms),speedup\n");
+
+    for( size_t log_n = min_log; log_n <= max_log; log_n++ )
+    {
+        const size_t n = 1ul << log_n;
+
+        std::vector<KcT> values;
+        values.reserve(n);
+        for( size_t i = 0; i < n; i++ )
+        {
+            values.emplace_back(g[i], h[i]);
+        }
+        const libsnark::knowledge_commitment_vector<G2T, G1T> vec(std::move(values));
+
+        const long long kc_start = libff::get_nsec_time();
+        const KcT kc = libsnark::kc_multi_exp_with_mixed_addition<G2T, G1T, FieldT, libff::multi_exp_method_BDLO12>(
+            vec, 0, n, scalars.begin(), scalars.begin() + n, chunks);
+        const long long kc_ns = libff::get_nsec_time() - kc_start;
+
+        const long long pippenger_start = libff::get_nsec_time();
+        const KcT pippenger = libsnark::kc_multi_exp_pippenger_with_mixed_addition<G2T, G1T, FieldT>(
+            vec, 0, n, scalars.begin(), scalars.begin() + n, chunks);
+        const long long pippenger_ns = libff::get_nsec_time() - pippenger_start;
+
+        const long long affine_start = libff::get_nsec_time();
+        const KcT affine = libsnark::kc_multi_exp_pippenger_with_mixed_addition<G2T, G1T, FieldT>(
+            vec, 0, n, scalars.begin(), scalars.begin() + n, chunks, true);
+        const long long affine_ns = libff::get_nsec_time() - affine_start;
+
+        if( kc != pippenger || kc != affine )
+        {
+            std::cerr << "Error: results differ for n=" << n << std::endl;
+            return 1;
+        }
+
+        ::printf("%zu,%zu,%.1f,%.1f,%.1f,%.2f\n", log_n, chunks,
+                 kc_ns / 1e6, pippenger_ns / 1e6, affine_ns / 1e6, double(kc_ns) / double(affine_ns));
+    }
+
+    return 0;
+}
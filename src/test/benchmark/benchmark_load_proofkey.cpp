@@ -1,5 +1,6 @@
 #include "utils.hpp"
 #include "ethsnarks.hpp"
+#include "r1cs_gg_ppzksnark_zok/flat_proving_key.hpp"
 
 using ethsnarks::ppT;
 using ethsnarks::ProvingKeyT;
@@ -11,13 +12,42 @@ int main( int argc, char **argv )
 	ppT::init_public_params();
 
 	if( argc < 2 ) {
-		std::cerr << "Usage: " << argv[0] << " <proofkey.raw>\n";
+		std::cerr << "Usage: " << argv[0] << " <proofkey.raw> [proofkey.flat [--compressed]]\n";
+		std::cerr << "Optionally converts the proving key to the flat format\n";
 		return 1;
 	}
 
-	ProvingKeyT pk = loadFromFile<ProvingKeyT>(argv[1]);
+	const long long load_start = libff::get_nsec_time();
+
+	if( libsnark::r1cs_gg_ppzksnark_zok_is_flat_proving_key(argv[1]) )
+	{
+		libsnark::flat_proving_key_info info;
+		if( ! libsnark::r1cs_gg_ppzksnark_zok_read_flat_proving_key_info(argv[1], info) ) {
+			return 2;
+		}
+		std::cout << info.metadata.num_constraints << " constraints, "
+		          << info.metadata.primary_input_size << " inputs, "
+		          << info.metadata.auxiliary_input_size << " auxiliary variables"
+		          << (info.metadata.compressed ? ", compressed" : "") << "\n";
+
+		libsnark::r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> pk;
+		if( ! pk.open(argv[1]) ) {
+			return 2;
+		}
+		std::cout << "Mapped flat proving key in " << ((libff::get_nsec_time() - load_start) / 1e6) << " ms\n";
+	}
+	else {
+		ProvingKeyT pk = loadFromFile<ProvingKeyT>(argv[1]);
+		std::cout << "Loaded proving key in " << ((libff::get_nsec_time() - load_start) / 1e6) << " ms\n";
+
+		const bool compressed = argc > 3 && std::string(argv[3]) == "--compressed";
+		if( argc > 2 && ! libsnark::r1cs_gg_ppzksnark_zok_write_flat_proving_key<ppT>(pk, argv[2], compressed) ) {
+			std::cerr << "Error: cannot write " << argv[2] << "\n";
+			return 2;
+		}
+	}
 
     std::cout << "OK\n";
 
 	return 0;
-}
\ No newline at end of file
+}
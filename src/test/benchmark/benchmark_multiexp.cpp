@@ -0,0 +1,97 @@
+#include <cstdlib>
+
+#include <libff/algebra/scalar_multiplication/multiexp.hpp>
+#include <libff/common/profiling.hpp>
+
+#include "ethsnarks.hpp"
+#include "r1cs_gg_ppzksnark_zok/multiexp_pippenger.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+using ethsnarks::G1T;
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+
+/**
+* Bases for a query of size n, derived by repeated addition as
+* random_element() for every base would dominate the benchmark
+*/
+static std::vector<G1T> make_bases( size_t n )
+{
+    std::vector<G1T> bases;
+    bases.reserve(n);
+
+    const G1T step = G1T::random_element();
+    G1T current = G1T::random_element();
+    for( size_t i = 0; i < n; i++ )
+    {
+        bases.emplace_back(current);
+        current = current + step;
+    }
+
+#ifdef USE_MIXED_ADDITION
+    libff::batch_to_special<G1T>(bases);
+#endif
+
+    return bases;
+}
+
+
+/**
+* Compare libff BDLO12 against the Pippenger engine for queries of 2^min_log .. 2^max_log terms
+*
+* Usage: benchmark_multiexp [min_log] [max_log]
+*/
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const size_t min_log = argc > 1 ? ::atoi(argv[1]) : 14;
+    const size_t max_log = argc > 2 ? ::atoi(argv[2]) : 22;
+
+#ifdef MULTICORE
+    const size_t chunks = omp_get_max_threads();
+#else
+    const size_t chunks = 1;
+#endif
+
+    const auto bases = make_bases(1ul << max_log);
+    std::vector<FieldT> scalars;
+    scalars.reserve(bases.size());
+    for( size_t i = 0; i < bases.size(); i++ )
+    {
+        scalars.emplace_back(FieldT::random_element());
+    }
+
+    ::printf("log2(n),threads,window,BDLO12 (ms),pippenger (ms),speedup\n");
+
+    for( size_t log_n = min_log; log_n <= max_log; log_n++ )
+    {
+        const size_t n = 1ul << log_n;
+
+        const long long bdlo12_start = libff::get_nsec_time();
+        const G1T bdlo12 = libff::multi_exp<G1T, FieldT, libff::multi_exp_method_BDLO12>(
+            bases.begin(), bases.begin() + n, scalars.begin(), scalars.begin() + n, chunks);
+        const long long bdlo12_ns = libff::get_nsec_time() - bdlo12_start;
+
+        const long long pippenger_start = libff::get_nsec_time();
+        const G1T pippenger = libsnark::multi_exp_pippenger<G1T, FieldT>(
+            bases.begin(), bases.begin() + n, scalars.begin(), scalars.begin() + n, chunks);
+        const long long pippenger_ns = libff::get_nsec_time() - pippenger_start;
+
+        if( bdlo12 != pippenger )
+        {
+            std::cerr << "Error: results differ for n=" << n << std::endl;
+            return 1;
+        }
+
+        ::printf("%zu,%zu,%zu,%.1f,%.1f,%.2f\n", log_n, chunks, libsnark::pippenger_window_size(n),
+                 bdlo12_ns / 1e6, pippenger_ns / 1e6, double(bdlo12_ns) / double(pippenger_ns));
+    }
+
+    return 0;
+}
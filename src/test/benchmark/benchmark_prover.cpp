@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+
+#include <libff/common/profiling.hpp>
+#include <libsnark/gadgetlib1/gadgets/hashes/sha256/sha256_components.hpp>
+
+#include "ethsnarks.hpp"
+#include "utils.hpp"
+#include "gadgets/merkle_tree.hpp"
+#include "gadgets/mimc.hpp"
+#include "gadgets/poseidon.hpp"
+#include "gadgets/sha256_full.hpp"
+#include "jubjub/eddsa.hpp"
+#include "r1cs_gg_ppzksnark_zok/memory_usage.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+using ethsnarks::ProtoboardT;
+using ethsnarks::VariableT;
+using ethsnarks::VariableArrayT;
+using ethsnarks::ConstraintT;
+using ethsnarks::make_variable;
+using ethsnarks::make_var_array;
+
+using libsnark::digest_variable;
+using libsnark::block_variable;
+using libsnark::SHA256_digest_size;
+
+
+/* Fixed seed, so every run proves the same witnesses */
+static std::mt19937_64 rng(1);
+
+static libff::bit_vector random_bits( size_t n )
+{
+    libff::bit_vector bits(n);
+    for( size_t i = 0; i < n; i++ )
+    {
+        bits[i] = (rng() & 1) != 0;
+    }
+    return bits;
+}
+
+static FieldT random_field_element()
+{
+    /* 256 bits from rng, reduced modulo the field */
+    const FieldT shift = FieldT(1l << 32).squared();
+    FieldT value = FieldT::zero();
+    for( size_t i = 0; i < 4; i++ )
+    {
+        value = (value * shift) + FieldT(long(rng()), true);
+    }
+    return value;
+}
+
+
+/**
+* A circuit of one family at one size, whose constraints and witness are
+* generated separately so each can be timed.
+*/
+class benchmark_circuit
+{
+public:
+    ProtoboardT pb;
+
+    virtual ~benchmark_circuit() {}
+
+    virtual void generate_r1cs_constraints() = 0;
+
+    virtual void generate_r1cs_witness() = 0;
+};
+
+
+/**
+* Membership proof in a MiMC Merkle tree of the given depth, the root is public
+*/
+class mimc_merkle_circuit : public benchmark_circuit
+{
+public:
+    const VariableT root;
+    VariableArrayT address_bits;
+    VariableArrayT path;
+    const VariableT leaf;
+    ethsnarks::merkle_path_authenticator<ethsnarks::MiMC_e7_hash_gadget> auth;
+
+    mimc_merkle_circuit( size_t depth ) :
+        root(make_variable(pb, "root")),
+        address_bits(make_var_array(pb, depth, "address_bits")),
+        path(make_var_array(pb, depth, "path")),
+        leaf(make_variable(pb, "leaf")),
+        auth(pb, depth, address_bits, ethsnarks::merkle_tree_IVs(pb), leaf, root, path, "auth")
+    {
+        pb.set_input_sizes(1);
+    }
+
+    void generate_r1cs_constraints() override
+    {
+        auth.generate_r1cs_constraints();
+    }
+
+    void generate_r1cs_witness() override
+    {
+        address_bits.fill_with_bits(pb, random_bits(address_bits.size()));
+        for( const auto &var : path )
+        {
+            pb.val(var) = random_field_element();
+        }
+        pb.val(leaf) = random_field_element();
+
+        auth.generate_r1cs_witness();
+        pb.val(root) = pb.val(auth.result());
+    }
+};
+
+
+/**
+* h_i = Poseidon(h_{i-1}, m_i) for i in [0, length), h_length is public
+*/
+class poseidon_chain_circuit : public benchmark_circuit
+{
+public:
+    typedef ethsnarks::Poseidon128<2, 1> HashT;
+
+    const VariableT result;
+    const VariableT seed;
+    const VariableArrayT messages;
+    std::vector<VariableArrayT> inputs;     // the hashers keep references to their inputs
+    std::vector<HashT> hashers;
+
+    poseidon_chain_circuit( size_t length ) :
+        result(make_variable(pb, "result")),
+        seed(make_variable(pb, "seed")),
+        messages(make_var_array(pb, length, "messages"))
+    {
+        pb.set_input_sizes(1);
+
+        inputs.reserve(length);
+        hashers.reserve(length);
+        for( size_t i = 0; i < length; i++ )
+        {
+            inputs.emplace_back();
+            inputs.back().emplace_back(i == 0 ? seed : hashers.back().result());
+            inputs.back().emplace_back(messages[i]);
+            hashers.emplace_back(pb, inputs.back(), FMT("hasher", "[%zu]", i));
+        }
+    }
+
+    void generate_r1cs_constraints() override
+    {
+        for( const auto &hasher : hashers )
+        {
+            hasher.generate_r1cs_constraints();
+        }
+        pb.add_r1cs_constraint(ConstraintT(hashers.back().result(), 1, result), "result");
+    }
+
+    void generate_r1cs_witness() override
+    {
+        pb.val(seed) = random_field_element();
+        for( const auto &var : messages )
+        {
+            pb.val(var) = random_field_element();
+        }
+
+        for( const auto &hasher : hashers )
+        {
+            hasher.generate_r1cs_witness();
+        }
+        pb.val(result) = pb.val(hashers.back().result());
+    }
+};
+
+
+/**
+* d_i = SHA256(d_{i-1} || m_i), one 512 bit block per step
+*/
+class sha256_chain_circuit : public benchmark_circuit
+{
+public:
+    std::vector<digest_variable<FieldT> > digests;
+    std::vector<digest_variable<FieldT> > messages;
+    std::vector<block_variable<FieldT> > blocks;
+    std::vector<ethsnarks::sha256_full_gadget_512> hashers;
+
+    sha256_chain_circuit( size_t num_blocks )
+    {
+        digests.reserve(num_blocks + 1);
+        messages.reserve(num_blocks);
+        blocks.reserve(num_blocks);
+        hashers.reserve(num_blocks);
+
+        digests.emplace_back(pb, SHA256_digest_size, "digest[0]");
+        for( size_t i = 0; i < num_blocks; i++ )
+        {
+            messages.emplace_back(pb, SHA256_digest_size, FMT("message", "[%zu]", i));
+            blocks.emplace_back(pb, digests.back(), messages.back(), FMT("block", "[%zu]", i));
+            digests.emplace_back(pb, SHA256_digest_size, FMT("digest", "[%zu]", i + 1));
+            hashers.emplace_back(pb, blocks.back(), digests.back(), FMT("hasher", "[%zu]", i));
+        }
+    }
+
+    void generate_r1cs_constraints() override
+    {
+        for( auto &hasher : hashers )
+        {
+            hasher.generate_r1cs_constraints();
+        }
+    }
+
+    void generate_r1cs_witness() override
+    {
+        digests.front().generate_r1cs_witness(random_bits(SHA256_digest_size));
+        for( auto &message : messages )
+        {
+            message.generate_r1cs_witness(random_bits(SHA256_digest_size));
+        }
+
+        for( auto &hasher : hashers )
+        {
+            hasher.generate_r1cs_witness();
+        }
+    }
+};
+
+
+/**
+* Verification of `count` HashEdDSA signatures, all of the test vector in
+* test_jubjub_eddsa as signing isn't available natively
+*/
+class eddsa_circuit : public benchmark_circuit
+{
+public:
+    const ethsnarks::jubjub::Params params;
+    std::vector<VariableArrayT> msg_bits;
+    std::vector<VariableArrayT> s_bits;
+    std::vector<ethsnarks::jubjub::EdDSA> verifiers;
+
+    eddsa_circuit( size_t count )
+    {
+        const ethsnarks::jubjub::EdwardsPoint B(params.Gx, params.Gy);
+        const ethsnarks::jubjub::EdwardsPoint A(
+            FieldT("333671881179914989291633188949569309119725676183802886621140166987382124337"),
+            FieldT("4050436616325076046600891135828313078248584449767955905006778857958871314574"));
+        const ethsnarks::jubjub::EdwardsPoint R(
+            FieldT("21473010389772475573783051334263374448039981396476357164143587141689900886674"),
+            FieldT("11330590229113935667895133446882512506792533479705847316689101265088791098646"));
+
+        msg_bits.reserve(count);
+        s_bits.reserve(count);
+        verifiers.reserve(count);
+        for( size_t i = 0; i < count; i++ )
+        {
+            msg_bits.emplace_back(make_var_array(pb, 3 * 8, FMT("msg", "[%zu]", i)));
+            s_bits.emplace_back(make_var_array(pb, FieldT::size_in_bits(), FMT("s", "[%zu]", i)));
+            verifiers.emplace_back(pb, params, B,
+                                   A.as_VariablePointT(pb, FMT("A", "[%zu]", i)),
+                                   R.as_VariablePointT(pb, FMT("R", "[%zu]", i)),
+                                   s_bits.back(), msg_bits.back(),
+                                   FMT("eddsa", "[%zu]", i));
+        }
+    }
+
+    void generate_r1cs_constraints() override
+    {
+        for( auto &verifier : verifiers )
+        {
+            verifier.generate_r1cs_constraints();
+        }
+    }
+
+    void generate_r1cs_witness() override
+    {
+        const char *msg = "abc";
+        const auto msg_bv = ethsnarks::bytes_to_bv((const uint8_t*)msg, strlen(msg));
+        const FieldT s("21807294168737929637405719327036335125520717961882955117047593281820367379946");
+
+        for( size_t i = 0; i < verifiers.size(); i++ )
+        {
+            msg_bits[i].fill_with_bits(pb, msg_bv);
+            s_bits[i].fill_with_bits_of_field_element(pb, s);
+            verifiers[i].generate_r1cs_witness();
+        }
+    }
+};
+
+
+struct benchmark_family {
+    const char *name;
+    std::vector<size_t> sizes;
+    std::function<benchmark_circuit*(size_t)> make;
+};
+
+
+static double elapsed_ms( long long start )
+{
+    return (libff::get_nsec_time() - start) / 1e6;
+}
+
+
+/**
+* Run setup, witness generation, proving and verification for each circuit
+* family at several sizes, writing one CSV row per circuit to `output.csv`.
+* libff and the prover still print some sizes and counts on stdout, so the
+* rows go to their own file.
+*
+* Each proof also reports the duration of the prover's stages, so a
+* regression can be traced to the witness map or to one of the queries,
+* and its peak resident set size, measured from just before the proof.
+*
+* Usage: benchmark_prover <output.csv> [family ...]
+*
+* Families are mimc_merkle, poseidon, sha256 and eddsa, all by default.
+*/
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+    libff::inhibit_profiling_counters = true;
+
+    const std::vector<benchmark_family> families = {
+        {"mimc_merkle", {4, 16, 29}, [](size_t n) -> benchmark_circuit* { return new mimc_merkle_circuit(n); }},
+        {"poseidon", {8, 64, 512}, [](size_t n) -> benchmark_circuit* { return new poseidon_chain_circuit(n); }},
+        {"sha256", {1, 4, 16}, [](size_t n) -> benchmark_circuit* { return new sha256_chain_circuit(n); }},
+        {"eddsa", {1, 4, 16}, [](size_t n) -> benchmark_circuit* { return new eddsa_circuit(n); }}
+    };
+
+    if( argc < 2 ) {
+        std::cerr << "Usage: " << argv[0] << " <output.csv> [family ...]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> selected(argv + 2, argv + argc);
+    for( const auto &name : selected )
+    {
+        if( std::find_if(families.begin(), families.end(), [&](const benchmark_family &f) { return name == f.name; }) == families.end() ) {
+            std::cerr << "Error: unknown circuit family " << name << std::endl;
+            return 1;
+        }
+    }
+
+    FILE *csv = ::fopen(argv[1], "w");
+    if( csv == nullptr ) {
+        std::cerr << "Error: cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    ::fprintf(csv, "family,size,constraints,variables,inputs,threads,"
+                   "constraints_ms,setup_ms,witness_ms,prove_ms,verify_ms,"
+                   "witness_map_ms,H_ms,A_ms,B_ms,L_ms,peak_rss_mib\n");
+
+    for( const auto &family : families )
+    {
+        if( ! selected.empty() && std::find(selected.begin(), selected.end(), family.name) == selected.end() ) {
+            continue;
+        }
+
+        for( const size_t size : family.sizes )
+        {
+            const long long constraints_start = libff::get_nsec_time();
+            std::unique_ptr<benchmark_circuit> circuit(family.make(size));
+            circuit->generate_r1cs_constraints();
+            const double constraints_ms = elapsed_ms(constraints_start);
+
+            const long long setup_start = libff::get_nsec_time();
+            const auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(circuit->pb.get_constraint_system());
+            const double setup_ms = elapsed_ms(setup_start);
+
+            const long long witness_start = libff::get_nsec_time();
+            circuit->generate_r1cs_witness();
+            const double witness_ms = elapsed_ms(witness_start);
+
+            if( ! circuit->pb.is_satisfied() ) {
+                std::cerr << "Error: " << family.name << " circuit of size " << size << " is not satisfied" << std::endl;
+                return 2;
+            }
+
+            libsnark::prover_metrics metrics;
+            libsnark::r1cs_gg_ppzksnark_zok_prover_options options;
+            options.metrics = &metrics;
+
+            const auto primary_input = circuit->pb.primary_input();
+            libsnark::peak_rss_reset();
+            const long long prove_start = libff::get_nsec_time();
+            const auto proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(keypair.pk, primary_input, circuit->pb.auxiliary_input(), options);
+            const double prove_ms = elapsed_ms(prove_start);
+
+            const long long verify_start = libff::get_nsec_time();
+            const bool verified = libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, primary_input, proof);
+            const double verify_ms = elapsed_ms(verify_start);
+
+            if( ! verified ) {
+                std::cerr << "Error: " << family.name << " proof of size " << size << " doesn't verify" << std::endl;
+                return 3;
+            }
+
+            ::fprintf(csv, "%s,%zu,%zu,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                           family.name, size,
+                           circuit->pb.num_constraints(), circuit->pb.num_variables(), circuit->pb.num_inputs(),
+                           metrics.num_threads,
+                           constraints_ms, setup_ms, witness_ms, prove_ms, verify_ms,
+                           metrics.stages[libsnark::prover_stage_witness_map].seconds * 1e3,
+                           metrics.stages[libsnark::prover_stage_H].seconds * 1e3,
+                           metrics.stages[libsnark::prover_stage_A].seconds * 1e3,
+                           metrics.stages[libsnark::prover_stage_B].seconds * 1e3,
+                           metrics.stages[libsnark::prover_stage_L].seconds * 1e3,
+                           metrics.peak_rss_bytes / (1024.0 * 1024.0));
+            ::fflush(csv);
+        }
+    }
+
+    ::fclose(csv);
+
+    return 0;
+}
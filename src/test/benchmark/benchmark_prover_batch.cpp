@@ -0,0 +1,70 @@
+#include <cstdlib>
+
+#include <libff/common/profiling.hpp>
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+
+#include "ethsnarks.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+
+
+/**
+* Compare the time per proof of the batch prover against proving the same
+* witnesses one at a time, for a random circuit of 2^log_n constraints
+*
+* Usage: benchmark_prover_batch [log_n] [batch_size ...]
+*/
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+    libff::inhibit_profiling_counters = true;
+
+    const size_t log_n = argc > 1 ? ::atoi(argv[1]) : 16;
+    std::vector<size_t> batch_sizes;
+    for( int i = 2; i < argc; i++ )
+    {
+        batch_sizes.emplace_back(::atoi(argv[i]));
+    }
+    if( batch_sizes.empty() ) {
+        batch_sizes = {1, 4, 16, 64};
+    }
+
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(1ul << log_n, 10);
+    const auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+
+    ::printf("log2(n),batch,single (ms/proof),batch (ms/proof),speedup\n");
+
+    for( const size_t batch_size : batch_sizes )
+    {
+        const std::vector<libsnark::r1cs_primary_input<FieldT> > primary_inputs(batch_size, example.primary_input);
+        const std::vector<libsnark::r1cs_auxiliary_input<FieldT> > auxiliary_inputs(batch_size, example.auxiliary_input);
+
+        const long long single_start = libff::get_nsec_time();
+        for( size_t k = 0; k < batch_size; k++ )
+        {
+            libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(keypair.pk, primary_inputs[k], auxiliary_inputs[k]);
+        }
+        const long long single_ns = libff::get_nsec_time() - single_start;
+
+        const long long batch_start = libff::get_nsec_time();
+        const auto proofs = libsnark::r1cs_gg_ppzksnark_zok_prover_batch<ppT>(keypair.pk, primary_inputs, auxiliary_inputs);
+        const long long batch_ns = libff::get_nsec_time() - batch_start;
+
+        for( const auto &proof : proofs )
+        {
+            if( ! libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, example.primary_input, proof) )
+            {
+                std::cerr << "Error: batch proof doesn't verify, batch=" << batch_size << std::endl;
+                return 1;
+            }
+        }
+
+        ::printf("%zu,%zu,%.1f,%.1f,%.2f\n", log_n, batch_size,
+                 single_ns / 1e6 / batch_size, batch_ns / 1e6 / batch_size, double(single_ns) / double(batch_ns));
+        ::fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <cstdio>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+
+#include "ethsnarks.hpp"
+#include "utils.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+using ethsnarks::ProvingKeyT;
+using ethsnarks::VerificationKeyT;
+
+
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(100, 10);
+    const auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+
+    const std::string pk_path = "test_checksum_stream.pk.raw";
+    const std::string vk_path = "test_checksum_stream.vk.raw";
+
+    // Round-trip with the footer
+    ethsnarks::writeToFile<const ProvingKeyT>(pk_path, keypair.pk);
+    ethsnarks::writeToFile<const VerificationKeyT>(vk_path, keypair.vk);
+
+    if( ! (ethsnarks::loadFromFile<ProvingKeyT>(pk_path) == keypair.pk) ) {
+        std::cerr << "Error: proving key differs after round-trip" << std::endl;
+        return 1;
+    }
+
+    if( ! (ethsnarks::loadFromFile<VerificationKeyT>(vk_path) == keypair.vk) ) {
+        std::cerr << "Error: verification key differs after round-trip" << std::endl;
+        return 2;
+    }
+
+    // Files without a footer must still load
+    {
+        std::ofstream fh(vk_path, std::ios::binary);
+        fh << keypair.vk;
+    }
+    if( ! (ethsnarks::loadFromFile<VerificationKeyT>(vk_path) == keypair.vk) ) {
+        std::cerr << "Error: legacy verification key not loaded" << std::endl;
+        return 3;
+    }
+
+    // Flip a digit in the middle of the payload, so it still parses
+    {
+        std::fstream fh(pk_path, std::ios::binary | std::ios::in | std::ios::out);
+        fh.seekg(0, std::ios::end);
+        std::streamoff offset = fh.tellg() / 2;
+        char ch;
+        do {
+            fh.seekg(offset++);
+            ch = fh.get();
+        } while( ch < '0' || ch > '9' );
+        fh.seekp(offset - 1);
+        fh.put(ch ^ 1);
+    }
+
+    bool detected = false;
+    try {
+        ethsnarks::loadFromFile<ProvingKeyT>(pk_path);
+    }
+    catch( const std::runtime_error &ex ) {
+        detected = true;
+    }
+
+    ::remove(pk_path.c_str());
+    ::remove(vk_path.c_str());
+
+    if( ! detected ) {
+        std::cerr << "Error: corruption not detected" << std::endl;
+        return 4;
+    }
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <cstdio>
+#include <vector>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+
+#include "ethsnarks.hpp"
+#include "r1cs_gg_ppzksnark_zok/flat_proving_key.hpp"
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+
+
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(100, 10);
+    const auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+
+    const std::string path = "test_flat_proving_key.flat";
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_write_flat_proving_key<ppT>(keypair.pk, path) ) {
+        std::cerr << "Error: cannot write " << path << std::endl;
+        return 1;
+    }
+
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_is_flat_proving_key(path) ) {
+        std::cerr << "Error: magic not detected" << std::endl;
+        return 2;
+    }
+
+    libsnark::flat_proving_key_info info;
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_read_flat_proving_key_info(path, info)
+     || info.metadata.num_constraints != example.constraint_system.num_constraints()
+     || info.metadata.primary_input_size != example.constraint_system.primary_input_size
+     || info.metadata.L_query_size != keypair.pk.L_query.size() )
+    {
+        std::cerr << "Error: metadata doesn't match the key" << std::endl;
+        return 9;
+    }
+
+    libsnark::r1cs_gg_ppzksnark_zok_constraint_system<ppT> constraint_system;
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_read_flat_constraint_system<ppT>(path, constraint_system)
+     || ! (constraint_system == keypair.pk.constraint_system) )
+    {
+        std::cerr << "Error: constraint system differs from the original" << std::endl;
+        return 10;
+    }
+
+    libsnark::r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> mapped_pk;
+    if( ! mapped_pk.open(path) ) {
+        return 3;
+    }
+
+    if( ! (mapped_pk.to_proving_key() == keypair.pk) ) {
+        std::cerr << "Error: mapped proving key differs from the original" << std::endl;
+        return 4;
+    }
+
+    // The matrices are decoded from the file as the constraint system converts to
+    libsnark::qap_constraint_matrices<FieldT> matrices;
+    libsnark::qap_make_constraint_matrices(keypair.pk.constraint_system, matrices);
+    const auto &mapped_matrices = mapped_pk.constraint_matrices();
+    bool matrices_equal = mapped_matrices.num_constraints == matrices.num_constraints
+                       && mapped_matrices.num_inputs == matrices.num_inputs
+                       && mapped_matrices.num_variables == matrices.num_variables;
+    for( size_t k = 0; k < 3; k++ )
+    {
+        matrices_equal = matrices_equal
+                      && mapped_matrices.rows[k] == matrices.rows[k]
+                      && mapped_matrices.indices[k] == matrices.indices[k]
+                      && mapped_matrices.coefficients[k] == matrices.coefficients[k];
+    }
+    if( ! matrices_equal ) {
+        std::cerr << "Error: mapped constraint matrices differ from the constraint system" << std::endl;
+        return 16;
+    }
+
+    const auto proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(mapped_pk, example.primary_input, example.auxiliary_input, libsnark::r1cs_gg_ppzksnark_zok_prover_options());
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, example.primary_input, proof) ) {
+        std::cerr << "Error: proof from mapped proving key doesn't verify" << std::endl;
+        return 5;
+    }
+
+    // Explicit thread count and chunking, pinned to the first NUMA node with
+    // the key faulted in from there
+    std::vector<int> cpus;
+    if( ! libsnark::parallel_parse_cpu_list("0-3,8,10-11\n", cpus)
+     || cpus != std::vector<int>({0, 1, 2, 3, 8, 10, 11})
+     || libsnark::parallel_parse_cpu_list("3-1", cpus) ) {
+        std::cerr << "Error: CPU list parsed incorrectly" << std::endl;
+        return 11;
+    }
+
+    libsnark::r1cs_gg_ppzksnark_zok_prover_options pinned_options;
+    pinned_options.num_threads = 2;
+    pinned_options.numa_node = 0;
+    pinned_options.chunks = 3;
+    libsnark::prover_metrics metrics;
+    pinned_options.metrics = &metrics;
+    mapped_pk.prefault(pinned_options);
+    const auto pinned_proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(mapped_pk, example.primary_input, example.auxiliary_input, pinned_options);
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, example.primary_input, pinned_proof) ) {
+        std::cerr << "Error: proof with pinned threads doesn't verify" << std::endl;
+        return 12;
+    }
+
+    const auto num_variables = example.constraint_system.num_variables();
+    if( metrics.num_threads != 2 || metrics.chunks != 3 || metrics.seconds <= 0
+     || metrics.stages[libsnark::prover_stage_A].msm_size != num_variables + 1
+     || metrics.stages[libsnark::prover_stage_L].msm_size != num_variables - example.constraint_system.num_inputs()
+     || metrics.stages[libsnark::prover_stage_witness_map].domain_size < example.constraint_system.num_constraints() )
+    {
+        std::cerr << "Error: prover metrics don't match the proof" << std::endl;
+        return 13;
+    }
+
+    // The batch prover on the same threads and chunks
+    const std::vector<libsnark::r1cs_primary_input<FieldT> > primary_inputs(3, example.primary_input);
+    const std::vector<libsnark::r1cs_auxiliary_input<FieldT> > auxiliary_inputs(3, example.auxiliary_input);
+    const auto batch_proofs = libsnark::r1cs_gg_ppzksnark_zok_prover_batch<ppT>(keypair.pk, primary_inputs, auxiliary_inputs, pinned_options);
+    bool batch_verified = (batch_proofs.size() == primary_inputs.size());
+    for( const auto &batch_proof : batch_proofs )
+    {
+        batch_verified = batch_verified && libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, example.primary_input, batch_proof);
+    }
+    if( ! batch_verified ) {
+        std::cerr << "Error: batch proofs with pinned threads don't verify" << std::endl;
+        return 15;
+    }
+
+    // Compressed points are decompressed when opening
+    const std::string compressed_path = "test_flat_proving_key.compressed.flat";
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_write_flat_proving_key<ppT>(keypair.pk, compressed_path, true) ) {
+        std::cerr << "Error: cannot write " << compressed_path << std::endl;
+        return 6;
+    }
+
+    libsnark::r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> compressed_pk;
+    if( ! compressed_pk.open(compressed_path) ) {
+        return 7;
+    }
+
+    if( ! (compressed_pk.to_proving_key() == keypair.pk) ) {
+        std::cerr << "Error: decompressed proving key differs from the original" << std::endl;
+        return 8;
+    }
+
+    // Only x is stored, one whose x^3 + b isn't a square can't be decompressed
+    auto off_curve_x = ethsnarks::FqT::one();
+    while( libsnark::flat_coordinate_is_square(off_curve_x.squared() * off_curve_x + ethsnarks::G1T::coeff_b) ) {
+        off_curve_x += ethsnarks::FqT::one();
+    }
+    auto off_curve_pk = keypair.pk;
+    off_curve_pk.H_query[0] = ethsnarks::G1T(off_curve_x, ethsnarks::FqT::one(), ethsnarks::FqT::one());
+    libsnark::r1cs_gg_ppzksnark_zok_mapped_proving_key<ppT> off_curve_mapped_pk;
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_write_flat_proving_key<ppT>(off_curve_pk, compressed_path, true)
+     || off_curve_mapped_pk.open(compressed_path) ) {
+        std::cerr << "Error: compressed point not on the curve accepted" << std::endl;
+        return 14;
+    }
+
+    ::remove(path.c_str());
+    ::remove(compressed_path.c_str());
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "ethsnarks.hpp"
+#include "r1cs_gg_ppzksnark_zok/glv.hpp"
+#include "r1cs_gg_ppzksnark_zok/multiexp_pippenger.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+using ethsnarks::G1T;
+
+typedef libsnark::glv_endomorphism<G1T> glv;
+
+
+/**
+* The half scalars must recombine to k, and fit in glv::scalar_bits
+*/
+static bool test_decompose( const FieldT &k )
+{
+    glv::half_scalar k1, k2;
+    bool k1_negative, k2_negative;
+    glv::decompose(k, k1, k1_negative, k2, k2_negative);
+
+    const FieldT f1 = k1_negative ? -FieldT(k1) : FieldT(k1);
+    const FieldT f2 = k2_negative ? -FieldT(k2) : FieldT(k2);
+
+    if( f1 + f2 * glv::lambda() != k
+     || k1.num_bits() > glv::scalar_bits
+     || k2.num_bits() > glv::scalar_bits )
+    {
+        std::cerr << "GLV decomposition failed for k=";
+        k.print();
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool test_scalar_mul( const FieldT &k )
+{
+    const G1T P = G1T::random_element();
+
+    if( libsnark::glv_scalar_mul<G1T, FieldT>(k, P) != k * P ) {
+        std::cerr << "GLV scalar multiplication mismatch for k=";
+        k.print();
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool test_multi_exp( size_t n )
+{
+    std::vector<G1T> bases;
+    std::vector<FieldT> scalars;
+    G1T expected = G1T::zero();
+    for( size_t i = 0; i < n; i++ )
+    {
+        bases.emplace_back(G1T::random_element());
+        scalars.emplace_back(i % 7 == 0 ? -FieldT::one() : FieldT::random_element());
+        expected = expected + scalars[i] * bases[i];
+    }
+#ifdef USE_MIXED_ADDITION
+    libff::batch_to_special<G1T>(bases);
+#endif
+
+    const auto actual = libsnark::multi_exp_pippenger<G1T, FieldT>(bases.begin(), bases.end(), scalars.begin(), scalars.end(), 4);
+    const auto actual_affine = libsnark::multi_exp_pippenger<G1T, FieldT>(bases.begin(), bases.end(), scalars.begin(), scalars.end(), 4, true);
+    if( actual != expected || actual_affine != expected ) {
+        std::cerr << "GLV multi-exponentiation mismatch, n=" << n << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    // phi(P) = lambda * P
+    const G1T P = G1T::random_element();
+    if( glv::apply(P) != glv::lambda() * P || glv::apply(G1T::zero()) != G1T::zero() ) {
+        std::cerr << "Endomorphism doesn't match lambda" << std::endl;
+        return 1;
+    }
+
+    std::vector<FieldT> edge_cases = {
+        FieldT::zero(), FieldT::one(), -FieldT::one(), glv::lambda(), -glv::lambda(),
+        FieldT(2) ^ 127, FieldT(2) ^ 128, FieldT(2) ^ 253
+    };
+    for( size_t i = 0; i < 1000; i++ )
+    {
+        edge_cases.emplace_back(FieldT::random_element());
+    }
+
+    for( const auto &k : edge_cases )
+    {
+        if( ! test_decompose(k) ) {
+            return 2;
+        }
+    }
+
+    for( size_t i = 0; i < 10; i++ )
+    {
+        if( ! test_scalar_mul(edge_cases[i]) ) {
+            return 3;
+        }
+    }
+
+    for( size_t n : {0, 1, 5, 100, 3000} )
+    {
+        if( ! test_multi_exp(n) ) {
+            return 4;
+        }
+    }
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,301 @@
+#include <libff/algebra/scalar_multiplication/multiexp.hpp>
+#include <libsnark/knowledge_commitment/kc_multiexp.hpp>
+
+#include "ethsnarks.hpp"
+#include "r1cs_gg_ppzksnark_zok/batch_affine.hpp"
+#include "r1cs_gg_ppzksnark_zok/fixed_base_multiexp.hpp"
+#include "r1cs_gg_ppzksnark_zok/multiexp_pippenger.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+using ethsnarks::G1T;
+using ethsnarks::G2T;
+
+typedef libsnark::knowledge_commitment<G2T, G1T> KcT;
+
+
+/**
+* Random scalars, with a sprinkling of zeros and ones as produced by boolean witnesses
+*/
+static std::vector<FieldT> random_scalars( size_t n )
+{
+    std::vector<FieldT> scalars;
+    scalars.reserve(n);
+    for( size_t i = 0; i < n; i++ )
+    {
+        switch( i % 5 ) {
+            case 0: scalars.emplace_back(FieldT::zero()); break;
+            case 1: scalars.emplace_back(FieldT::one()); break;
+            default: scalars.emplace_back(FieldT::random_element());
+        }
+    }
+    return scalars;
+}
+
+
+template<typename T>
+static std::vector<T> random_bases( size_t n )
+{
+    std::vector<T> bases;
+    bases.reserve(n);
+    for( size_t i = 0; i < n; i++ )
+    {
+        bases.emplace_back(T::random_element());
+    }
+#ifdef USE_MIXED_ADDITION
+    libff::batch_to_special<T>(bases);
+#endif
+    return bases;
+}
+
+
+static bool test_G1( size_t n )
+{
+    const auto bases = random_bases<G1T>(n);
+    const auto scalars = random_scalars(n);
+
+    G1T expected = G1T::zero();
+    for( size_t i = 0; i < n; i++ )
+    {
+        expected = expected + (scalars[i] * bases[i]);
+    }
+
+    const auto bdlo12 = libff::multi_exp<G1T, FieldT, libff::multi_exp_method_BDLO12>(
+        bases.begin(), bases.end(), scalars.begin(), scalars.end(), 4);
+
+    const auto pippenger = libsnark::multi_exp_pippenger<G1T, FieldT>(
+        bases.begin(), bases.end(), scalars.begin(), scalars.end(), 4);
+
+    const auto pippenger_mixed = libsnark::multi_exp_pippenger_with_mixed_addition<G1T, FieldT>(
+        bases.begin(), bases.end(), scalars.begin(), scalars.end(), 4);
+
+    const auto pippenger_affine = libsnark::multi_exp_pippenger_with_mixed_addition<G1T, FieldT>(
+        bases.begin(), bases.end(), scalars.begin(), scalars.end(), 4, true);
+
+    if( pippenger != expected || pippenger_mixed != expected || pippenger_affine != expected || bdlo12 != expected )
+    {
+        std::cerr << "G1 multi-exponentiation mismatch, n=" << n << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+* Windows of 8 and 9 bits, where a round of the batch affine buckets is
+* limited by their number. A few distinct scalars put most of the bases
+* in the same buckets, which defers their additions to later rounds.
+*/
+static bool test_affine_buckets( size_t n )
+{
+    const auto bases = random_bases<G1T>(n);
+    const std::vector<FieldT> values = {FieldT::random_element(), FieldT::random_element(), -FieldT::one()};
+
+    std::vector<FieldT> scalars;
+    for( size_t i = 0; i < n; i++ )
+    {
+        scalars.emplace_back(values[i % values.size()]);
+    }
+
+    const size_t c = libsnark::pippenger_window_size(n);
+    if( c != 8 && c != 9 ) {
+        std::cerr << "Unexpected window size, n=" << n << " c=" << c << std::endl;
+        return false;
+    }
+
+    const auto expected = libsnark::multi_exp_pippenger<G1T, FieldT>(
+        bases.begin(), bases.end(), scalars.begin(), scalars.end(), 1);
+
+    for( size_t chunks : {1, 4} )
+    {
+        const auto pippenger_affine = libsnark::multi_exp_pippenger_with_mixed_addition<G1T, FieldT>(
+            bases.begin(), bases.end(), scalars.begin(), scalars.end(), chunks, true);
+
+        if( pippenger_affine != expected )
+        {
+            std::cerr << "Batch affine buckets mismatch, n=" << n << " chunks=" << chunks << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static bool test_kc( size_t n )
+{
+    const auto g = random_bases<G2T>(n);
+    const auto h = random_bases<G1T>(n);
+    const auto scalars = random_scalars(n);
+
+    std::vector<KcT> values;
+    for( size_t i = 0; i < n; i++ )
+    {
+        values.emplace_back(g[i], h[i]);
+    }
+    const libsnark::knowledge_commitment_vector<G2T, G1T> vec(std::move(values));
+
+    const auto expected = libsnark::kc_multi_exp_with_mixed_addition<G2T, G1T, FieldT, libff::multi_exp_method_BDLO12>(
+        vec, 0, n, scalars.begin(), scalars.end(), 4);
+
+    const auto pippenger = libsnark::kc_multi_exp_pippenger_with_mixed_addition<G2T, G1T, FieldT>(
+        vec, 0, n, scalars.begin(), scalars.end(), 4);
+
+    const auto pippenger_affine = libsnark::kc_multi_exp_pippenger_with_mixed_addition<G2T, G1T, FieldT>(
+        vec, 0, n, scalars.begin(), scalars.end(), 4, true);
+
+    if( pippenger != expected || pippenger_affine != expected )
+    {
+        std::cerr << "Knowledge commitment multi-exponentiation mismatch, n=" << n << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool test_batch( size_t n, size_t batch_size )
+{
+    const auto bases = random_bases<G1T>(n);
+
+    std::vector<std::vector<FieldT>> scalars;
+    std::vector<std::vector<FieldT>::const_iterator> scalar_starts;
+    for( size_t k = 0; k < batch_size; k++ )
+    {
+        scalars.emplace_back(random_scalars(n));
+    }
+    for( const auto &member : scalars )
+    {
+        scalar_starts.emplace_back(member.cbegin());
+    }
+
+    const auto results = libsnark::multi_exp_pippenger_batch<G1T, FieldT>(
+        bases.begin(), bases.end(), scalar_starts, 4);
+
+    for( size_t k = 0; k < batch_size; k++ )
+    {
+        const auto expected = libsnark::multi_exp_pippenger<G1T, FieldT>(
+            bases.begin(), bases.end(), scalars[k].begin(), scalars[k].end(), 4);
+
+        if( results[k] != expected )
+        {
+            std::cerr << "Batch multi-exponentiation mismatch, n=" << n << " k=" << k << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+* Sum of affine points, including doubles and negations which the affine formula can't add
+*/
+static bool test_batch_affine( size_t n )
+{
+    std::vector<G1T> points;
+    for( size_t i = 0; i < n; i++ )
+    {
+        switch( i % 7 ) {
+            case 3: points.emplace_back(points.back()); break;
+            case 5: points.emplace_back(-points.back()); break;
+            default: points.emplace_back(G1T::random_element());
+        }
+    }
+    libff::batch_to_special<G1T>(points);
+
+    G1T expected = G1T::zero();
+    for( const auto &p : points )
+    {
+        expected = expected + p;
+    }
+
+    if( libsnark::batch_affine_sum<G1T>(std::move(points)) != expected )
+    {
+        std::cerr << "Batch affine sum mismatch, n=" << n << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+template<typename T>
+static bool test_fixed_base( size_t n, size_t window )
+{
+    const auto bases = random_bases<T>(n);
+    const auto scalars = random_scalars(n);
+
+    const auto table = libsnark::fixed_base_table_build<T, FieldT>(bases.begin(), bases.end(), window);
+    const auto result = libsnark::fixed_base_multi_exp<T, FieldT>(table, scalars.begin(), scalars.end(), 4);
+
+    const auto expected = libsnark::multi_exp_pippenger<T, FieldT>(
+        bases.begin(), bases.end(), scalars.begin(), scalars.end(), 4);
+
+    if( result != expected )
+    {
+        std::cerr << "Fixed-base multi-exponentiation mismatch, n=" << n << " window=" << window << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+
+    for( size_t n : {1, 2, 7, 31, 100, 1000, 5000} )
+    {
+        if( ! test_G1(n) ) {
+            return 1;
+        }
+    }
+
+    for( size_t n : {1, 17, 300, 4000} )
+    {
+        if( ! test_kc(n) ) {
+            return 2;
+        }
+    }
+
+    // c=8 and c=9
+    for( size_t n : {1500, 2900, 3100, 8000} )
+    {
+        if( ! test_affine_buckets(n) ) {
+            return 6;
+        }
+    }
+
+    for( size_t n : {0, 1, 63, 64, 65, 3001} )
+    {
+        if( ! test_batch_affine(n) ) {
+            return 4;
+        }
+    }
+
+    for( size_t n : {1, 100, 2000} )
+    {
+        if( ! test_fixed_base<G1T>(n, 0) || ! test_fixed_base<G1T>(n, 5) || ! test_fixed_base<G2T>(n, 0) ) {
+            return 5;
+        }
+    }
+
+    for( size_t batch_size : {1, 3, 64} )
+    {
+        if( ! test_batch(1000, batch_size) ) {
+            return 3;
+        }
+    }
+
+    // More members than share a pass over the bases at a 9 bit window
+    if( ! test_batch(3000, libsnark::pippenger_batch_group_size(3000) + 1) ) {
+        return 3;
+    }
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
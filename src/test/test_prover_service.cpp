@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+#include <nlohmann/json.hpp>
+
+#include "ethsnarks.hpp"
+#include "export.hpp"
+#include "import.hpp"
+#include "prover_service.hpp"
+#include "stubs.hpp"
+#include "utils.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+
+
+static nlohmann::json to_json_list( const std::vector<FieldT> &values )
+{
+    nlohmann::json list = nlohmann::json::array();
+    for( const auto &value : values )
+    {
+        list.push_back("0x" + ethsnarks::HexStringFromBigint(value.as_bigint()));
+    }
+    return list;
+}
+
+
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(100, 10);
+    const auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+
+    const std::string pk_path = "test_prover_service.pk.raw";
+    ethsnarks::writeToFile<const ethsnarks::ProvingKeyT>(pk_path, keypair.pk);
+
+    ethsnarks::prover_service service(2, 4);
+    if( ! service.add_key("example", pk_path.c_str()) ) {
+        return 1;
+    }
+
+    const nlohmann::json request = {
+        {"key", "example"},
+        {"primary", to_json_list(example.primary_input)},
+        {"auxiliary", to_json_list(example.auxiliary_input)}
+    };
+
+    // The same key serves several requests
+    for( int i = 0; i < 3; i++ )
+    {
+        std::stringstream proof_stream;
+        proof_stream << service.handle_request(request.dump());
+        const auto proof_pair = ethsnarks::proof_from_json(proof_stream);
+
+        if( ! libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, proof_pair.first, proof_pair.second) ) {
+            std::cerr << "Error: proof from the service doesn't verify" << std::endl;
+            return 2;
+        }
+    }
+
+    nlohmann::json bad_request = request;
+    bad_request["key"] = "missing";
+    if( nlohmann::json::parse(service.handle_request(bad_request.dump())).count("error") == 0 ) {
+        std::cerr << "Error: unknown key accepted" << std::endl;
+        return 3;
+    }
+
+    bad_request = request;
+    bad_request["auxiliary"].erase(0);
+    if( nlohmann::json::parse(service.handle_request(bad_request.dump())).count("error") == 0 ) {
+        std::cerr << "Error: short assignment accepted" << std::endl;
+        return 4;
+    }
+
+    // Tables from another setup of the same circuit are rejected
+    const auto other_keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+    const auto other_expanded_pk = libsnark::r1cs_gg_ppzksnark_zok_expand_proving_key<ppT>(other_keypair.pk);
+    const auto expanded_path = ethsnarks::stub_expanded_pk_path(pk_path.c_str());
+    ethsnarks::writeToFile<const ethsnarks::ExpandedProvingKeyT>(expanded_path, other_expanded_pk);
+    if( service.add_key("stale", pk_path.c_str()) ) {
+        std::cerr << "Error: expanded key of another proving key accepted" << std::endl;
+        return 5;
+    }
+
+    bool rejected = false;
+    try {
+        libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(keypair.pk, other_expanded_pk, example.primary_input, example.auxiliary_input, libsnark::r1cs_gg_ppzksnark_zok_prover_options());
+    }
+    catch( const std::invalid_argument & ) {
+        rejected = true;
+    }
+    if( ! rejected ) {
+        std::cerr << "Error: prover used an expanded key of another proving key" << std::endl;
+        return 6;
+    }
+
+    ethsnarks::writeToFile<const ethsnarks::ExpandedProvingKeyT>(expanded_path, libsnark::r1cs_gg_ppzksnark_zok_expand_proving_key<ppT>(keypair.pk));
+    nlohmann::json expanded_request = request;
+    expanded_request["key"] = "expanded";
+    if( ! service.add_key("expanded", pk_path.c_str()) ) {
+        std::cerr << "Error: matching expanded key rejected" << std::endl;
+        return 7;
+    }
+    std::stringstream expanded_proof_stream;
+    expanded_proof_stream << service.handle_request(expanded_request.dump());
+    const auto expanded_proof_pair = ethsnarks::proof_from_json(expanded_proof_stream);
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, expanded_proof_pair.first, expanded_proof_pair.second) ) {
+        std::cerr << "Error: proof with the expanded key doesn't verify" << std::endl;
+        return 7;
+    }
+
+    // Writing a key without tables removes the stale ones
+    ethsnarks::ProtoboardT pb;
+    ethsnarks::VariableT x;
+    x.allocate(pb, "x");
+    pb.set_input_sizes(1);
+    pb.add_r1cs_constraint(ethsnarks::ConstraintT(x, x, x), "x*x == x");
+    const std::string vk_path = "test_prover_service.vk.json";
+    if( ethsnarks::stub_genkeys_from_pb(pb, pk_path.c_str(), vk_path.c_str()) != 0
+     || std::ifstream(expanded_path).good() ) {
+        std::cerr << "Error: stale expanded key kept" << std::endl;
+        return 8;
+    }
+
+    ::remove(pk_path.c_str());
+    ::remove(vk_path.c_str());
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
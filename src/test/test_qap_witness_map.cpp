@@ -0,0 +1,315 @@
+#include <libff/algebra/fields/field_utils.hpp>
+#include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+
+#include "ethsnarks.hpp"
+#include "r1cs_gg_ppzksnark_zok/qap_witness_map.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+
+
+/**
+* The task-parallel witness map must match libsnark's r1cs_to_qap_witness_map
+*/
+static bool test_witness_map( size_t num_constraints, size_t num_inputs )
+{
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(num_constraints, num_inputs);
+    const FieldT zero = FieldT::zero();
+
+    const auto expected = libsnark::r1cs_to_qap_witness_map(example.constraint_system, example.primary_input, example.auxiliary_input, zero, zero, zero);
+
+    // In memory, then with the evaluations in scratch files, then again
+    // in memory with the domain tables cached by the first proof
+    for( const std::string scratch_directory : {"", ".", ""} )
+    {
+        const auto actual = libsnark::r1cs_gg_ppzksnark_zok_witness_map(example.constraint_system, example.primary_input, example.auxiliary_input, scratch_directory);
+
+        if( actual.degree() != expected.degree()
+         || actual.coefficients_for_ABCs != expected.coefficients_for_ABCs
+         || actual.coefficients_for_H != expected.coefficients_for_H )
+        {
+            std::cerr << "Witness map mismatch, num_constraints=" << num_constraints << " scratch_directory=" << scratch_directory << std::endl;
+            return false;
+        }
+    }
+
+    // From matrices converted once, as the mapped proving keys hold them
+    libsnark::qap_constraint_matrices<FieldT> matrices;
+    libsnark::qap_make_constraint_matrices(example.constraint_system, matrices);
+    libsnark::r1cs_constraint_system<FieldT> converted;
+    libsnark::qap_make_constraint_system(matrices, converted);
+    if( ! (converted == example.constraint_system) ) {
+        std::cerr << "Constraint matrices don't convert back, num_constraints=" << num_constraints << std::endl;
+        return false;
+    }
+
+    for( size_t i = 0; i < 2; i++ )
+    {
+        const auto actual = libsnark::r1cs_gg_ppzksnark_zok_witness_map(matrices, example.primary_input, example.auxiliary_input);
+
+        if( actual.coefficients_for_ABCs != expected.coefficients_for_ABCs
+         || actual.coefficients_for_H != expected.coefficients_for_H )
+        {
+            std::cerr << "Witness map mismatch with matrices, num_constraints=" << num_constraints << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+* The generator's instance map must match libsnark's
+* r1cs_to_qap_instance_map_with_evaluation, at a random point and at a point
+* of the domain, where the Lagrange coefficients are 0 or 1
+*/
+static bool test_instance_map( size_t num_constraints, size_t num_inputs )
+{
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(num_constraints, num_inputs);
+    const auto &cs = example.constraint_system;
+
+    const auto tables = libsnark::qap_get_domain_tables<FieldT>(cs.num_constraints() + cs.num_inputs() + 1, false);
+    for( const FieldT t : {FieldT::random_element(), tables->omega ^ 3} )
+    {
+        const auto expected = libsnark::r1cs_to_qap_instance_map_with_evaluation(cs, t);
+        const auto actual = libsnark::r1cs_gg_ppzksnark_zok_instance_map_with_evaluation(cs, t);
+
+        if( actual.degree() != expected.degree()
+         || actual.num_variables() != expected.num_variables()
+         || actual.num_inputs() != expected.num_inputs()
+         || actual.At != expected.At
+         || actual.Bt != expected.Bt
+         || actual.Ct != expected.Ct
+         || actual.Ht != expected.Ht
+         || actual.Zt != expected.Zt )
+        {
+            std::cerr << "Instance map mismatch, num_constraints=" << num_constraints << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+* The blocked transforms must agree with qap_radix2_FFT, up to bit-reversal
+*/
+static bool test_blocked_fft( size_t log_n )
+{
+    const size_t n = 1ul << log_n;
+    const FieldT omega = libff::get_root_of_unity<FieldT>(n);
+
+    std::vector<FieldT> coeffs;
+    for( size_t i = 0; i < n; i++ )
+    {
+        coeffs.emplace_back(FieldT::random_element());
+    }
+
+    auto expected = coeffs;
+    libsnark::qap_radix2_FFT(expected, omega);
+
+    std::vector<FieldT> twiddles;
+    libsnark::qap_powers(twiddles, n / 2, omega);
+
+    auto dif = coeffs;
+    libsnark::qap_radix2_DIF(dif.data(), n, twiddles.data());
+
+    std::vector<FieldT> dit(n);
+    for( size_t i = 0; i < n; i++ )
+    {
+        dit[libff::bitreverse(i, log_n)] = coeffs[i];
+        if( dif[libff::bitreverse(i, log_n)] != expected[i] ) {
+            std::cerr << "DIF mismatch, n=" << n << " i=" << i << std::endl;
+            return false;
+        }
+    }
+
+    libsnark::qap_radix2_DIT(dit.data(), n, twiddles.data());
+    if( dit != expected ) {
+        std::cerr << "DIT mismatch, n=" << n << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool test_fft( size_t log_n )
+{
+    const size_t n = 1ul << log_n;
+    const FieldT omega = libff::get_root_of_unity<FieldT>(n);
+
+    std::vector<FieldT> coeffs;
+    for( size_t i = 0; i < n; i++ )
+    {
+        coeffs.emplace_back(FieldT::random_element());
+    }
+
+    auto evals = coeffs;
+    libsnark::qap_radix2_FFT(evals, omega);
+
+    for( size_t i = 0; i < n; i++ )
+    {
+        // Horner evaluation at omega^i
+        const FieldT x = omega ^ i;
+        FieldT y = FieldT::zero();
+        for( size_t j = n; j-- > 0; )
+        {
+            y = y * x + coeffs[j];
+        }
+
+        if( evals[i] != y ) {
+            std::cerr << "FFT mismatch, n=" << n << " i=" << i << std::endl;
+            return false;
+        }
+    }
+
+    libsnark::qap_radix2_iFFT(evals, omega);
+    if( evals != coeffs ) {
+        std::cerr << "iFFT mismatch, n=" << n << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+* The cached domain tables are shared between calls, and match the domain
+*/
+static bool test_domain_tables( size_t min_size )
+{
+    libsnark::qap_clear_domain_tables<FieldT>();
+
+    const auto without_twiddles = libsnark::qap_get_domain_tables<FieldT>(min_size, false);
+    if( ! without_twiddles || without_twiddles->has_twiddles
+     || libsnark::qap_get_domain_tables<FieldT>(min_size, false) != without_twiddles ) {
+        std::cerr << "Domain tables not cached, min_size=" << min_size << std::endl;
+        return false;
+    }
+
+    const auto tables = libsnark::qap_get_domain_tables<FieldT>(min_size, true);
+    if( ! tables || ! tables->has_twiddles
+     || libsnark::qap_get_domain_tables<FieldT>(min_size, false) != tables ) {
+        std::cerr << "Domain tables with twiddles not cached, min_size=" << min_size << std::endl;
+        return false;
+    }
+
+    const size_t m = tables->m;
+    const size_t logm = libff::log2(m);
+    const FieldT coset = FieldT::multiplicative_generator;
+    if( m < min_size || tables->omega != libff::get_root_of_unity<FieldT>(m)
+     || tables->Z_inverse_at_coset != ((coset ^ m) - FieldT::one()).inverse()
+     || tables->twiddles.size() != m / 2 ) {
+        std::cerr << "Domain tables mismatch, min_size=" << min_size << std::endl;
+        return false;
+    }
+
+    for( size_t j = 0; j < m / 2; j++ )
+    {
+        if( tables->twiddles[j] != (tables->omega ^ j)
+         || tables->inverse_twiddles[j] * tables->twiddles[j] != FieldT::one() ) {
+            std::cerr << "Twiddle mismatch, m=" << m << " j=" << j << std::endl;
+            return false;
+        }
+    }
+
+    bool ok = true;
+    libsnark::qap_for_each_coset_power_bitreversed(tables->coset_shift, m, [&](const size_t i, const FieldT &factor) {
+        if( factor != tables->m_inverse * (coset ^ libff::bitreverse(i, logm)) ) {
+            ok = false;
+        }
+    });
+    if( ! ok ) {
+        std::cerr << "Coset table mismatch, m=" << m << std::endl;
+        return false;
+    }
+
+    // Another size rounding up to the same domain shares the tables
+    if( libsnark::qap_get_domain_tables<FieldT>(m / 2 + 1, true) != tables ) {
+        std::cerr << "Domain tables not shared by size, m=" << m << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+* Only the most recently used domain sizes are kept
+*/
+static bool test_domain_cache_eviction()
+{
+    libsnark::qap_clear_domain_tables<FieldT>();
+
+    const auto first = libsnark::qap_get_domain_tables<FieldT>(2, false);
+    for( size_t i = 0; i < libsnark::qap_domain_cache_size; i++ )
+    {
+        libsnark::qap_get_domain_tables<FieldT>(4ul << i, false);
+    }
+
+    const auto rebuilt = libsnark::qap_get_domain_tables<FieldT>(2, false);
+    if( ! first || ! rebuilt || rebuilt == first
+     || libsnark::qap_get_domain_tables<FieldT>(2, false) != rebuilt ) {
+        std::cerr << "Least recently used domain tables not evicted" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    for( size_t log_n : {0, 1, 2, 5, 8} )
+    {
+        if( ! test_fft(log_n) ) {
+            return 1;
+        }
+    }
+
+    // Larger than qap_fft_block, so some passes span blocks
+    for( size_t log_n : {0, 3, 17} )
+    {
+        if( ! test_blocked_fft(log_n) ) {
+            return 3;
+        }
+    }
+
+    // Larger than the coset table chunks
+    for( size_t min_size : {2, 100, 20000} )
+    {
+        if( ! test_domain_tables(min_size) ) {
+            return 4;
+        }
+    }
+
+    if( ! test_domain_cache_eviction() ) {
+        return 4;
+    }
+
+    for( size_t num_constraints : {20, 100, 1000, 20000} )
+    {
+        if( ! test_witness_map(num_constraints, 10) ) {
+            return 2;
+        }
+    }
+
+    // Larger than qap_fft_grain and qap_column_grain
+    for( size_t num_constraints : {20, 1000, 20000} )
+    {
+        if( ! test_instance_map(num_constraints, 10) ) {
+            return 5;
+        }
+    }
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
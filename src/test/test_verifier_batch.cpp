@@ -0,0 +1,179 @@
+#include <memory>
+
+#include <libff/common/serialization.hpp>
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+
+#include "ethsnarks.hpp"
+#include "export.hpp"
+#include "stubs.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+
+typedef libsnark::r1cs_gg_ppzksnark_zok_primary_input<ppT> PrimaryInputT;
+typedef libsnark::r1cs_gg_ppzksnark_zok_proof<ppT> ProofT;
+
+
+/**
+* With enough inputs the processed key holds a table of gamma_ABC, the input
+* accumulation must match accumulate_chunk with and without it
+*/
+static bool test_input_table( size_t num_inputs )
+{
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(num_inputs + 10, num_inputs);
+    const auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+    const auto proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(keypair.pk, example.primary_input, example.auxiliary_input);
+
+    const auto pvk = libsnark::r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(keypair.vk);
+    const auto pvk_without_table = libsnark::r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(keypair.vk, false);
+    const bool has_table = num_inputs >= libsnark::r1cs_gg_ppzksnark_zok_input_table_threshold;
+    if( (pvk.gamma_ABC_table.num_bases() == num_inputs) != has_table
+     || pvk_without_table.gamma_ABC_table.num_bases() != 0
+     || ! (libff::reserialize<ethsnarks::ProcessedVerificationKeyT>(pvk) == pvk) ) {
+        std::cerr << "Error: gamma_ABC table mismatch, num_inputs=" << num_inputs << std::endl;
+        return false;
+    }
+
+    // Kept handles have the table, keys loaded for one verification don't
+    auto vk = keypair.vk;
+    const std::string vk_json = ethsnarks::vk2json(vk);
+    std::unique_ptr<ethsnarks::ProcessedVerificationKeyT> loaded_pvk(ethsnarks::stub_vk_load(vk_json.c_str()));
+    std::unique_ptr<ethsnarks::ProcessedVerificationKeyT> one_shot_pvk(ethsnarks::stub_vk_load(vk_json.c_str(), false));
+    if( ! loaded_pvk || ! one_shot_pvk
+     || (loaded_pvk->gamma_ABC_table.num_bases() == num_inputs) != has_table
+     || one_shot_pvk->gamma_ABC_table.num_bases() != 0 ) {
+        std::cerr << "Error: loaded gamma_ABC table mismatch, num_inputs=" << num_inputs << std::endl;
+        return false;
+    }
+
+    // Full length, shorter (weak input consistency), and empty
+    for( size_t length : {num_inputs, num_inputs / 2, size_t(0)} )
+    {
+        const PrimaryInputT input(example.primary_input.begin(), example.primary_input.begin() + length);
+        const auto expected = keypair.vk.gamma_ABC_g1.accumulate_chunk<FieldT>(input.begin(), input.end(), 0).first;
+        if( libsnark::r1cs_gg_ppzksnark_zok_accumulate_input(pvk, input) != expected
+         || libsnark::r1cs_gg_ppzksnark_zok_accumulate_input(pvk_without_table, input) != expected ) {
+            std::cerr << "Error: input accumulation mismatch, num_inputs=" << num_inputs << " length=" << length << std::endl;
+            return false;
+        }
+    }
+
+    if( ! libsnark::r1cs_gg_ppzksnark_zok_online_verifier_strong_IC<ppT>(pvk, example.primary_input, proof)
+     || ! libsnark::r1cs_gg_ppzksnark_zok_verifier_strong_IC<ppT>(keypair.vk, example.primary_input, proof)
+     || ! libsnark::r1cs_gg_ppzksnark_zok_online_verifier_batch_strong_IC<ppT>(pvk, {example.primary_input, example.primary_input}, {proof, proof}) ) {
+        std::cerr << "Error: proof rejected, num_inputs=" << num_inputs << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+int main( int argc, char **argv )
+{
+    ppT::init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(100, 10);
+    auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+
+    // Enough proofs for several tasks of Miller loops
+    std::vector<PrimaryInputT> primary_inputs;
+    std::vector<ProofT> proofs;
+    for( size_t i = 0; i < 20; i++ )
+    {
+        primary_inputs.emplace_back(example.primary_input);
+        proofs.emplace_back(libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(keypair.pk, example.primary_input, example.auxiliary_input));
+    }
+
+    for( size_t n : {0, 1, 20} )
+    {
+        const std::vector<PrimaryInputT> inputs(primary_inputs.begin(), primary_inputs.begin() + n);
+        const std::vector<ProofT> batch(proofs.begin(), proofs.begin() + n);
+        if( ! libsnark::r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC<ppT>(keypair.vk, inputs, batch) ) {
+            std::cerr << "Error: valid batch of " << n << " proofs rejected" << std::endl;
+            return 1;
+        }
+    }
+
+    // A single wrong input, or a single swapped proof element, fails the whole batch
+    auto bad_inputs = primary_inputs;
+    bad_inputs[7][0] += FieldT::one();
+    if( libsnark::r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC<ppT>(keypair.vk, bad_inputs, proofs) ) {
+        std::cerr << "Error: batch with a wrong input accepted" << std::endl;
+        return 2;
+    }
+
+    auto bad_proofs = proofs;
+    std::swap(bad_proofs[3].g_C, bad_proofs[3].g_A);
+    if( libsnark::r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC<ppT>(keypair.vk, primary_inputs, bad_proofs) ) {
+        std::cerr << "Error: batch with a wrong proof accepted" << std::endl;
+        return 3;
+    }
+
+    // Strong input consistency, and one input per proof
+    auto short_inputs = primary_inputs;
+    short_inputs[0].pop_back();
+    if( libsnark::r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC<ppT>(keypair.vk, short_inputs, proofs)
+     || libsnark::r1cs_gg_ppzksnark_zok_verifier_batch_strong_IC<ppT>(keypair.vk, std::vector<PrimaryInputT>(primary_inputs.begin(), primary_inputs.end() - 1), proofs) ) {
+        std::cerr << "Error: batch with mismatched inputs accepted" << std::endl;
+        return 4;
+    }
+
+    // Through the JSON stub
+    const std::string vk_json = ethsnarks::vk2json(keypair.vk);
+    std::vector<std::string> proofs_json;
+    for( size_t i = 0; i < proofs.size(); i++ )
+    {
+        proofs_json.emplace_back(ethsnarks::proof_to_json(proofs[i], primary_inputs[i]));
+    }
+    proofs_json.emplace_back(ethsnarks::proof_to_json(proofs[0], bad_inputs[7]));
+
+    std::vector<const char *> proofs_cstr;
+    for( const auto &proof_json : proofs_json )
+    {
+        proofs_cstr.emplace_back(proof_json.c_str());
+    }
+
+    if( ! ethsnarks::stub_verify_batch(vk_json.c_str(), proofs_cstr.data(), proofs.size())
+     || ethsnarks::stub_verify_batch(vk_json.c_str(), proofs_cstr.data(), proofs_cstr.size()) ) {
+        std::cerr << "Error: stub_verify_batch mismatch" << std::endl;
+        return 5;
+    }
+
+    // With the key processed once, and kept through serialization
+    std::unique_ptr<ethsnarks::ProcessedVerificationKeyT> pvk(ethsnarks::stub_vk_load(vk_json.c_str()));
+    if( ! pvk || ! (*pvk == libsnark::r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(keypair.vk))
+     || ! (libff::reserialize<ethsnarks::ProcessedVerificationKeyT>(*pvk) == *pvk)
+     || pvk->vk_alpha_g1_beta_g2 != ppT::reduced_pairing(keypair.vk.alpha_g1, keypair.vk.beta_g2) ) {
+        std::cerr << "Error: processed verifying key mismatch" << std::endl;
+        return 6;
+    }
+
+    for( size_t i = 0; i < proofs.size(); i++ )
+    {
+        if( ! ethsnarks::stub_verify_with(*pvk, proofs_cstr[i]) ) {
+            std::cerr << "Error: stub_verify_with rejected proof " << i << std::endl;
+            return 7;
+        }
+    }
+
+    if( ethsnarks::stub_verify_with(*pvk, proofs_cstr.back())
+     || ! ethsnarks::stub_verify_batch_with(*pvk, proofs_cstr.data(), proofs.size())
+     || ethsnarks::stub_verify_batch_with(*pvk, proofs_cstr.data(), proofs_cstr.size())
+     || ethsnarks::stub_vk_load("{}") != nullptr ) {
+        std::cerr << "Error: verifying with the processed key mismatch" << std::endl;
+        return 8;
+    }
+
+    for( size_t num_inputs : {5, 16, 100} )
+    {
+        if( ! test_input_table(num_inputs) ) {
+            return 9;
+        }
+    }
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <atomic>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+
+#include "ethsnarks.hpp"
+#include "export.hpp"
+#include "stubs.hpp"
+#include "verify_service.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+
+
+int main( int argc, char **argv )
+{
+    ethsnarks::stub_init_public_params();
+    ethsnarks::stub_init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(100, 10);
+    auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+    auto primary_input = example.primary_input;
+    auto proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(keypair.pk, primary_input, example.auxiliary_input);
+
+    const std::string vk_json = ethsnarks::vk2json(keypair.vk);
+    const std::string good_json = ethsnarks::proof_to_json(proof, primary_input);
+    primary_input[0] += FieldT::one();
+    const std::string bad_json = ethsnarks::proof_to_json(proof, primary_input);
+
+    for( size_t num_workers : {1, 3} )
+    {
+        ethsnarks::verify_service service(num_workers);
+        if( ! service.add_key("example", vk_json.c_str()) || service.add_key("broken", "{}") ) {
+            std::cerr << "Error: adding keys" << std::endl;
+            return 1;
+        }
+
+        std::string error;
+        if( service.submit("missing", {good_json}, nullptr, error) != 0 ) {
+            std::cerr << "Error: unknown key accepted" << std::endl;
+            return 2;
+        }
+
+        // The invalid proof is found in a batch, and in a job of its own
+        const uint64_t all_good = service.submit("example", {good_json, good_json, good_json}, nullptr, error);
+        const uint64_t one_bad = service.submit("example", {good_json, bad_json, good_json}, nullptr, error);
+        const uint64_t only_bad = service.submit("example", {bad_json}, nullptr, error);
+
+        std::vector<bool> results;
+        if( ! service.wait(all_good, results) || results != std::vector<bool>({true, true, true})
+         || ! service.wait(one_bad, results) || results != std::vector<bool>({true, false, true})
+         || ! service.wait(only_bad, results) || results != std::vector<bool>({false}) ) {
+            std::cerr << "Error: wrong results with " << num_workers << " workers" << std::endl;
+            return 3;
+        }
+
+        // Collected results are forgotten
+        if( service.poll(all_good, results) || service.wait(all_good, results) ) {
+            std::cerr << "Error: results returned twice" << std::endl;
+            return 4;
+        }
+
+        std::atomic<int> callbacks(0);
+        std::atomic<bool> callback_ok(true);
+        for( int i = 0; i < 4; i++ )
+        {
+            const uint64_t job_id = service.submit("example", {good_json, bad_json}, [&]( uint64_t, const std::vector<bool> &job_results ) {
+                if( job_results != std::vector<bool>({true, false}) ) {
+                    callback_ok = false;
+                }
+                callbacks++;
+            }, error);
+            if( job_id == 0 || service.poll(job_id, results) ) {
+                std::cerr << "Error: job with a callback kept" << std::endl;
+                return 5;
+            }
+        }
+
+        service.stop();
+        if( callbacks != 4 || ! callback_ok ) {
+            std::cerr << "Error: callbacks not called as expected" << std::endl;
+            return 6;
+        }
+    }
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+
+#include <libsnark/relations/constraint_satisfaction_problems/r1cs/examples/r1cs_examples.hpp>
+
+#include "ethsnarks.hpp"
+#include "export.hpp"
+#include "import.hpp"
+#include "stubs.hpp"
+#include "wire_format.hpp"
+
+using ethsnarks::ppT;
+using ethsnarks::FieldT;
+using ethsnarks::G1T;
+using ethsnarks::G2T;
+
+
+static bool proof_equals( const ethsnarks::InputProofPairType &a, const ethsnarks::InputProofPairType &b )
+{
+    return a.first == b.first && a.second == b.second;
+}
+
+
+int main( int argc, char **argv )
+{
+    ethsnarks::stub_init_public_params();
+    libff::inhibit_profiling_info = true;
+
+    const auto example = libsnark::generate_r1cs_example_with_field_input<FieldT>(100, 10);
+    auto keypair = libsnark::r1cs_gg_ppzksnark_zok_generator<ppT>(example.constraint_system);
+    auto primary_input = example.primary_input;
+    auto proof = libsnark::r1cs_gg_ppzksnark_zok_prover<ppT>(keypair.pk, primary_input, example.auxiliary_input);
+
+    // Decodes to the same as the JSON form
+    std::stringstream proof_stream(ethsnarks::proof_to_json(proof, primary_input));
+    std::stringstream vk_stream(ethsnarks::vk2json(keypair.vk));
+    const auto json_proof = ethsnarks::proof_from_json(proof_stream);
+    const auto json_vk = ethsnarks::vk_from_json(vk_stream);
+
+    for( int flags : {0, int(ethsnarks::WIRE_COMPRESSED)} )
+    {
+        const auto proof_data = ethsnarks::proof_to_wire(proof, primary_input, flags);
+        const auto vk_data = ethsnarks::vk_to_wire(keypair.vk, flags);
+
+        ethsnarks::InputProofPairType wire_proof;
+        ethsnarks::VerificationKeyT wire_vk;
+        if( ! ethsnarks::proof_from_wire(proof_data.data(), proof_data.size(), wire_proof)
+         || ! ethsnarks::vk_from_wire(vk_data.data(), vk_data.size(), wire_vk) ) {
+            std::cerr << "Error: cannot decode, flags=" << flags << std::endl;
+            return 1;
+        }
+
+        if( ! proof_equals(wire_proof, json_proof) || ! (wire_vk == json_vk) || ! (wire_vk == keypair.vk) ) {
+            std::cerr << "Error: decoded mismatch, flags=" << flags << std::endl;
+            return 2;
+        }
+
+        // Truncated, or with trailing bytes
+        ethsnarks::InputProofPairType dummy_proof;
+        ethsnarks::VerificationKeyT dummy_vk;
+        auto longer = proof_data;
+        longer.push_back(0);
+        if( ethsnarks::proof_from_wire(proof_data.data(), proof_data.size() - 1, dummy_proof)
+         || ethsnarks::proof_from_wire(longer.data(), longer.size(), dummy_proof)
+         || ethsnarks::proof_from_wire(proof_data.data(), 0, dummy_proof)
+         || ethsnarks::vk_from_wire(vk_data.data(), vk_data.size() - 1, dummy_vk) ) {
+            std::cerr << "Error: wrong length accepted, flags=" << flags << std::endl;
+            return 3;
+        }
+
+        // Unknown flags, a coordinate above the modulus, x not on the curve
+        auto bad_flags = proof_data;
+        bad_flags[0] |= 2;
+        auto bad_coordinate = proof_data;
+        std::fill(bad_coordinate.begin() + 1, bad_coordinate.begin() + 33, flags ? 0x3F : 0xFF);
+        auto bad_point = proof_data;
+        bad_point[32] ^= 1;
+        if( ethsnarks::proof_from_wire(bad_flags.data(), bad_flags.size(), dummy_proof)
+         || ethsnarks::proof_from_wire(bad_coordinate.data(), bad_coordinate.size(), dummy_proof)
+         || (ethsnarks::proof_from_wire(bad_point.data(), bad_point.size(), dummy_proof) && ! flags) ) {
+            std::cerr << "Error: invalid encoding accepted, flags=" << flags << std::endl;
+            return 4;
+        }
+
+        // A changed x decodes to another point, or none, never the proof
+        if( ethsnarks::proof_from_wire(bad_point.data(), bad_point.size(), dummy_proof) && proof_equals(dummy_proof, json_proof) ) {
+            std::cerr << "Error: changed point decoded as the original" << std::endl;
+            return 5;
+        }
+
+        // Through the stubs, the key processed as from JSON
+        std::unique_ptr<ethsnarks::ProcessedVerificationKeyT> pvk(ethsnarks::stub_vk_load_wire(vk_data.data(), vk_data.size()));
+        if( ! pvk || ! (*pvk == libsnark::r1cs_gg_ppzksnark_zok_verifier_process_vk<ppT>(keypair.vk))
+         || ! ethsnarks::stub_verify_wire_with(*pvk, proof_data.data(), proof_data.size())
+         || ethsnarks::stub_verify_wire_with(*pvk, bad_flags.data(), bad_flags.size())
+         || ethsnarks::stub_vk_load_wire(vk_data.data(), 1) != nullptr ) {
+            std::cerr << "Error: stub verify mismatch, flags=" << flags << std::endl;
+            return 6;
+        }
+    }
+
+    // Points at infinity, and no inputs
+    proof.g_A = G1T::zero();
+    proof.g_B = G2T::zero();
+    primary_input.clear();
+    for( int flags : {0, int(ethsnarks::WIRE_COMPRESSED)} )
+    {
+        const auto proof_data = ethsnarks::proof_to_wire(proof, primary_input, flags);
+        ethsnarks::InputProofPairType wire_proof;
+        if( ! ethsnarks::proof_from_wire(proof_data.data(), proof_data.size(), wire_proof)
+         || ! wire_proof.first.empty() || ! (wire_proof.second == proof) ) {
+            std::cerr << "Error: infinity round trip, flags=" << flags << std::endl;
+            return 7;
+        }
+    }
+
+    // Hex strings match mpz's
+    for( const auto &value : {FieldT::zero(), FieldT::one(), FieldT(0x1234abcd), -FieldT::one()} )
+    {
+        mpz_t value_mpz;
+        ::mpz_init(value_mpz);
+        value.as_bigint().to_mpz(value_mpz);
+        char *expected = mpz_get_str(nullptr, 16, value_mpz);
+        const bool matches = ethsnarks::HexStringFromBigint(value.as_bigint()) == expected;
+        ::mpz_clear(value_mpz);
+        ::free(expected);
+        if( ! matches ) {
+            std::cerr << "Error: hex string mismatch" << std::endl;
+            return 8;
+        }
+    }
+
+    std::cout << "OK" << std::endl;
+
+    return 0;
+}
@@ -1,9 +1,13 @@
 #ifndef ETHSNARKS_UTILS_HPP_
 #define ETHSNARKS_UTILS_HPP_
 
+#include <cstring>
 #include <fstream>
+#include <iostream>
+#include <stdexcept>
 
 #include "ethsnarks.hpp"
+#include "checksum_stream.hpp"
 
 #include <libsnark/gadgetlib1/pb_variable.hpp>
 
@@ -164,34 +168,70 @@ inline const libsnark::pb_linear_combination<FieldT> make_linear_term( Protoboar
 bool is_negative( const FieldT& value );
 
 
+/**
+* Serialize `obj` straight into the file, through a bounded buffer, followed
+* by a footer with the payload size and its SHA256.
+*/
 template<typename T>
 void writeToFile(std::string path, T& obj) {
-    std::stringstream ss;
-    ss << obj;
     std::ofstream fh;
     fh.open(path, std::ios::binary);
-    ss.rdbuf()->pubseekpos(0, std::ios_base::out);
-    fh << ss.rdbuf();
+    if( ! fh.is_open() ) {
+        throw std::runtime_error("Cannot open for writing: " + path);
+    }
+
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    uint64_t payload_size;
+    {
+        sha256_ostreambuf buf(fh.rdbuf());
+        std::ostream out(&buf);
+        out << obj;
+        if( ! out || ! buf.digest(digest) ) {
+            throw std::runtime_error("Error writing: " + path);
+        }
+        payload_size = buf.size();
+    }
+
+    write_checksum_footer(fh, payload_size, digest);
     fh.flush();
+    if( ! fh ) {
+        throw std::runtime_error("Error writing: " + path);
+    }
     fh.close();
 }
 
 
+/**
+* Parse `obj` straight from the file. If it has a checksum footer the payload
+* is verified as it is read, files without one are read as before.
+*/
 template<typename T>
 T loadFromFile(std::string path) {
-    std::stringstream ss;
     std::ifstream fh(path, std::ios::binary);
+    if( ! fh.is_open() ) {
+        throw std::runtime_error("Cannot open for reading: " + path);
+    }
 
-    // TODO: more useful error if file not found
-    assert(fh.is_open());
+    T obj;
 
-    ss << fh.rdbuf();
-    fh.close();
+    uint64_t payload_size;
+    uint8_t expected_digest[SHA256_DIGEST_LENGTH];
+    if( ! read_checksum_footer(fh, payload_size, expected_digest) )
+    {
+        fh >> obj;
+        return obj;
+    }
 
-    ss.rdbuf()->pubseekpos(0, std::ios_base::in);
+    sha256_istreambuf buf(fh.rdbuf(), payload_size);
+    std::istream in(&buf);
+    in >> obj;
 
-    T obj;
-    ss >> obj;
+    uint8_t actual_digest[SHA256_DIGEST_LENGTH];
+    if( ! buf.digest(actual_digest) || 0 != ::memcmp(actual_digest, expected_digest, sizeof(actual_digest)) )
+    {
+        std::cerr << "Checksum mismatch: " << path << std::endl;
+        throw std::runtime_error("Checksum mismatch: " + path);
+    }
 
     return obj;
 }
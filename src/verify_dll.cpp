@@ -1,4 +1,22 @@
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
 #include "stubs.hpp"
+#include "verify_service.hpp"
+
+static int ethsnarks_verify_pool_collect( bool done, const std::vector<bool> &results, uint8_t *out_results )
+{
+    if( ! done ) {
+        return 0;
+    }
+    std::copy(results.begin(), results.end(), out_results);
+    return 1;
+}
+
 
 extern "C" {
 
@@ -7,4 +25,191 @@ bool ethsnarks_verify( const char *vk_json, const char *proof_json )
     return ethsnarks::stub_verify( vk_json, proof_json );
 }
 
+bool ethsnarks_verify_batch( const char *vk_json, const char **proofs_json, size_t n_proofs )
+{
+    return ethsnarks::stub_verify_batch( vk_json, proofs_json, n_proofs );
+}
+
+/**
+* A handle to the processed verifying key, NULL if `vk_json` is invalid.
+* It is reused by ethsnarks_verify_with until freed by ethsnarks_vk_free.
+*/
+void *ethsnarks_vk_load( const char *vk_json )
+{
+    return ethsnarks::stub_vk_load( vk_json );
+}
+
+bool ethsnarks_verify_with( const void *vk_handle, const char *proof_json )
+{
+    if( vk_handle == nullptr ) {
+        return false;
+    }
+    return ethsnarks::stub_verify_with( *static_cast<const ethsnarks::ProcessedVerificationKeyT *>(vk_handle), proof_json );
+}
+
+bool ethsnarks_verify_batch_with( const void *vk_handle, const char **proofs_json, size_t n_proofs )
+{
+    if( vk_handle == nullptr ) {
+        return false;
+    }
+    return ethsnarks::stub_verify_batch_with( *static_cast<const ethsnarks::ProcessedVerificationKeyT *>(vk_handle), proofs_json, n_proofs );
+}
+
+/**
+* As ethsnarks_vk_load and ethsnarks_verify_with, with the key and proof in
+* the binary wire format. The handles of both are interchangeable.
+*/
+void *ethsnarks_vk_load_wire( const uint8_t *vk_data, size_t vk_size )
+{
+    return ethsnarks::stub_vk_load_wire( vk_data, vk_size );
+}
+
+bool ethsnarks_verify_wire_with( const void *vk_handle, const uint8_t *proof_data, size_t proof_size )
+{
+    if( vk_handle == nullptr ) {
+        return false;
+    }
+    return ethsnarks::stub_verify_wire_with( *static_cast<const ethsnarks::ProcessedVerificationKeyT *>(vk_handle), proof_data, proof_size );
+}
+
+void ethsnarks_vk_free( void *vk_handle )
+{
+    delete static_cast<ethsnarks::ProcessedVerificationKeyT *>(vk_handle);
+}
+
+/**
+* Called on a worker thread when a job submitted with it finishes, with one
+* result per proof, 1 if it is valid. `results` is only valid for the call.
+*/
+typedef void (*ethsnarks_verify_callback)( void *user_data, uint64_t job_id, const uint8_t *results, size_t n_results );
+
+/**
+* A pool of `num_workers` verification threads, see verify_service.hpp, or
+* NULL if it can't be created. Creating one disables libff's profiling for
+* the whole process.
+*
+* No exception crosses into the caller: the pool functions report them on
+* stderr and return NULL, 0 or false, as they do for a NULL pool.
+*/
+void *ethsnarks_verify_pool_create( size_t num_workers, size_t max_queue )
+{
+    try {
+        return new ethsnarks::verify_service(num_workers, max_queue);
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot create verification pool: " << ex.what() << std::endl;
+        return nullptr;
+    }
+}
+
+/**
+* Finishes the queued jobs, then frees the pool
+*/
+void ethsnarks_verify_pool_free( void *pool )
+{
+    delete static_cast<ethsnarks::verify_service *>(pool);
+}
+
+bool ethsnarks_verify_pool_add_key( void *pool, const char *key_name, const char *vk_json )
+{
+    if( pool == nullptr || key_name == nullptr || vk_json == nullptr ) {
+        return false;
+    }
+
+    try {
+        return static_cast<ethsnarks::verify_service *>(pool)->add_key(key_name, vk_json);
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot add verifying key: " << ex.what() << std::endl;
+        return false;
+    }
+}
+
+/**
+* Queues the proofs, which are copied, returns the job id or 0 on error.
+* With a NULL callback the results are collected by ethsnarks_verify_pool_poll
+* or ethsnarks_verify_pool_wait.
+*/
+uint64_t ethsnarks_verify_pool_submit( void *pool, const char *key_name, const char **proofs_json, size_t n_proofs,
+                                       ethsnarks_verify_callback callback, void *user_data )
+{
+    if( pool == nullptr || key_name == nullptr || (proofs_json == nullptr && n_proofs > 0) ) {
+        return 0;
+    }
+
+    std::string error;
+    try {
+        std::vector<std::string> proofs;
+        proofs.reserve(n_proofs);
+        for( size_t i = 0; i < n_proofs; i++ )
+        {
+            if( proofs_json[i] == nullptr ) {
+                return 0;
+            }
+            proofs.emplace_back(proofs_json[i]);
+        }
+
+        ethsnarks::verify_service::callback_type on_done;
+        if( callback != nullptr ) {
+            on_done = [callback, user_data]( uint64_t job_id, const std::vector<bool> &results ) {
+                const std::vector<uint8_t> flags(results.begin(), results.end());
+                callback(user_data, job_id, flags.data(), flags.size());
+            };
+        }
+
+        const uint64_t job_id = static_cast<ethsnarks::verify_service *>(pool)->submit(key_name, std::move(proofs), on_done, error);
+        if( job_id != 0 ) {
+            return job_id;
+        }
+    }
+    catch( const std::exception &ex ) {
+        error = ex.what();
+    }
+
+    std::cerr << "Error: cannot submit verification job: " << error << std::endl;
+    return 0;
+}
+
+/**
+* Returns 1 and writes one result per proof to `out_results` if the job has
+* finished, which forgets it, 0 otherwise
+*/
+int ethsnarks_verify_pool_poll( void *pool, uint64_t job_id, uint8_t *out_results )
+{
+    if( pool == nullptr ) {
+        return 0;
+    }
+
+    try {
+        std::vector<bool> results;
+        const bool done = static_cast<ethsnarks::verify_service *>(pool)->poll(job_id, results);
+        return ethsnarks_verify_pool_collect(done, results, out_results);
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot poll verification job: " << ex.what() << std::endl;
+        return 0;
+    }
+}
+
+/**
+* As ethsnarks_verify_pool_poll, waiting for the job. Returns 0 only if the
+* job is unknown, or on error.
+*/
+int ethsnarks_verify_pool_wait( void *pool, uint64_t job_id, uint8_t *out_results )
+{
+    if( pool == nullptr ) {
+        return 0;
+    }
+
+    try {
+        std::vector<bool> results;
+        const bool done = static_cast<ethsnarks::verify_service *>(pool)->wait(job_id, results);
+        return ethsnarks_verify_pool_collect(done, results, out_results);
+    }
+    catch( const std::exception &ex ) {
+        std::cerr << "Error: cannot wait for verification job: " << ex.what() << std::endl;
+        return 0;
+    }
+}
+
 }
@@ -0,0 +1,209 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "verify_service.hpp"
+#include "import.hpp"
+#include "stubs.hpp"
+
+#include "r1cs_gg_ppzksnark_zok/parallel.hpp"
+
+namespace ethsnarks {
+
+
+verify_service::verify_service( size_t num_workers, size_t max_queue ) :
+    m_max_queue(max_queue),
+    m_num_threads(num_workers > 1 ? 1 : 0),
+    m_next_id(1),
+    m_stopping(false)
+{
+    stub_init_public_params();
+
+    // even one worker runs beside verifications and key loads on the caller's threads
+    libff::inhibit_profiling_info = true;
+    libff::inhibit_profiling_counters = true;
+
+    num_workers = std::max<size_t>(1, num_workers);
+
+    for( size_t i = 0; i < num_workers; i++ )
+    {
+        m_workers.emplace_back(&verify_service::worker, this);
+    }
+}
+
+
+verify_service::~verify_service()
+{
+    stop();
+}
+
+
+bool verify_service::add_key( const std::string &name, const char *vk_json )
+{
+    std::shared_ptr<const ProcessedVerificationKeyT> pvk(stub_vk_load(vk_json));
+    if( ! pvk ) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_keys[name] = pvk;
+
+    return true;
+}
+
+
+uint64_t verify_service::submit( const std::string &key_name, std::vector<std::string> &&proofs_json, const callback_type &callback, std::string &out_error )
+{
+    std::shared_ptr<job> new_job = std::make_shared<job>();
+    new_job->proofs_json = std::move(proofs_json);
+    new_job->callback = callback;
+    new_job->done = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto it = m_keys.find(key_name);
+        if( it == m_keys.end() ) {
+            out_error = "unknown key";
+            return 0;
+        }
+        new_job->pvk = it->second;
+
+        if( m_stopping ) {
+            out_error = "stopping";
+            return 0;
+        }
+
+        if( m_queue.size() >= m_max_queue ) {
+            out_error = "queue full";
+            return 0;
+        }
+
+        new_job->id = m_next_id++;
+        if( ! callback ) {
+            m_jobs[new_job->id] = new_job;
+        }
+        m_queue.emplace_back(new_job);
+    }
+
+    m_cv.notify_one();
+
+    return new_job->id;
+}
+
+
+bool verify_service::poll( uint64_t job_id, std::vector<bool> &out_results )
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto it = m_jobs.find(job_id);
+    if( it == m_jobs.end() || ! it->second->done ) {
+        return false;
+    }
+
+    out_results = std::move(it->second->results);
+    m_jobs.erase(it);
+
+    return true;
+}
+
+
+bool verify_service::wait( uint64_t job_id, std::vector<bool> &out_results )
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto it = m_jobs.find(job_id);
+    if( it == m_jobs.end() ) {
+        return false;
+    }
+
+    const std::shared_ptr<job> waited = it->second;
+    m_done_cv.wait(lock, [&waited]{ return waited->done; });
+
+    // another thread may have collected it meanwhile
+    it = m_jobs.find(job_id);
+    if( it == m_jobs.end() ) {
+        return false;
+    }
+
+    out_results = std::move(it->second->results);
+    m_jobs.erase(it);
+
+    return true;
+}
+
+
+void verify_service::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+
+    for( auto &thread : m_workers )
+    {
+        if( thread.joinable() ) {
+            thread.join();
+        }
+    }
+}
+
+
+void verify_service::worker()
+{
+    // with several workers each verifies on its own thread
+    const libsnark::parallel_thread_scope thread_scope(m_num_threads, -1);
+
+    while( true )
+    {
+        std::shared_ptr<job> current;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]{ return m_stopping || ! m_queue.empty(); });
+            if( m_queue.empty() ) {
+                return;
+            }
+            current = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        const size_t n_proofs = current->proofs_json.size();
+        std::vector<const char *> proofs_cstr;
+        proofs_cstr.reserve(n_proofs);
+        for( const auto &proof_json : current->proofs_json )
+        {
+            proofs_cstr.emplace_back(proof_json.c_str());
+        }
+
+        std::vector<bool> results(n_proofs, true);
+        if( n_proofs == 1 || ! stub_verify_batch_with(*current->pvk, proofs_cstr.data(), n_proofs) )
+        {
+            for( size_t i = 0; i < n_proofs; i++ )
+            {
+                results[i] = stub_verify_with(*current->pvk, proofs_cstr[i]);
+            }
+        }
+        std::vector<std::string>().swap(current->proofs_json);
+
+        if( current->callback )
+        {
+            current->callback(current->id, results);
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            current->results = std::move(results);
+            current->done = true;
+        }
+        m_done_cv.notify_all();
+    }
+}
+
+
+// namespace ethsnarks
+}
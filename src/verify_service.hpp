@@ -0,0 +1,103 @@
+#ifndef ETHSNARKS_VERIFY_SERVICE_HPP_
+#define ETHSNARKS_VERIFY_SERVICE_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ethsnarks.hpp"
+
+namespace ethsnarks {
+
+
+/**
+* Verifies batches of proofs on a pool of worker threads, against verifying
+* keys which are processed once when added.
+*
+* A job is a batch of proofs for one key. It is first checked with the batch
+* verifier, and only if that fails are its proofs verified one by one, to
+* find which are invalid. Results are fetched with poll() or wait(), or
+* handed to the job's callback, which runs on the worker thread.
+*
+* With a single worker each job uses every core through OpenMP, with more
+* the workers run one thread each.
+*
+* Creating a service disables libff's profiling for the whole process, by
+* setting libff::inhibit_profiling_info and inhibit_profiling_counters, and
+* they stay set after it is destroyed. Profiling isn't thread safe, and the
+* workers run alongside add_key() and any other verification or proving on
+* the caller's threads.
+*/
+class verify_service
+{
+public:
+    /* Called with the job's id and one result per proof */
+    typedef std::function<void(uint64_t, const std::vector<bool> &)> callback_type;
+
+    verify_service( size_t num_workers = 1, size_t max_queue = 1024 );
+
+    ~verify_service();
+
+    verify_service( const verify_service& ) = delete;
+    verify_service& operator=( const verify_service& ) = delete;
+
+    /** Parse and process the verifying key JSON as `name` */
+    bool add_key( const std::string &name, const char *vk_json );
+
+    /**
+    * Queue a batch of proof JSONs, returns the job's id, or 0 if the key
+    * is unknown or the queue is full. Without a callback the results are
+    * kept until collected by poll() or wait().
+    */
+    uint64_t submit( const std::string &key_name, std::vector<std::string> &&proofs_json, const callback_type &callback, std::string &out_error );
+
+    /**
+    * If the job has finished, move its results to `out_results` and
+    * forget it. Returns false if it hasn't, or is unknown.
+    */
+    bool poll( uint64_t job_id, std::vector<bool> &out_results );
+
+    /** As poll(), but waits for the job to finish */
+    bool wait( uint64_t job_id, std::vector<bool> &out_results );
+
+    /** Finish the queued jobs, then stop the workers */
+    void stop();
+
+private:
+    struct job {
+        uint64_t id;
+        std::shared_ptr<const ProcessedVerificationKeyT> pvk;
+        std::vector<std::string> proofs_json;
+        callback_type callback;
+        bool done;
+        std::vector<bool> results;
+    };
+
+    void worker();
+
+    std::map<std::string, std::shared_ptr<const ProcessedVerificationKeyT> > m_keys;
+    std::map<uint64_t, std::shared_ptr<job> > m_jobs;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_done_cv;
+    std::deque<std::shared_ptr<job> > m_queue;
+    const size_t m_max_queue;
+    const size_t m_num_threads;
+    uint64_t m_next_id;
+    bool m_stopping;
+    std::vector<std::thread> m_workers;
+};
+
+
+// namespace ethsnarks
+}
+
+#endif
@@ -0,0 +1,402 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "wire_format.hpp"
+
+#include "r1cs_gg_ppzksnark_zok/flat_proving_key.hpp"
+
+namespace ethsnarks {
+
+namespace {
+
+typedef libff::alt_bn128_Fq2 Fq2T;
+
+const size_t wire_field_size = 32;
+const size_t wire_count_size = 4;
+
+/* Flags in the first byte of a compressed point, both moduli are below 2^254 */
+const uint8_t wire_point_odd_y = 0x80;
+const uint8_t wire_point_infinity = 0x40;
+
+
+template<typename T>
+void wire_write_field( const T &value, uint8_t *out )
+{
+    static_assert(T::num_limbs * GMP_NUMB_BITS >= wire_field_size * 8, "field element wider than its encoding");
+
+    const auto value_bigint = value.as_bigint();
+    for( size_t i = 0; i < wire_field_size; i++ )
+    {
+        const size_t bit = (wire_field_size - 1 - i) * 8;
+        out[i] = uint8_t(value_bigint.data[bit / GMP_NUMB_BITS] >> (bit % GMP_NUMB_BITS));
+    }
+}
+
+
+/**
+* Decodes the big-endian integer into the field element, the bits cleared
+* in `first_mask` are ignored. False unless it's below the modulus.
+*/
+template<typename T>
+bool wire_read_field( const uint8_t *in, T &out, uint8_t first_mask = 0xFF )
+{
+    libff::bigint<T::num_limbs> value;
+    value.clear();
+
+    for( size_t i = 0; i < wire_field_size; i++ )
+    {
+        const size_t bit = (wire_field_size - 1 - i) * 8;
+        const uint8_t byte = (i == 0) ? (in[i] & first_mask) : in[i];
+        value.data[bit / GMP_NUMB_BITS] |= mp_limb_t(byte) << (bit % GMP_NUMB_BITS);
+    }
+
+    if( mpn_cmp(value.data, T::mod.data, T::num_limbs) >= 0 ) {
+        return false;
+    }
+
+    out = T(value);
+    return true;
+}
+
+
+bool wire_is_square( const FqT &value )
+{
+    return value.is_zero() || (value ^ FqT::euler) == FqT::one();
+}
+
+
+/* Fq2 elements are squares when their norm is a square in Fq */
+bool wire_is_square( const Fq2T &value )
+{
+    return wire_is_square(value.c0.squared() - Fq2T::non_residue * value.c1.squared());
+}
+
+
+template<typename T>
+struct wire_coordinate;
+
+template<>
+struct wire_coordinate<FqT>
+{
+    static size_t size() { return wire_field_size; }
+
+    static void write( const FqT &x, uint8_t *out )
+    {
+        wire_write_field(x, out);
+    }
+
+    static bool read( const uint8_t *in, FqT &x, uint8_t first_mask )
+    {
+        return wire_read_field(in, x, first_mask);
+    }
+};
+
+template<>
+struct wire_coordinate<Fq2T>
+{
+    static size_t size() { return 2 * wire_field_size; }
+
+    static void write( const Fq2T &x, uint8_t *out )
+    {
+        wire_write_field(x.c1, out);
+        wire_write_field(x.c0, out + wire_field_size);
+    }
+
+    static bool read( const uint8_t *in, Fq2T &x, uint8_t first_mask )
+    {
+        return wire_read_field(in, x.c1, first_mask) && wire_read_field(in + wire_field_size, x.c0);
+    }
+};
+
+
+template<typename T>
+size_t wire_point_size( bool compressed )
+{
+    typedef typename std::decay<decltype(T::one().X)>::type CoordT;
+
+    return (compressed ? 1 : 2) * wire_coordinate<CoordT>::size();
+}
+
+
+template<typename T>
+void wire_write_point( const T &point, bool compressed, std::vector<uint8_t> &out )
+{
+    typedef typename std::decay<decltype(point.X)>::type CoordT;
+
+    const size_t offset = out.size();
+    out.resize(offset + wire_point_size<T>(compressed), 0);
+    uint8_t *dest = &out[offset];
+
+    if( point.is_zero() )
+    {
+        if( compressed ) {
+            dest[0] = wire_point_infinity;
+        }
+        return;
+    }
+
+    T affine = point;
+    affine.to_affine_coordinates();
+    wire_coordinate<CoordT>::write(affine.X, dest);
+
+    if( compressed )
+    {
+        if( libsnark::flat_coordinate_is_odd(affine.Y) ) {
+            dest[0] |= wire_point_odd_y;
+        }
+    }
+    else {
+        wire_coordinate<CoordT>::write(affine.Y, dest + wire_coordinate<CoordT>::size());
+    }
+}
+
+
+/**
+* Reads a point at `in`, advancing it. Compressed points have y recovered
+* from the curve equation, others must satisfy it.
+*/
+template<typename T>
+bool wire_read_point( const uint8_t *&in, const uint8_t *end, bool compressed, T &point )
+{
+    typedef typename std::decay<decltype(point.X)>::type CoordT;
+
+    const size_t point_size = wire_point_size<T>(compressed);
+    if( size_t(end - in) < point_size ) {
+        return false;
+    }
+    const uint8_t *src = in;
+    in += point_size;
+
+    CoordT x;
+    CoordT y;
+
+    if( ! compressed )
+    {
+        if( std::all_of(src, src + point_size, [](uint8_t byte) { return byte == 0; }) )
+        {
+            point = T::zero();
+            return true;
+        }
+
+        if( ! wire_coordinate<CoordT>::read(src, x, 0xFF)
+         || ! wire_coordinate<CoordT>::read(src + wire_coordinate<CoordT>::size(), y, 0xFF) ) {
+            return false;
+        }
+
+        point = T(x, y, CoordT::one());
+        return point.is_well_formed();
+    }
+
+    const uint8_t flags = src[0] & (wire_point_odd_y | wire_point_infinity);
+    if( ! wire_coordinate<CoordT>::read(src, x, uint8_t(~(wire_point_odd_y | wire_point_infinity))) ) {
+        return false;
+    }
+
+    if( flags & wire_point_infinity )
+    {
+        point = T::zero();
+        return flags == wire_point_infinity && x.is_zero();
+    }
+
+    // sqrt doesn't terminate for non-residues, so check first
+    const CoordT rhs = x.squared() * x + T::coeff_a * x + T::coeff_b;
+    if( ! wire_is_square(rhs) ) {
+        return false;
+    }
+
+    const bool odd_y = (flags & wire_point_odd_y) != 0;
+    y = rhs.sqrt();
+    if( libsnark::flat_coordinate_is_odd(y) != odd_y ) {
+        y = -y;
+    }
+
+    point = T(x, y, CoordT::one());
+    return libsnark::flat_coordinate_is_odd(y) == odd_y;
+}
+
+
+void wire_write_flags( int flags, std::vector<uint8_t> &out )
+{
+    out.push_back(uint8_t(flags & WIRE_COMPRESSED));
+}
+
+
+bool wire_read_flags( const uint8_t *&in, const uint8_t *end, bool &compressed )
+{
+    if( in == end || (in[0] & ~WIRE_COMPRESSED) != 0 ) {
+        return false;
+    }
+
+    compressed = (in[0] & WIRE_COMPRESSED) != 0;
+    in += 1;
+    return true;
+}
+
+
+void wire_write_count( size_t count, std::vector<uint8_t> &out )
+{
+    if( count > UINT32_MAX ) {
+        throw std::length_error("Too many elements for the wire format");
+    }
+
+    for( size_t i = wire_count_size; i-- > 0; )
+    {
+        out.push_back(uint8_t(count >> (i * 8)));
+    }
+}
+
+
+/**
+* Reads the length prefix of the list which ends the encoding, it must
+* account for exactly the remaining bytes
+*/
+bool wire_read_count( const uint8_t *&in, const uint8_t *end, size_t element_size, size_t &count )
+{
+    if( size_t(end - in) < wire_count_size ) {
+        return false;
+    }
+
+    count = 0;
+    for( size_t i = 0; i < wire_count_size; i++ )
+    {
+        count = (count << 8) | in[i];
+    }
+    in += wire_count_size;
+
+    return size_t(end - in) / element_size == count && size_t(end - in) % element_size == 0;
+}
+
+// anonymous namespace
+}
+
+
+std::vector<uint8_t> proof_to_wire( const ProofT &proof, const PrimaryInputT &input, int flags )
+{
+    const bool compressed = (flags & WIRE_COMPRESSED) != 0;
+
+    std::vector<uint8_t> out;
+    out.reserve(1 + (2 * wire_point_size<G1T>(compressed)) + wire_point_size<G2T>(compressed)
+                + wire_count_size + (input.size() * wire_field_size));
+
+    wire_write_flags(flags, out);
+    wire_write_point(proof.g_A, compressed, out);
+    wire_write_point(proof.g_B, compressed, out);
+    wire_write_point(proof.g_C, compressed, out);
+
+    wire_write_count(input.size(), out);
+    for( const auto &value : input )
+    {
+        out.resize(out.size() + wire_field_size);
+        wire_write_field(value, &out[out.size() - wire_field_size]);
+    }
+
+    return out;
+}
+
+
+bool proof_from_wire( const uint8_t *data, size_t size, InputProofPairType &out )
+{
+    const uint8_t *end = data + size;
+    bool compressed = false;
+    size_t n_inputs = 0;
+    G1T g_A;
+    G2T g_B;
+    G1T g_C;
+
+    if( ! wire_read_flags(data, end, compressed)
+     || ! wire_read_point(data, end, compressed, g_A)
+     || ! wire_read_point(data, end, compressed, g_B)
+     || ! wire_read_point(data, end, compressed, g_C)
+     || ! wire_read_count(data, end, wire_field_size, n_inputs) ) {
+        return false;
+    }
+
+    PrimaryInputT input(n_inputs);
+    for( auto &value : input )
+    {
+        if( ! wire_read_field(data, value) ) {
+            return false;
+        }
+        data += wire_field_size;
+    }
+
+    out = InputProofPairType(std::move(input), ProofT(std::move(g_A), std::move(g_B), std::move(g_C)));
+    return true;
+}
+
+
+std::vector<uint8_t> vk_to_wire( const VerificationKeyT &vk, int flags )
+{
+    const bool compressed = (flags & WIRE_COMPRESSED) != 0;
+    const size_t n_gamma_ABC = 1 + vk.gamma_ABC_g1.rest.domain_size();
+
+    std::vector<uint8_t> out;
+    out.reserve(1 + ((1 + n_gamma_ABC) * wire_point_size<G1T>(compressed)) + (3 * wire_point_size<G2T>(compressed))
+                + wire_count_size);
+
+    wire_write_flags(flags, out);
+    wire_write_point(vk.alpha_g1, compressed, out);
+    wire_write_point(vk.beta_g2, compressed, out);
+    wire_write_point(vk.gamma_g2, compressed, out);
+    wire_write_point(vk.delta_g2, compressed, out);
+
+    // the accumulation vector's rest is sparse, missing entries are zero
+    wire_write_count(n_gamma_ABC, out);
+    wire_write_point(vk.gamma_ABC_g1.first, compressed, out);
+    for( size_t i = 1; i < n_gamma_ABC; i++ )
+    {
+        wire_write_point(vk.gamma_ABC_g1.rest[i - 1], compressed, out);
+    }
+
+    return out;
+}
+
+
+bool vk_from_wire( const uint8_t *data, size_t size, VerificationKeyT &out )
+{
+    const uint8_t *end = data + size;
+    bool compressed = false;
+    size_t n_gamma_ABC = 0;
+    G1T alpha_g1;
+    G2T beta_g2;
+    G2T gamma_g2;
+    G2T delta_g2;
+
+    if( ! wire_read_flags(data, end, compressed)
+     || ! wire_read_point(data, end, compressed, alpha_g1)
+     || ! wire_read_point(data, end, compressed, beta_g2)
+     || ! wire_read_point(data, end, compressed, gamma_g2)
+     || ! wire_read_point(data, end, compressed, delta_g2)
+     || ! wire_read_count(data, end, wire_point_size<G1T>(compressed), n_gamma_ABC)
+     || n_gamma_ABC == 0 ) {
+        return false;
+    }
+
+    G1T gamma_ABC_first;
+    std::vector<G1T> gamma_ABC_rest(n_gamma_ABC - 1);
+    if( ! wire_read_point(data, end, compressed, gamma_ABC_first) ) {
+        return false;
+    }
+    for( auto &point : gamma_ABC_rest )
+    {
+        if( ! wire_read_point(data, end, compressed, point) ) {
+            return false;
+        }
+    }
+
+    out = VerificationKeyT(
+        alpha_g1,
+        beta_g2,
+        gamma_g2,
+        delta_g2,
+        libsnark::accumulation_vector<G1T>(std::move(gamma_ABC_first), std::move(gamma_ABC_rest)));
+
+    return true;
+}
+
+// ethsnarks
+}
@@ -0,0 +1,45 @@
+#ifndef ETHSNARKS_WIRE_FORMAT_HPP_
+#define ETHSNARKS_WIRE_FORMAT_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "ethsnarks.hpp"
+#include "import.hpp"
+
+namespace ethsnarks {
+
+
+/**
+* Compact binary encoding of proofs and verifying keys, an alternative to
+* the JSON form which avoids the hex strings and mpz conversions.
+*
+* Every coordinate is a 32 byte big-endian integer, G2 coordinates are c1
+* then c0, as in the JSON and Ethereum's precompiles. A point is x then y,
+* all zeros for infinity, or with WIRE_COMPRESSED only x, where the top
+* bits of its first byte flag infinity and the parity of y.
+*
+*   proof: flags(1) | A(G1) | B(G2) | C(G1) | n(4, big-endian) | n inputs
+*   vk:    flags(1) | alpha(G1) | beta(G2) | gamma(G2) | delta(G2) | n(4) | n gammaABC(G1)
+*
+* The parsers decode directly from the buffer, and reject trailing bytes,
+* unknown flags, coordinates not below the modulus and points which aren't
+* on the curve.
+*/
+enum wire_format_flags {
+    WIRE_COMPRESSED = 1
+};
+
+std::vector<uint8_t> proof_to_wire( const ProofT &proof, const PrimaryInputT &input, int flags = 0 );
+
+bool proof_from_wire( const uint8_t *data, size_t size, InputProofPairType &out );
+
+std::vector<uint8_t> vk_to_wire( const VerificationKeyT &vk, int flags = 0 );
+
+bool vk_from_wire( const uint8_t *data, size_t size, VerificationKeyT &out );
+
+// ethsnarks
+}
+
+// ETHSNARKS_WIRE_FORMAT_HPP_
+#endif
@@ -3,7 +3,7 @@ import json
 import time
 import random
 
-from ethsnarks.verifier import VerifyingKey, Proof, NativeVerifier
+from ethsnarks.verifier import VerifyingKey, Proof, NativeVerifier, NativeVerifyPool
 from ethsnarks.utils import native_lib_path
 
 
@@ -25,6 +25,29 @@ class VerifyTests(unittest.TestCase):
         proof = Proof.from_dict(PROOF_STATIC)
         dll_path = native_lib_path('build/src/libethsnarks_verify')
         self.assertTrue(vk.verify(proof, dll_path))
+        # Again with the key the library processed for the first call
+        self.assertTrue(vk.verify(proof, dll_path))
+
+    def test_verify_batch_native(self):
+        vk = NativeVerifier.from_dict(VK_STATIC)
+        proof = Proof.from_dict(PROOF_STATIC)
+        dll_path = native_lib_path('build/src/libethsnarks_verify')
+        self.assertTrue(vk.verify_batch([proof, proof, proof], dll_path))
+
+        bad_input = dict(PROOF_STATIC, input=PROOF_STATIC['input'][:-1] + ['0x8'])
+        self.assertFalse(vk.verify_batch([proof, Proof.from_dict(bad_input)], dll_path))
+
+    def test_verify_pool_native(self):
+        vk = VerifyingKey.from_dict(VK_STATIC)
+        proof = Proof.from_dict(PROOF_STATIC)
+        bad_proof = Proof.from_dict(dict(PROOF_STATIC, input=PROOF_STATIC['input'][:-1] + ['0x8']))
+        pool = NativeVerifyPool(native_lib_path('build/src/libethsnarks_verify'), num_workers=2)
+        pool.add_key('static', vk)
+
+        good_job = pool.submit('static', [proof, proof])
+        bad_job = pool.submit('static', [proof, bad_proof])
+        self.assertEqual(pool.wait(good_job), [True, True])
+        self.assertEqual(pool.wait(bad_job), [True, False])
 
     def test_verify_python(self):
         # Verify using sloooow python implementation